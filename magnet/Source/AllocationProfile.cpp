@@ -0,0 +1,74 @@
+#include "AllocationProfile.h"
+
+namespace MG
+{
+	AllocationProfile AllocationProfile::Load(const std::filesystem::path& path)
+	{
+		AllocationProfile profile;
+
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string kind;
+			stream >> kind;
+
+			if (kind == "totals")
+			{
+				profile.isValid = static_cast<bool>(stream >> profile.allocations >> profile.frees >>
+				                                    profile.allocatedBytes >> profile.peakBytes >> profile.liveBytes >>
+				                                    profile.sampleBytes);
+			} else if (kind == "dropped")
+			{
+				stream >> profile.droppedSamples;
+			} else if (kind == "timeline")
+			{
+				HeapSnapshot snapshot;
+				if (stream >> snapshot.time >> snapshot.liveBytes >> snapshot.peakBytes)
+					profile.timeline.push_back(snapshot);
+			} else if (kind == "stack")
+			{
+				AllocationSite site;
+				if (!(stream >> site.count >> site.bytes))
+					continue;
+
+				uint64_t frame = 0;
+				while (stream >> std::hex >> frame)
+					site.frames.push_back(frame);
+
+				profile.sites.push_back(std::move(site));
+			} else if (kind == "exe")
+			{
+				stream >> std::ws;
+				std::string executable;
+				std::getline(stream, executable);
+				profile.executable = executable;
+			} else if (kind == "maps")
+			{
+				break;
+			}
+		}
+
+		// The rest is a copy of /proc/<pid>/maps: `<start>-<end> <permissions> <offset> <device> <inode> <path>`.
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			MappedFile mapping;
+			char separator = 0;
+			std::string permissions;
+			std::string device;
+			uint64_t inode = 0;
+
+			if (!(stream >> std::hex >> mapping.start >> separator >> mapping.end >> permissions >> mapping.offset >>
+			             device >> std::dec >> inode) || permissions.find('x') == std::string::npos)
+				continue;
+
+			stream >> std::ws;
+			std::getline(stream, mapping.path);
+			profile.mappings.push_back(mapping);
+		}
+
+		return profile;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Platform/Platform.h"
+
+namespace MG
+{
+	// Call stack of sampled allocations, with the estimated number and size of all allocations it stands for.
+	struct AllocationSite
+	{
+		uint64_t count = 0;
+		uint64_t bytes = 0;
+
+		// Return addresses, innermost first.
+		std::vector<uint64_t> frames;
+	};
+
+	// Live heap size at a point in time, in milliseconds since the start of the process.
+	struct HeapSnapshot
+	{
+		uint64_t time = 0;
+		int64_t liveBytes = 0;
+
+		// Highest live heap size since the previous snapshot.
+		int64_t peakBytes = 0;
+	};
+
+	// Reads the report written by magnet-alloc-shim when a process exits.
+	struct AllocationProfile
+	{
+		// Returns a profile with isValid set to false if the report is missing or incomplete.
+		static AllocationProfile Load(const std::filesystem::path& path);
+
+		bool isValid = false;
+
+		uint64_t allocations = 0;
+		uint64_t frees = 0;
+		uint64_t allocatedBytes = 0;
+		int64_t peakBytes = 0;
+
+		// Heap size when the report was written, i.e. after static destructors of the project.
+		int64_t liveBytes = 0;
+
+		// On average, one allocation is sampled per this many allocated bytes.
+		uint64_t sampleBytes = 0;
+		uint64_t droppedSamples = 0;
+
+		std::filesystem::path executable;
+		std::vector<AllocationSite> sites;
+		std::vector<HeapSnapshot> timeline;
+
+		// Executable mappings of the process, to symbolize the sites.
+		std::vector<MappedFile> mappings;
+	};
+}
@@ -0,0 +1,60 @@
+#include "Allocator.h"
+
+namespace MG
+{
+	static const std::vector<Allocator> s_Allocators = {
+			{
+					"mimalloc", "microsoft/mimalloc", "mimalloc", "mimalloc-static",
+					{{"MI_OVERRIDE", "ON"}, {"MI_BUILD_SHARED", "OFF"}, {"MI_BUILD_OBJECT", "OFF"},
+					 {"MI_BUILD_TESTS", "OFF"}},
+					{}, "", "", {}
+			},
+			{
+					// On Linux, jemalloc doesn't prefix its functions, so it replaces malloc. On macOS, it becomes the default zone.
+					"jemalloc", "jemalloc/jemalloc", "jemalloc", "jemalloc",
+					{},
+					{"sh -c \"cd <SOURCE_DIR> && autoconf\"", "<SOURCE_DIR>/configure"},
+					"make build_lib_static", "lib/libjemalloc.a",
+					{"${CMAKE_THREAD_LIBS_INIT}", "${CMAKE_DL_LIBS}", "m"}
+			},
+			{
+					// The minimal build leaves out the heap profiler and checker, which aren't needed for speed.
+					"tcmalloc", "gperftools/gperftools", "gperftools", "tcmalloc",
+					{},
+					{"sh -c \"cd <SOURCE_DIR> && ./autogen.sh\"",
+					 "<SOURCE_DIR>/configure --enable-minimal --disable-shared --disable-dependency-tracking"},
+					"make libtcmalloc_minimal.la", ".libs/libtcmalloc_minimal.a",
+					{"${CMAKE_THREAD_LIBS_INIT}"}
+			},
+	};
+
+	bool Allocator::HasCmakeProject() const
+	{
+		return configureCommands.empty();
+	}
+
+	const Allocator* Allocator::Find(const std::string& name)
+	{
+		auto it = std::find_if(s_Allocators.begin(), s_Allocators.end(), [&name](const Allocator& allocator)
+		{
+			return allocator.name == name;
+		});
+
+		return it != s_Allocators.end() ? &*it : nullptr;
+	}
+
+	const Allocator* Allocator::FindByDependency(const std::string& dependency)
+	{
+		auto it = std::find_if(s_Allocators.begin(), s_Allocators.end(), [&dependency](const Allocator& allocator)
+		{
+			return allocator.dependency == dependency;
+		});
+
+		return it != s_Allocators.end() ? &*it : nullptr;
+	}
+
+	const std::vector<Allocator>& Allocator::GetAll()
+	{
+		return s_Allocators;
+	}
+}
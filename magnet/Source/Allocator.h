@@ -0,0 +1,53 @@
+#pragma once
+
+namespace MG
+{
+	// A general purpose allocator that generated projects can link into their executables instead of the system
+	// allocator. It is installed like any other dependency, with `magnet pull <name>`.
+	struct Allocator
+	{
+		// The name used under `allocators` in config.yaml and by `magnet bench --allocators`.
+		std::string name;
+
+		// The repository `magnet pull <name>` installs, in GitHub's shorthand notation.
+		std::string repository;
+
+		// The folder inside of Dependencies it is installed into.
+		std::string dependency;
+
+		// The static library target that is linked as a whole, so that its malloc and operator new take
+		// precedence over those of the system.
+		std::string target;
+
+		// Cache variables that are set before adding an allocator with a CMake project, e.g. to skip its tests.
+		std::vector<std::pair<std::string, std::string>> options;
+
+		// Allocators without a CMake project are built with autotools in an external project, which runs these
+		// commands in its build folder. <SOURCE_DIR> is replaced with the dependency's folder.
+		// Both are empty for allocators with a CMake project.
+		std::vector<std::string> configureCommands;
+		std::string buildCommand;
+
+		// The static library the external project produces, relative to its build folder.
+		std::string libraryPath;
+
+		// System libraries the static library needs, e.g. for threads.
+		std::vector<std::string> libraries;
+
+		// Returns whether the allocator is built by its own CMake project.
+		[[nodiscard]] bool HasCmakeProject() const;
+
+		// Returns the allocator with the given name, or nullptr if Magnet doesn't know it.
+		static const Allocator* Find(const std::string& name);
+
+		// Returns the allocator installed into the given Dependencies folder, or nullptr if it's a regular
+		// dependency.
+		static const Allocator* FindByDependency(const std::string& dependency);
+
+		// Returns every allocator Magnet can link.
+		static const std::vector<Allocator>& GetAll();
+
+		// The name that stands for the allocator of the system, e.g. to compare others against it.
+		static inline constexpr const char* s_SystemName = "system";
+	};
+}
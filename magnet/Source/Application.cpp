@@ -4,24 +4,31 @@
 
 #include "CommandHandler.h"
 #include "Core.h"
+#include "Event.h"
 #include "Platform/Platform.h"
 #include "Project.h"
+#include "Timings.h"
 
 namespace MG
 {
 	// Map commands to Handler functions.
 	static const std::unordered_map<std::string, void (*)(const CommandHandlerProps&)> m_Commands = {
-			{"help",     CommandHandler::HandleHelpCommand},
-			{"version",  CommandHandler::HandleVersionCommand},
-			{"config",   CommandHandler::HandleConfigCommand},
-			{"new",      CommandHandler::HandleNewCommand},
-			{"generate", CommandHandler::HandleGenerateCommand},
-			{"build",    CommandHandler::HandleBuildCommand},
-			{"go",       CommandHandler::HandleGoCommand},
-			{"clean",    CommandHandler::HandleCleanCommand},
-			{"pull",     CommandHandler::HandlePullCommand},
-			{"remove",   CommandHandler::HandleRemoveCommand},
-			{"switch",   CommandHandler::HandleSwitchCommand},
+			{"help",        CommandHandler::HandleHelpCommand},
+			{"version",     CommandHandler::HandleVersionCommand},
+			{"config",      CommandHandler::HandleConfigCommand},
+			{"new",         CommandHandler::HandleNewCommand},
+			{"generate",    CommandHandler::HandleGenerateCommand},
+			{"build",       CommandHandler::HandleBuildCommand},
+			{"go",          CommandHandler::HandleGoCommand},
+			{"test",        CommandHandler::HandleTestCommand},
+			{"bench",       CommandHandler::HandleBenchCommand},
+			{"bisect-perf", CommandHandler::HandleBisectPerfCommand},
+			{"profile",     CommandHandler::HandleProfileCommand},
+			{"size",        CommandHandler::HandleSizeCommand},
+			{"clean",       CommandHandler::HandleCleanCommand},
+			{"pull",        CommandHandler::HandlePullCommand},
+			{"remove",      CommandHandler::HandleRemoveCommand},
+			{"switch",      CommandHandler::HandleSwitchCommand},
 	};
 
 	static const std::unordered_map<std::string, std::string> m_SimilarCommands = {
@@ -31,6 +38,15 @@ namespace MG
 			{"launch",    "go"},
 			{"start",     "go"},
 			{"clear",     "clean"},
+			{"tests",     "test"},
+			{"check",     "test"},
+			{"benchmark", "bench"},
+			{"perf",      "bench"},
+			{"bisect",    "bisect-perf"},
+			{"prof",      "profile"},
+			{"record",    "profile"},
+			{"bloat",     "size"},
+			{"bloaty",    "size"},
 			{"rm",        "remove"},
 			{"change",    "switch"},
 			{"swap",      "switch"},
@@ -54,6 +70,12 @@ namespace MG
 		if (message.empty())
 			return;
 
+		if (Event::IsJsonOutputEnabled())
+		{
+			Event("message").AddString("host", host).AddString("text", message).Emit();
+			return;
+		}
+
 		if (host.empty())
 		{
 			std::cout << message << "\n";
@@ -65,6 +87,12 @@ namespace MG
 
 	void Application::PrintPrompt()
 	{
+		if (Event::IsJsonOutputEnabled())
+		{
+			Event("prompt").Emit();
+			return;
+		}
+
 		std::cout << "> ";
 	}
 
@@ -102,9 +130,35 @@ namespace MG
 			skipCounter = (int) nextArguments.size();
 
 			CommandHandlerProps props;
+			props.nextArguments = nextArguments;
+
+			std::string output = props.GetFlagValue("--output");
+			if (output == "json" && !Event::IsJsonOutputEnabled())
+			{
+				std::FILE* stream = Platform::SeparateStandardOutput();
+				if (!stream)
+				{
+					MG_LOG("Couldn't separate the JSON output from the standard output.");
+					break;
+				}
+
+				Event::EnableJsonOutput(stream);
+			} else if (props.HasFlag("--output") && output != "json" && output != "text")
+			{
+				MG_LOG("Usage: magnet <command> --output [text/json]");
+				break;
+			}
+
+			// JSON output reports the phases as events, so they're timed, too.
+			std::string tracePath = props.GetFlagValue("--timings-trace");
+			bool isTimed = props.HasFlag("--timings") || !tracePath.empty();
+			if (isTimed || Event::IsJsonOutputEnabled())
+				Timings::Enable();
+
+			Timings::Scope configTiming("Load config");
 			auto project = CreateConfiguredProject();
 			props.project = &project;
-			props.nextArguments = nextArguments;
+			configTiming.Stop();
 
 			bool commandExists = m_Commands.find(argument) != m_Commands.end();
 			if (commandExists)
@@ -115,7 +169,27 @@ namespace MG
 					break;
 				}
 
+				Event("start").AddString("command", argument).AddList("arguments", props.nextArguments).Emit();
+				double commandStart = Timings::GetTime();
+
+				Timings::Scope commandTiming("magnet " + argument);
 				m_Commands.at(argument)(props);
+				commandTiming.Stop();
+
+				Event("end").AddString("command", argument)
+				            .AddNumber("duration_ms", (Timings::GetTime() - commandStart) / 1000.0).Emit();
+
+				if (isTimed)
+					Timings::PrintSummary();
+				if (!tracePath.empty())
+				{
+					if (Timings::WriteChromeTrace(tracePath))
+						MG_LOG("Wrote the timings to " + tracePath + ". Open it in https://ui.perfetto.dev or "
+						       "chrome://tracing.");
+					else
+						MG_LOG("Failed to write " + tracePath + ".");
+				}
+
 				continue;
 			}
 
@@ -131,6 +205,14 @@ namespace MG
 		return std::filesystem::current_path();
 	}
 
+	std::string Application::GetExecutableName()
+	{
+		if (m_Arguments.count == 0)
+			return "magnet";
+
+		return std::filesystem::path(m_Arguments.list[0]).filename().string();
+	}
+
 	std::string Application::GetProjectName()
 	{
 		if (!IsRootLevel())
@@ -195,6 +277,309 @@ namespace MG
 		SetYamlString(s_ConfigPath, "defaultConfiguration", configuration.ToString());
 	}
 
+	int Application::GetCompileMemory()
+	{
+		if (!IsRootLevel())
+			return -1;
+
+		return GetYamlInt(s_ConfigPath, "compileMemory");
+	}
+
+	int Application::GetLinkMemory()
+	{
+		if (!IsRootLevel())
+			return -1;
+
+		return GetYamlInt(s_ConfigPath, "linkMemory");
+	}
+
+	int Application::GetLearnedCompileMemory()
+	{
+		if (!IsRootLevel() || !std::filesystem::exists(s_BuildStatsPath))
+			return -1;
+
+		return GetYamlInt(s_BuildStatsPath, "compileMemory");
+	}
+
+	void Application::SetLearnedCompileMemory(int megabytes)
+	{
+		if (!IsRootLevel())
+			return;
+
+		CreateFileIfMissing(s_BuildStatsPath);
+		SetYamlInt(s_BuildStatsPath, "compileMemory", megabytes);
+	}
+
+	std::string Application::GetGenerateFingerprint(const std::filesystem::path& buildPath)
+	{
+		if (!IsRootLevel() || !std::filesystem::exists(s_BuildStatsPath))
+			return "";
+
+		YAML::Node fingerprints = YAML::LoadFile(s_BuildStatsPath)["generateFingerprints"];
+		if (!fingerprints)
+			return "";
+
+		auto node = fingerprints[buildPath.generic_string()];
+		if (node)
+			return node.as<std::string>();
+
+		return "";
+	}
+
+	void Application::SetGenerateFingerprint(const std::filesystem::path& buildPath, const std::string& fingerprint)
+	{
+		if (!IsRootLevel())
+			return;
+
+		CreateFileIfMissing(s_BuildStatsPath);
+
+		// Every build folder (e.g. the one `magnet bench` uses) is generated separately.
+		YAML::Node stats = YAML::LoadFile(s_BuildStatsPath);
+		stats["generateFingerprints"][buildPath.generic_string()] = fingerprint;
+
+		std::ofstream file(s_BuildStatsPath);
+		file << stats;
+		file.close();
+	}
+
+	bool Application::IsCompilerLauncherEnabled()
+	{
+		if (!IsRootLevel())
+			return false;
+
+		return GetYamlBool(s_ConfigPath, "compilerLauncher", true);
+	}
+
+	bool Application::IsObjectLibrariesEnabled()
+	{
+		if (!IsRootLevel())
+			return false;
+
+		return GetYamlBool(s_ConfigPath, "objectLibraries", false);
+	}
+
+	std::string Application::GetBackend()
+	{
+		if (!IsRootLevel())
+			return "cmake";
+
+		std::string backend = GetYamlString(s_ConfigPath, "backend");
+		return backend.empty() ? "cmake" : backend;
+	}
+
+	std::vector<Target> Application::GetTargets()
+	{
+		if (!IsRootLevel())
+			return {};
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["targets"];
+		if (!node || !node.IsSequence())
+			return {};
+
+		std::vector<Target> targets;
+		for (const auto& targetNode : node)
+		{
+			Target target;
+			target.name = targetNode["name"].as<std::string>("");
+			if (target.name.empty())
+			{
+				MG_LOG("Skipping a target without a name in config.yaml.");
+				continue;
+			}
+
+			if (targetNode["type"])
+				target.SetType(targetNode["type"].as<std::string>());
+
+			// By convention, a target's sources live in a Source subfolder named after it.
+			if (targetNode["sources"])
+				target.sources = targetNode["sources"].as<std::vector<std::string>>();
+			else
+				target.sources = {target.name + "/**"};
+
+			if (targetNode["links"])
+				target.links = targetNode["links"].as<std::vector<std::string>>();
+
+			targets.push_back(target);
+		}
+
+		return targets;
+	}
+
+	std::vector<std::vector<std::string>> Application::GetCounterGroups()
+	{
+		if (!IsRootLevel())
+			return {};
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["counters"];
+		if (!node || !node.IsSequence())
+			return {};
+
+		std::vector<std::vector<std::string>> groups;
+		for (const auto& group : node)
+		{
+			// A single event forms a group of its own.
+			if (group.IsSequence())
+				groups.push_back(group.as<std::vector<std::string>>());
+			else
+				groups.push_back({group.as<std::string>()});
+		}
+
+		return groups;
+	}
+
+	std::map<std::string, std::string> Application::GetAllocators()
+	{
+		if (!IsRootLevel())
+			return {};
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["allocators"];
+		if (!node || !node.IsMap())
+			return {};
+
+		std::map<std::string, std::string> allocators;
+		for (const auto& allocator : node)
+		{
+			Configuration configuration = Configuration::FromString(allocator.first.as<std::string>());
+			if (!configuration.IsValid())
+			{
+				MG_LOG("Skipping the allocator of unknown configuration `" + allocator.first.as<std::string>() +
+				       "` in config.yaml.");
+				continue;
+			}
+
+			allocators[configuration.ToString()] = allocator.second.as<std::string>();
+		}
+
+		return allocators;
+	}
+
+	std::vector<std::string> Application::GetTracingConfigurations()
+	{
+		if (!IsRootLevel())
+			return {};
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["tracing"];
+		if (!node || !node.IsSequence())
+			return {};
+
+		std::vector<std::string> configurations;
+		for (const auto& name : node)
+		{
+			Configuration configuration = Configuration::FromString(name.as<std::string>());
+			if (!configuration.IsValid())
+			{
+				MG_LOG("Skipping unknown configuration `" + name.as<std::string>() +
+				       "` under tracing in config.yaml.");
+				continue;
+			}
+
+			configurations.push_back(configuration.ToString());
+		}
+
+		return configurations;
+	}
+
+	BuildBudgets Application::GetBuildBudgets()
+	{
+		BuildBudgets budgets;
+		if (!IsRootLevel())
+			return budgets;
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["budgets"];
+		if (!node || !node.IsMap())
+			return budgets;
+
+		const std::array<std::pair<const char*, double*>, 4> limits = {{
+				{"compileSeconds",        &budgets.compileSeconds},
+				{"preprocessedMegabytes", &budgets.preprocessedMegabytes},
+				{"totalCompileSeconds",   &budgets.totalCompileSeconds},
+				{"binaryMegabytes",       &budgets.binaryMegabytes},
+		}};
+
+		for (const auto& budget : node)
+		{
+			std::string key = budget.first.as<std::string>();
+			if (key == "enforce")
+			{
+				budgets.isEnforced = budget.second.as<bool>(true);
+				continue;
+			}
+
+			auto limit = std::find_if(limits.begin(), limits.end(), [&key](const auto& limit)
+			{
+				return key == limit.first;
+			});
+
+			double value = budget.second.as<double>(-1.0);
+			if (limit == limits.end() || value < 0.0)
+			{
+				MG_LOG("Skipping unknown budget `" + key + "` in config.yaml.");
+				continue;
+			}
+
+			*limit->second = value;
+		}
+
+		return budgets;
+	}
+
+	SharedLibraryOptimizations Application::GetSharedLibraryOptimizations()
+	{
+		SharedLibraryOptimizations optimizations;
+		if (!IsRootLevel())
+			return optimizations;
+
+		YAML::Node config = YAML::LoadFile(s_ConfigPath);
+		auto node = config["sharedLibOptimizations"];
+		if (!node)
+			return optimizations;
+
+		if (!node.IsMap())
+		{
+			optimizations.isEnabled = node.as<bool>(false);
+			return optimizations;
+		}
+
+		optimizations.isEnabled = true;
+
+		const std::array<std::pair<const char*, bool*>, 5> settings = {{
+				{"hiddenVisibility",  &optimizations.hideSymbols},
+				{"asNeeded",          &optimizations.linkAsNeeded},
+				{"symbolicFunctions", &optimizations.bindFunctionsLocally},
+				{"gnuHash",           &optimizations.useGnuHash},
+				{"bindNow",           &optimizations.bindNow},
+		}};
+
+		// The settings are read for every target, but only warned about once.
+		static std::set<std::string> s_UnknownKeys;
+
+		for (const auto& option : node)
+		{
+			std::string key = option.first.as<std::string>();
+			auto setting = std::find_if(settings.begin(), settings.end(), [&key](const auto& setting)
+			{
+				return key == setting.first;
+			});
+
+			if (setting == settings.end())
+			{
+				if (s_UnknownKeys.insert(key).second)
+					MG_LOG("Skipping unknown option `" + key + "` under sharedLibOptimizations in config.yaml.");
+
+				continue;
+			}
+
+			*setting->second = option.second.as<bool>(*setting->second);
+		}
+
+		return optimizations;
+	}
+
 	std::vector<std::string> Application::GetDependencies()
 	{
 		if (!IsRootLevel())
@@ -254,6 +639,23 @@ namespace MG
 		file.close();
 	}
 
+	void Application::CreateFileIfMissing(const std::string& path)
+	{
+		if (!std::filesystem::exists(path))
+			std::ofstream(path).close();
+	}
+
+	bool Application::GetYamlBool(const std::string& path, const std::string& key, bool defaultValue)
+	{
+		YAML::Node config = YAML::LoadFile(path);
+
+		auto node = config[key];
+		if (node)
+			return node.as<bool>();
+
+		return defaultValue;
+	}
+
 	Project Application::CreateConfiguredProject()
 	{
 		Project project;
@@ -263,6 +665,7 @@ namespace MG
 		project.SetCppVersion(Application::GetCppVersion());
 		project.SetCmakeVersion(Application::GetCmakeVersion());
 		project.SetConfiguration(Configuration::FromString(Application::GetDefaultConfiguration()));
+		project.SetTargets(Application::GetTargets());
 
 		return project;
 	}
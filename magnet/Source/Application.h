@@ -21,6 +21,9 @@ namespace MG
 		static void Run();
 
 		static std::filesystem::path GetCurrentWorkingDirectory();
+
+		// Returns the file name Magnet was started with, so that it can start itself in another folder.
+		static std::string GetExecutableName();
 		static std::string GetProjectName();
 		static std::string GetProjectType();
 		static int GetCppVersion();
@@ -30,6 +33,52 @@ namespace MG
 		static std::string GetDefaultConfiguration();
 		static void SetDefaultConfiguration(const struct Configuration& configuration);
 
+		// Returns the estimated peak memory of a single compile in megabytes, as set in config.yaml.
+		// Returns -1 if it's not set.
+		static int GetCompileMemory();
+
+		// Returns the estimated peak memory of a single link in megabytes, as set in config.yaml.
+		// Returns -1 if it's not set.
+		static int GetLinkMemory();
+
+		// Returns the compile memory estimate in megabytes learned from previous builds.
+		// Returns -1 if nothing has been learned yet.
+		static int GetLearnedCompileMemory();
+		static void SetLearnedCompileMemory(int megabytes);
+
+		// Returns the fingerprint of the inputs used by the last successful generate into the given build folder.
+		static std::string GetGenerateFingerprint(const std::filesystem::path& buildPath);
+		static void SetGenerateFingerprint(const std::filesystem::path& buildPath, const std::string& fingerprint);
+
+		// Returns whether generated projects should wrap compiles and links with magnet-launcher.
+		static bool IsCompilerLauncherEnabled();
+
+		// Returns whether every top-level Source subfolder should become its own OBJECT library.
+		static bool IsObjectLibrariesEnabled();
+
+		// Returns the backend set under `backend` in config.yaml: "cmake" (default), or "ninja" to write a
+		// build.ninja directly instead of configuring with CMake.
+		static std::string GetBackend();
+
+		// Returns the targets declared under `targets` in config.yaml.
+		static std::vector<struct Target> GetTargets();
+
+		// Returns the groups of performance counters declared under `counters` in config.yaml.
+		static std::vector<std::vector<std::string>> GetCounterGroups();
+
+		// Returns the allocator of every configuration declared under `allocators` in config.yaml, keyed by the
+		// configuration, e.g. "Release".
+		static std::map<std::string, std::string> GetAllocators();
+
+		// Returns the configurations declared under `tracing` in config.yaml, in which MagnetTrace.h records events.
+		static std::vector<std::string> GetTracingConfigurations();
+
+		// Returns the limits declared under `budgets` in config.yaml, which are checked after every build.
+		static struct BuildBudgets GetBuildBudgets();
+
+		// Returns the settings declared under `sharedLibOptimizations` in config.yaml, either `true` or a map of them.
+		static struct SharedLibraryOptimizations GetSharedLibraryOptimizations();
+
 		static std::vector<std::string> GetDependencies();
 		static bool IsRootLevel();
 
@@ -40,12 +89,21 @@ namespace MG
 		static int GetYamlInt(const std::string& path, const std::string& key);
 		static void SetYamlInt(const std::string& path, const std::string& key, int value);
 
+		// Creates an empty file for state that is only written lazily, like buildStats.yaml.
+		static void CreateFileIfMissing(const std::string& path);
+
+		static bool GetYamlBool(const std::string& path, const std::string& key, bool defaultValue);
+
 		static class Project CreateConfiguredProject();
 		static void PopulateNextArguments(std::vector<std::string>* arguments, bool hasNext, int startIndex);
 		static bool CheckTypo(const std::string& argument);
 
 		static inline CommandLineArguments m_Arguments;
 		static inline constexpr const char* s_ConfigPath = ".magnet/config.yaml";
+		static inline constexpr const char* s_BuildStatsPath = ".magnet/buildStats.yaml";
+
+		// Times the configuration paths on synthetic projects.
+		friend class SelfBenchmark;
 	};
 }
 
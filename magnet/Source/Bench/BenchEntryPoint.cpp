@@ -0,0 +1,98 @@
+// Self-benchmark of Magnet's generator on synthetic projects:
+//
+//   magnet_bench [--sizes <n,n,...>] [--depth <d>] [--dependencies <n>] [--repetitions <n>] [--json <file>]
+//   magnet_bench --create <folder> [--sizes <n>] [--depth <d>] [--dependencies <n>]
+//
+// The second form only writes a synthetic project, e.g. to time `magnet generate --timings` on it.
+
+#include "Application.h"
+#include "Core.h"
+#include "SelfBenchmark.h"
+
+static bool ParseNumber(const std::string& string, uint32_t& value)
+{
+	std::istringstream stream(string);
+	return (bool) (stream >> value) && stream.eof();
+}
+
+static bool ParseSizes(const std::string& string, std::vector<uint32_t>& sizes)
+{
+	sizes.clear();
+
+	std::istringstream stream(string);
+	std::string size;
+	while (std::getline(stream, size, ','))
+	{
+		uint32_t value = 0;
+		if (!ParseNumber(size, value) || value == 0)
+			return false;
+
+		sizes.push_back(value);
+	}
+
+	return !sizes.empty();
+}
+
+int main(int argc, const char* argv[])
+{
+	using namespace MG;
+
+	auto args = CommandLineArguments();
+	args.count = argc;
+	args.list = argv;
+
+	Application::Initialize(args);
+
+	std::vector<uint32_t> sizes = {10, 100, 1000, 10000, 50000};
+	SyntheticProjectOptions options;
+	uint32_t repetitions = 5;
+	std::string jsonPath;
+	std::string createPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string flag = argv[i];
+		std::string value = i + 1 < argc ? argv[i + 1] : "";
+
+		bool isValid;
+		if (flag == "--sizes")
+			isValid = ParseSizes(value, sizes);
+		else if (flag == "--depth")
+			isValid = ParseNumber(value, options.depth);
+		else if (flag == "--dependencies")
+			isValid = ParseNumber(value, options.dependencyCount);
+		else if (flag == "--repetitions")
+			isValid = ParseNumber(value, repetitions) && repetitions > 0;
+		else if (flag == "--json")
+			isValid = !(jsonPath = value).empty();
+		else if (flag == "--create")
+			isValid = !(createPath = value).empty();
+		else
+			isValid = false;
+
+		if (!isValid)
+		{
+			MG_LOG("Usage: magnet_bench [--sizes <n,n,...>] [--depth <d>] [--dependencies <n>] "
+			       "[--repetitions <n>] [--json <file>] [--create <folder>]");
+			return 1;
+		}
+
+		i++;
+	}
+
+	if (!createPath.empty())
+	{
+		options.fileCount = sizes.front();
+		if (!SelfBenchmark::CreateSyntheticProject(createPath, options))
+		{
+			MG_LOG(createPath + " isn't empty. Choose a new folder for the synthetic project.");
+			return 1;
+		}
+
+		MG_LOG("Created a synthetic project with " + std::to_string(options.fileCount) + " files in " + createPath +
+		       ".");
+		return 0;
+	}
+
+	return SelfBenchmark::Run(sizes, options, repetitions, jsonPath) ? 0 : 1;
+}
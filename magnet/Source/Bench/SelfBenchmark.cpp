@@ -0,0 +1,336 @@
+#include "SelfBenchmark.h"
+
+#include "yaml-cpp/yaml.h"
+
+#include "Application.h"
+#include "CmakeEmitter.h"
+#include "CommandHandler.h"
+#include "Core.h"
+#include "JsonWriter.h"
+#include "Project.h"
+#include "SourceScanner.h"
+#include "Statistics.h"
+
+namespace MG
+{
+	static constexpr const char* s_SyntheticProjectName = "Synthetic";
+	static constexpr uint32_t s_FolderFanout = 8;
+
+	// The same files and index that `magnet generate` scans.
+	static const std::vector<std::string> s_SourceExtensions = {".cpp", ".h", ".hpp"};
+	static constexpr const char* s_SourceIndexPath = ".magnet/sourceIndex";
+
+	static std::string FormatMilliseconds(double nanoseconds)
+	{
+		double milliseconds = nanoseconds / 1e6;
+
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(milliseconds < 10.0 ? 3 : 1) << milliseconds << " ms";
+		return stream.str();
+	}
+
+	bool SelfBenchmark::CreateSyntheticProject(const std::filesystem::path& root,
+	                                           const SyntheticProjectOptions& options)
+	{
+		std::error_code error;
+		if (std::filesystem::exists(root) && !std::filesystem::is_empty(root, error))
+			return false;
+
+		std::filesystem::create_directories(root / ".magnet");
+
+		std::ofstream(root / ".magnet" / "config.yaml") << "name: " << s_SyntheticProjectName << "\n"
+		                                                 << "projectType: Executable\n"
+		                                                 << "cppVersion: 17\n"
+		                                                 << "cmakeVersion: 3.20\n"
+		                                                 << "defaultConfiguration: Debug\n";
+
+		std::filesystem::path projectPath = root / s_SyntheticProjectName;
+
+		std::ofstream dependencies(root / ".magnet" / "dependencies.yaml");
+		dependencies << "dependencies:\n";
+		for (uint32_t i = 0; i < options.dependencyCount; i++)
+		{
+			std::string name = "dependency" + std::to_string(i);
+			dependencies << "  - " << name << "\n";
+
+			std::filesystem::path includePath = projectPath / "Dependencies" / name / "include";
+			std::filesystem::create_directories(includePath);
+			std::ofstream(includePath / (name + ".h")) << "#pragma once\n";
+		}
+
+		// Folders are filled breadth first, so small projects stay shallow and large ones reach the full depth.
+		std::vector<std::string> folders = {""};
+		for (size_t i = 0; i < folders.size(); i++)
+		{
+			if ((uint32_t) std::count(folders[i].begin(), folders[i].end(), '/') >= options.depth)
+				break;
+
+			for (uint32_t j = 0; j < s_FolderFanout; j++)
+				folders.push_back(folders[i] + "module" + std::to_string(j) + "/");
+		}
+
+		std::filesystem::path sourcePath = projectPath / "Source";
+		std::filesystem::create_directories(sourcePath);
+		std::ofstream(sourcePath / "main.cpp") << "int main()\n{\n\treturn 0;\n}\n";
+
+		for (uint32_t i = 1; i < options.fileCount; i++)
+		{
+			std::filesystem::path folder = sourcePath / folders[i % folders.size()];
+			std::filesystem::create_directories(folder);
+
+			std::string name = "File" + std::to_string(i);
+			if (i % 2 == 0)
+				std::ofstream(folder / (name + ".h")) << "#pragma once\n\nint " << name << "();\n";
+			else
+				std::ofstream(folder / (name + ".cpp")) << "int " << name << "()\n{\n\treturn " << i << ";\n}\n";
+		}
+
+		return true;
+	}
+
+	bool SelfBenchmark::Run(const std::vector<uint32_t>& sizes, const SyntheticProjectOptions& options,
+	                        uint32_t repetitions, const std::filesystem::path& jsonPath)
+	{
+		std::filesystem::path workingDirectory = std::filesystem::current_path();
+
+		// A folder of its own, since it's replaced for every size and removed at the end.
+		auto runId = std::chrono::steady_clock::now().time_since_epoch().count();
+		std::filesystem::path root = std::filesystem::temp_directory_path() / ("magnet_bench-" + std::to_string(runId));
+
+		std::vector<CaseResult> results;
+		uint64_t emittedBytes = 0;
+		double emitterThroughput = 0.0;
+		bool isSuccessful = true;
+
+		for (uint32_t size : sizes)
+		{
+			MG_LOG("Creating a synthetic project with " + std::to_string(size) + " files...");
+
+			SyntheticProjectOptions sizeOptions = options;
+			sizeOptions.fileCount = size;
+			std::filesystem::remove_all(root);
+			CreateSyntheticProject(root, sizeOptions);
+			std::filesystem::current_path(root);
+
+			Project project = Application::CreateConfiguredProject();
+			CommandHandlerProps props;
+			props.project = &project;
+
+			auto scan = SourceScanner::Scan(std::filesystem::path(s_SyntheticProjectName) / "Source",
+			                                s_SourceIndexPath, s_SourceExtensions);
+
+			auto cases = GetCases(props, scan.files, emittedBytes);
+			if (results.empty())
+			{
+				for (const auto& benchmarkCase : cases)
+					results.push_back({benchmarkCase.name, {}});
+			}
+
+			for (size_t i = 0; i < cases.size(); i++)
+			{
+				std::vector<double> samples;
+				for (uint32_t j = 0; j < repetitions; j++)
+				{
+					if (cases[i].prepare)
+						cases[i].prepare();
+
+					auto start = std::chrono::steady_clock::now();
+					bool isRun = cases[i].run();
+					samples.push_back(std::chrono::duration<double, std::nano>(
+							std::chrono::steady_clock::now() - start).count());
+
+					if (!isRun)
+					{
+						MG_LOG(std::string(cases[i].name) + " failed on " + std::to_string(size) + " files.");
+						isSuccessful = false;
+						break;
+					}
+				}
+
+				// The emitter case writes the same file every time, so its throughput is taken from the median.
+				if (std::string(cases[i].name) == "CmakeEmitter")
+					emitterThroughput = (double) emittedBytes / (Statistics::Median(samples) / 1e9);
+
+				results[i].samples.push_back(samples);
+			}
+
+			std::filesystem::current_path(workingDirectory);
+		}
+
+		std::filesystem::remove_all(root);
+
+		MG_LOGNH("");
+		PrintResults(sizes, results);
+
+		MG_LOGNH("");
+		MG_LOG("CmakeEmitter wrote " + std::to_string((uint64_t) (emitterThroughput / (1024.0 * 1024.0))) +
+		       " MB/s at " + std::to_string(sizes.back()) + " files.");
+
+		if (!jsonPath.empty())
+		{
+			if (!WriteResults(jsonPath, sizes, options, results))
+			{
+				MG_LOG("Failed to write " + jsonPath.string() + ".");
+				return false;
+			}
+
+			MG_LOG("Wrote every sample to " + jsonPath.string() + ".");
+		}
+
+		return isSuccessful;
+	}
+
+	std::vector<SelfBenchmark::Case> SelfBenchmark::GetCases(const CommandHandlerProps& props,
+	                                                        const std::vector<std::string>& files,
+	                                                        uint64_t& emittedBytes)
+	{
+		std::filesystem::path sourcePath = std::filesystem::path(s_SyntheticProjectName) / "Source";
+		std::filesystem::path emitterPath = std::filesystem::path(".magnet") / "emitter.cmake";
+
+		return {
+				{"Load config",                  nullptr, []()
+				{
+					return Application::CreateConfiguredProject().IsValid();
+				}},
+				{"Get YAML value",               nullptr, []()
+				{
+					return !Application::GetYamlString(Application::s_ConfigPath, "name").empty();
+				}},
+				{"Set YAML value",               nullptr, []()
+				{
+					Application::SetYamlString(Application::s_ConfigPath, "defaultConfiguration", "Debug");
+					return true;
+				}},
+				{"Scan sources (no index)",      []()
+				                                 {
+					                                 std::filesystem::remove(s_SourceIndexPath);
+				                                 }, [sourcePath]()
+				                                 {
+					                                 return !SourceScanner::Scan(sourcePath, s_SourceIndexPath,
+					                                                             s_SourceExtensions).files.empty();
+				                                 }},
+				{"Scan sources (index)",         nullptr, [sourcePath]()
+				{
+					return !SourceScanner::Scan(sourcePath, s_SourceIndexPath, s_SourceExtensions).files.empty();
+				}},
+				{"GenerateCMakeFiles",           nullptr, [&props, &files]()
+				{
+					return CommandHandler::GenerateCMakeFiles(props, files);
+				}},
+				{"GenerateDependencyCMakeFiles", nullptr, [&props]()
+				{
+					return CommandHandler::GenerateDependencyCMakeFiles(props);
+				}},
+				{"CmakeEmitter",                 nullptr, [&files, emitterPath, &emittedBytes]()
+				{
+					{
+						CmakeEmitter emitter(emitterPath);
+						emitter.Add_Header();
+						emitter.Add_AddExecutable(s_SyntheticProjectName, files);
+						for (const auto& file : files)
+							emitter.Add_SetTargetProperties(file, "COMPILE_OPTIONS", "-O2");
+					}
+
+					std::error_code error;
+					emittedBytes = std::filesystem::file_size(emitterPath, error);
+					return !error;
+				}},
+		};
+	}
+
+	double SelfBenchmark::GetScalingExponent(const std::vector<uint32_t>& sizes, const std::vector<double>& medians)
+	{
+		if (sizes.size() < 2)
+			return 0.0;
+
+		std::vector<double> x;
+		std::vector<double> y;
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			x.push_back(std::log((double) sizes[i]));
+			y.push_back(std::log(std::max(medians[i], 1.0)));
+		}
+
+		double meanX = Statistics::Mean(x);
+		double meanY = Statistics::Mean(y);
+
+		double covariance = 0.0;
+		double variance = 0.0;
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			covariance += (x[i] - meanX) * (y[i] - meanY);
+			variance += (x[i] - meanX) * (x[i] - meanX);
+		}
+
+		return variance > 0.0 ? covariance / variance : 0.0;
+	}
+
+	void SelfBenchmark::PrintResults(const std::vector<uint32_t>& sizes, const std::vector<CaseResult>& results)
+	{
+		MG_LOG("Median time per size, in files:");
+
+		std::ostringstream header;
+		header << std::left << std::setw(30) << "Case" << std::right;
+		for (uint32_t size : sizes)
+			header << std::setw(13) << size;
+		header << std::setw(10) << "Scaling";
+		MG_LOGNH(header.str());
+
+		for (const auto& result : results)
+		{
+			std::vector<double> medians;
+			for (const auto& samples : result.samples)
+				medians.push_back(Statistics::Median(samples));
+
+			std::ostringstream row;
+			row << std::left << std::setw(30) << result.name << std::right;
+			for (double median : medians)
+				row << std::setw(13) << FormatMilliseconds(median);
+
+			// 1 means that doubling the files doubles the time, 0 that the time doesn't depend on them.
+			std::ostringstream scaling;
+			scaling << "n^" << std::fixed << std::setprecision(2) << GetScalingExponent(sizes, medians);
+			row << std::setw(10) << (sizes.size() < 2 ? "-" : scaling.str());
+			MG_LOGNH(row.str());
+		}
+	}
+
+	bool SelfBenchmark::WriteResults(const std::filesystem::path& path, const std::vector<uint32_t>& sizes,
+	                                 const SyntheticProjectOptions& options, const std::vector<CaseResult>& results)
+	{
+		JsonWriter out;
+		out.BeginObject();
+
+		out.Key("sizes").BeginArray();
+		for (uint32_t size : sizes)
+			out.Number(size);
+		out.EndArray();
+
+		out.Key("depth").Number(options.depth);
+		out.Key("dependencies").Number(options.dependencyCount);
+		out.Key("cases").BeginArray();
+
+		for (const auto& result : results)
+		{
+			out.BeginObject();
+			out.Key("name").String(result.name);
+			out.Key("samples_ns").BeginArray();
+			for (const auto& samples : result.samples)
+			{
+				out.BeginArray();
+				for (double sample : samples)
+					out.Number(sample);
+				out.EndArray();
+			}
+			out.EndArray();
+			out.EndObject();
+		}
+
+		out.EndArray();
+		out.EndObject();
+
+		std::ofstream file(path);
+		file << out.GetString() << "\n";
+		return (bool) file;
+	}
+}
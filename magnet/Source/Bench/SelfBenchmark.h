@@ -0,0 +1,63 @@
+#pragma once
+
+namespace MG
+{
+	// The shape of a synthetic project written by SelfBenchmark.
+	struct SyntheticProjectOptions
+	{
+		uint32_t fileCount = 1000;
+
+		// How many folders deep the sources are nested below Source. Every folder has up to eight subfolders.
+		uint32_t depth = 3;
+
+		// Empty packages in the Dependencies folder, listed in dependencies.yaml.
+		uint32_t dependencyCount = 10;
+	};
+
+	// Times Magnet's own generator on synthetic projects of growing size, so that regressions and poor scaling
+	// show up before a large monorepo runs into them. Built as the magnet_bench executable.
+	class SelfBenchmark
+	{
+	public:
+		// Writes a project of the given shape to root. Returns false without touching it if root is a folder that
+		// isn't empty.
+		static bool CreateSyntheticProject(const std::filesystem::path& root, const SyntheticProjectOptions& options);
+
+		// Runs every case repetitions times on a synthetic project of each of the given sizes, then prints the
+		// median of every case per size and how it scales with the number of files. Also writes every sample to
+		// jsonPath, unless it's empty. Returns false if a case failed.
+		static bool Run(const std::vector<uint32_t>& sizes, const SyntheticProjectOptions& options,
+		                uint32_t repetitions, const std::filesystem::path& jsonPath);
+
+	private:
+		// A single measurement, run in the root of a synthetic project.
+		struct Case
+		{
+			const char* name;
+
+			// Runs before every repetition without being timed, e.g. to drop a cache. May be empty.
+			std::function<void()> prepare;
+
+			// Returns false if the case failed.
+			std::function<bool()> run;
+		};
+
+		// The timings in nanoseconds of every repetition of a case, per size.
+		struct CaseResult
+		{
+			std::string name;
+			std::vector<std::vector<double>> samples;
+		};
+
+		static std::vector<Case> GetCases(const struct CommandHandlerProps& props,
+		                                  const std::vector<std::string>& files, uint64_t& emittedBytes);
+
+		// Returns the exponent k of the best fit of time ~ files^k, from a least-squares fit of the logarithms.
+		[[nodiscard]] static double GetScalingExponent(const std::vector<uint32_t>& sizes,
+		                                               const std::vector<double>& medians);
+
+		static void PrintResults(const std::vector<uint32_t>& sizes, const std::vector<CaseResult>& results);
+		static bool WriteResults(const std::filesystem::path& path, const std::vector<uint32_t>& sizes,
+		                         const SyntheticProjectOptions& options, const std::vector<CaseResult>& results);
+	};
+}
@@ -0,0 +1,127 @@
+#include "BenchmarkHistory.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace MG
+{
+	std::string BenchmarkRun::GetLabel() const
+	{
+		return isDirty ? commit + " (dirty)" : commit;
+	}
+
+	BenchmarkHistory BenchmarkHistory::Load()
+	{
+		BenchmarkHistory history;
+		if (!std::filesystem::exists(s_HistoryPath))
+			return history;
+
+		YAML::Node node = YAML::LoadFile(s_HistoryPath);
+
+		for (const auto& runNode : node["runs"])
+		{
+			BenchmarkRun run;
+			run.commit = runNode["commit"].as<std::string>("");
+			run.date = runNode["date"].as<std::string>("");
+			run.isDirty = runNode["dirty"].as<bool>(false);
+
+			for (const auto& benchmark : runNode["benchmarks"])
+				run.samples[benchmark.first.as<std::string>()] = benchmark.second.as<std::vector<double>>();
+
+			history.m_Runs.push_back(run);
+		}
+
+		return history;
+	}
+
+	void BenchmarkHistory::Save() const
+	{
+		YAML::Emitter out;
+
+		out << YAML::BeginMap;
+		out << YAML::Key << "runs";
+		out << YAML::Value << YAML::BeginSeq;
+
+		for (const auto& run : m_Runs)
+		{
+			out << YAML::BeginMap;
+			out << YAML::Key << "commit" << YAML::Value << run.commit;
+			out << YAML::Key << "dirty" << YAML::Value << run.isDirty;
+			out << YAML::Key << "date" << YAML::Value << run.date;
+			out << YAML::Key << "benchmarks";
+			out << YAML::Value << YAML::BeginMap;
+
+			for (const auto& [name, samples] : run.samples)
+			{
+				out << YAML::Key << name;
+				out << YAML::Value << YAML::Flow << samples;
+			}
+
+			out << YAML::EndMap;
+			out << YAML::EndMap;
+		}
+
+		out << YAML::EndSeq;
+		out << YAML::EndMap;
+
+		std::filesystem::create_directories(std::filesystem::path(s_HistoryPath).parent_path());
+
+		std::ofstream file(s_HistoryPath);
+		file << out.c_str();
+	}
+
+	void BenchmarkHistory::AddRun(const BenchmarkRun& run)
+	{
+		m_Runs.push_back(run);
+
+		if (m_Runs.size() > s_MaxRuns)
+			m_Runs.erase(m_Runs.begin(), m_Runs.end() - s_MaxRuns);
+	}
+
+	const BenchmarkRun* BenchmarkHistory::GetLatestRun() const
+	{
+		if (m_Runs.empty())
+			return nullptr;
+
+		return &m_Runs.back();
+	}
+
+	bool BenchmarkHistory::ReadResults(const std::filesystem::path& path, const std::string& prefix,
+	                                   BenchmarkSamples& samples)
+	{
+		if (!std::filesystem::exists(path))
+			return false;
+
+		// JSON is a subset of YAML, so there is no need for a separate parser.
+		YAML::Node report;
+		try
+		{
+			report = YAML::LoadFile(path.string());
+		} catch (const YAML::Exception&)
+		{
+			return false;
+		}
+
+		static const std::unordered_map<std::string, double> s_TimeUnits = {
+				{"ns", 1.0},
+				{"us", 1e3},
+				{"ms", 1e6},
+				{"s",  1e9},
+		};
+
+		for (const auto& benchmark : report["benchmarks"])
+		{
+			if (benchmark["run_type"].as<std::string>("iteration") != "iteration" ||
+			    benchmark["error_occurred"].as<bool>(false))
+				continue;
+
+			auto unit = s_TimeUnits.find(benchmark["time_unit"].as<std::string>("ns"));
+			if (unit == s_TimeUnits.end())
+				continue;
+
+			std::string name = prefix + "/" + benchmark["name"].as<std::string>();
+			samples[name].push_back(benchmark["real_time"].as<double>() * unit->second);
+		}
+
+		return true;
+	}
+}
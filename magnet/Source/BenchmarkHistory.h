@@ -0,0 +1,49 @@
+#pragma once
+
+namespace MG
+{
+	// Time per iteration in nanoseconds of every benchmark, one sample per repetition.
+	// Keyed by "<executable>/<benchmark>".
+	using BenchmarkSamples = std::map<std::string, std::vector<double>>;
+
+	// The results of a single `magnet bench` run.
+	struct BenchmarkRun
+	{
+		std::string commit;
+		std::string date;
+		BenchmarkSamples samples;
+
+		// Whether the working tree had uncommitted changes, so the results don't exactly match the commit.
+		bool isDirty = false;
+
+		// Returns the commit, marked if the working tree had uncommitted changes.
+		[[nodiscard]] std::string GetLabel() const;
+	};
+
+	// Results of previous `magnet bench` runs, kept in .magnet/bench so that every run can be compared
+	// against the previous one.
+	class BenchmarkHistory
+	{
+	public:
+		static BenchmarkHistory Load();
+		void Save() const;
+
+		// Adds a run, dropping the oldest ones once the history is full.
+		void AddRun(const BenchmarkRun& run);
+
+		// Returns the most recent run, or nullptr if there is none.
+		[[nodiscard]] const BenchmarkRun* GetLatestRun() const;
+
+		// Reads a report in Google Benchmark's JSON format, which MagnetBench.h writes as well, and appends the
+		// time per iteration of every benchmark to samples, prefixed with "<prefix>/". Aggregates such as the
+		// mean of repetitions are skipped. Returns whether the report could be read.
+		static bool ReadResults(const std::filesystem::path& path, const std::string& prefix,
+		                        BenchmarkSamples& samples);
+
+	private:
+		std::vector<BenchmarkRun> m_Runs;
+
+		static inline constexpr const char* s_HistoryPath = ".magnet/bench/history.yaml";
+		static inline constexpr size_t s_MaxRuns = 100;
+	};
+}
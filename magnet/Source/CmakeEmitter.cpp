@@ -1,14 +1,34 @@
 #include "CmakeEmitter.h"
 
 #include "Core.h"
+#include "Timings.h"
 
 namespace MG
 {
+	static std::string ToUpperCase(const std::string& string)
+	{
+		std::string upperCaseString = string;
+		std::transform(upperCaseString.begin(), upperCaseString.end(), upperCaseString.begin(),
+		               [](unsigned char c) -> unsigned char
+		               {
+			               return static_cast<unsigned char>(std::toupper(c));
+		               });
+
+		return upperCaseString;
+	}
+
 	CmakeEmitter::CmakeEmitter(const std::filesystem::path& path)
+			: m_Path(path), m_StartTime(Timings::GetTime())
 	{
 		m_Stream.open(path);
 	}
 
+	CmakeEmitter::~CmakeEmitter()
+	{
+		m_Stream.close();
+		Timings::Record("Write CMake file", "file", m_Path.generic_string(), m_StartTime);
+	}
+
 	void CmakeEmitter::Add_Header()
 	{
 		m_Stream << "# Generated by Magnet v" << MG_VERSION;
@@ -82,6 +102,52 @@ namespace MG
 		m_Stream << "set(CMAKE_CXX_STANDARD " << value << ")" << End();
 	}
 
+	void CmakeEmitter::Add_SetCmakeCxxCompilerLauncher(const std::string& value)
+	{
+		m_Stream << "set(CMAKE_CXX_COMPILER_LAUNCHER " << value << ")" << End();
+	}
+
+	void CmakeEmitter::Add_SetCmakeCxxLinkerLauncher(const std::string& value)
+	{
+		m_Stream << "set(CMAKE_CXX_LINKER_LAUNCHER " << value << ")" << End();
+	}
+
+	void CmakeEmitter::Add_SetCmakeExportCompileCommands(bool value)
+	{
+		m_Stream << "set(CMAKE_EXPORT_COMPILE_COMMANDS " << (value ? "ON" : "OFF") << ")" << End();
+	}
+
+	void CmakeEmitter::Add_SetCmakeCxxFlags(const std::string& configuration, const std::string& flags)
+	{
+		m_Stream << "set(CMAKE_CXX_FLAGS_" << ToUpperCase(configuration) << " \"" << flags << "\")" << End();
+	}
+
+	void CmakeEmitter::Add_SetCmakeLinkerFlags(const std::string& type, const std::string& configuration,
+	                                           const std::string& flags)
+	{
+		m_Stream << "set(CMAKE_" << type << "_LINKER_FLAGS_" << ToUpperCase(configuration) << " \"" << flags << "\")"
+		         << End();
+	}
+
+	void CmakeEmitter::Add_SetCacheVariable(const std::string& name, const std::string& value, const std::string& type,
+	                                        const std::string& description)
+	{
+		m_Stream << "set(" << name << " \"" << value << "\" CACHE " << type << " \"" << description << "\")"
+		         << End();
+	}
+
+	void CmakeEmitter::Add_AddCompileDefinitions(const std::vector<std::string>& definitions)
+	{
+		m_Stream << "add_compile_definitions(";
+
+		for (size_t i = 0; i < definitions.size(); i++)
+		{
+			m_Stream << (i == 0 ? "" : " ") << definitions[i];
+		}
+
+		m_Stream << ")" << End();
+	}
+
 	void CmakeEmitter::Add_SetCmakeArchiveOutputDirectory(const std::string& value)
 	{
 		m_Stream << "set(CMAKE_ARCHIVE_OUTPUT_DIRECTORY " << value << ")" << End();
@@ -97,6 +163,23 @@ namespace MG
 		m_Stream << "set(CMAKE_RUNTIME_OUTPUT_DIRECTORY " << value << ")" << End();
 	}
 
+	void CmakeEmitter::Add_SetJobPools(const std::vector<std::pair<std::string, uint32_t>>& pools)
+	{
+		m_Stream << "set_property(GLOBAL PROPERTY JOB_POOLS";
+
+		for (const auto& [name, size] : pools)
+		{
+			m_Stream << " " << name << "=" << size;
+		}
+
+		m_Stream << ")" << End();
+	}
+
+	void CmakeEmitter::Add_SetCmakeJobPoolLink(const std::string& pool)
+	{
+		m_Stream << "set(CMAKE_JOB_POOL_LINK " << pool << ")" << End();
+	}
+
 	void CmakeEmitter::Add_SetTargetProperties(const std::string& target, const std::string& property,
 	                                           const std::string& value)
 	{
@@ -147,13 +230,57 @@ namespace MG
 		m_Stream << ")" << End();
 	}
 
+	void CmakeEmitter::Add_TargetLinkLibraries(const std::string& target, const std::string& mode,
+	                                           const std::vector<std::string>& libraries)
+	{
+		m_Stream << "target_link_libraries(" << target << " " << mode;
+
+		for (const auto& library : libraries)
+		{
+			m_Stream << " " << library;
+		}
+
+		m_Stream << ")" << End();
+	}
+
+	void CmakeEmitter::Add_TargetLinkOptions(const std::string& target, const std::string& mode,
+	                                         const std::vector<std::string>& options)
+	{
+		m_Stream << "target_link_options(" << target << " " << mode;
+
+		for (const auto& option : options)
+		{
+			m_Stream << " " << option;
+		}
+
+		m_Stream << ")" << End();
+	}
+
+	void CmakeEmitter::Add_TargetCompileDefinitions(const std::string& target, const std::string& mode,
+	                                                const std::vector<std::string>& definitions)
+	{
+		m_Stream << "target_compile_definitions(" << target << " " << mode;
+
+		for (const auto& definition : definitions)
+		{
+			m_Stream << " " << definition;
+		}
+
+		m_Stream << ")" << End();
+	}
+
+	void CmakeEmitter::Add_AddDependencies(const std::string& target, const std::string& dependency)
+	{
+		m_Stream << "add_dependencies(" << target << " " << dependency << ")" << End();
+	}
+
 	void CmakeEmitter::Add_AddExecutable(const std::string& target, const std::vector<std::string>& sources)
 	{
 		m_Stream << "add_executable(" << target;
 
 		for (const auto& source : sources)
 		{
-			m_Stream << " " << source;
+			m_Stream << " " << Quote(source);
 		}
 
 		m_Stream << ")" << End();
@@ -166,12 +293,48 @@ namespace MG
 
 		for (const auto& source : sources)
 		{
-			m_Stream << " " << source;
+			m_Stream << " " << Quote(source);
 		}
 
 		m_Stream << ")" << End();
 	}
 
+	void CmakeEmitter::Add_AddImportedLibrary(const std::string& target, const std::string& type,
+	                                          const std::string& location)
+	{
+		m_Stream << "add_library(" << target << " " << type << " IMPORTED GLOBAL)" << End();
+		Add_SetTargetProperties(target, "IMPORTED_LOCATION", Quote(location));
+	}
+
+	void CmakeEmitter::Add_Include(const std::string& module)
+	{
+		m_Stream << "include(" << module << ")" << End();
+	}
+
+	void CmakeEmitter::Add_ExternalProjectAdd(const std::string& name,
+	                                          const std::vector<std::pair<std::string, std::string>>& arguments)
+	{
+		m_Stream << "ExternalProject_Add(" << name << End();
+
+		for (const auto& [key, value] : arguments)
+		{
+			Add_Indentation();
+			m_Stream << key << " " << value << End();
+		}
+
+		m_Stream << ")" << End();
+	}
+
+	void CmakeEmitter::Add_EnableTesting()
+	{
+		m_Stream << "enable_testing()" << End();
+	}
+
+	void CmakeEmitter::Add_AddTest(const std::string& name, const std::string& command)
+	{
+		m_Stream << "add_test(NAME " << name << " COMMAND " << command << ")" << End();
+	}
+
 	void CmakeEmitter::Add_TargetPrecompileHeaders(const std::string& target, const std::string& mode,
 	                                               const std::string& header)
 	{
@@ -183,4 +346,21 @@ namespace MG
 	{
 		return '\n';
 	}
+
+	std::string CmakeEmitter::Quote(const std::string& argument)
+	{
+		if (argument.find_first_of(" \t;()#\"") == std::string::npos)
+			return argument;
+
+		std::string quoted = "\"";
+		for (char c : argument)
+		{
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+
+			quoted += c;
+		}
+
+		return quoted + "\"";
+	}
 }
\ No newline at end of file
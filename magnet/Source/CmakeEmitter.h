@@ -7,6 +7,9 @@ namespace MG
 	public:
 		explicit CmakeEmitter(const std::filesystem::path& path);
 
+		// Records how long the file took to generate, for `--timings`.
+		~CmakeEmitter();
+
 		// Adds the default "Generated by Magnet" text.
 		void Add_Header();
 
@@ -41,6 +44,32 @@ namespace MG
 		// https://cmake.org/cmake/help/latest/prop_tgt/CXX_STANDARD.html
 		void Add_SetCmakeCxxStandard(int value);
 
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_LANG_COMPILER_LAUNCHER.html
+		void Add_SetCmakeCxxCompilerLauncher(const std::string& value);
+
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_LANG_LINKER_LAUNCHER.html
+		void Add_SetCmakeCxxLinkerLauncher(const std::string& value);
+
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_EXPORT_COMPILE_COMMANDS.html
+		void Add_SetCmakeExportCompileCommands(bool value);
+
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_LANG_FLAGS_CONFIG.html
+		void Add_SetCmakeCxxFlags(const std::string& configuration, const std::string& flags);
+
+		// Sets the linker flags of the given target type (EXE, SHARED or MODULE) for the given configuration.
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_EXE_LINKER_FLAGS_CONFIG.html
+		void Add_SetCmakeLinkerFlags(const std::string& type, const std::string& configuration,
+		                             const std::string& flags);
+
+		// Declares a cache variable, which can be set with -D<name>=<value> when generating.
+		// https://cmake.org/cmake/help/latest/command/set.html#set-cache-entry
+		void Add_SetCacheVariable(const std::string& name, const std::string& value, const std::string& type,
+		                          const std::string& description);
+
+		// Adds preprocessor definitions to every target in the current folder and below.
+		// https://cmake.org/cmake/help/latest/command/add_compile_definitions.html
+		void Add_AddCompileDefinitions(const std::vector<std::string>& definitions);
+
 		// https://cmake.org/cmake/help/latest/prop_tgt/ARCHIVE_OUTPUT_DIRECTORY.html
 		void Add_SetCmakeArchiveOutputDirectory(const std::string& value);
 
@@ -50,6 +79,12 @@ namespace MG
 		// https://cmake.org/cmake/help/latest/prop_tgt/RUNTIME_OUTPUT_DIRECTORY.html
 		void Add_SetCmakeRuntimeOutputDirectory(const std::string& value);
 
+		// https://cmake.org/cmake/help/latest/prop_gbl/JOB_POOLS.html
+		void Add_SetJobPools(const std::vector<std::pair<std::string, uint32_t>>& pools);
+
+		// https://cmake.org/cmake/help/latest/variable/CMAKE_JOB_POOL_LINK.html
+		void Add_SetCmakeJobPoolLink(const std::string& pool);
+
 		// https://cmake.org/cmake/help/latest/command/set_target_properties.html
 		void Add_SetTargetProperties(const std::string& target, const std::string& property,
 		                             const std::string& value);
@@ -73,6 +108,22 @@ namespace MG
 
 		void Add_TargetLinkLibraries(const std::string& target, const std::vector<std::string>& libraries);
 
+		// Same as above, but with a scope such as INTERFACE, which interface and imported libraries require.
+		// https://cmake.org/cmake/help/latest/command/target_link_libraries.html
+		void Add_TargetLinkLibraries(const std::string& target, const std::string& mode,
+		                             const std::vector<std::string>& libraries);
+
+		// https://cmake.org/cmake/help/latest/command/target_link_options.html
+		void Add_TargetLinkOptions(const std::string& target, const std::string& mode,
+		                           const std::vector<std::string>& options);
+
+		// https://cmake.org/cmake/help/latest/command/target_compile_definitions.html
+		void Add_TargetCompileDefinitions(const std::string& target, const std::string& mode,
+		                                  const std::vector<std::string>& definitions);
+
+		// https://cmake.org/cmake/help/latest/command/add_dependencies.html
+		void Add_AddDependencies(const std::string& target, const std::string& dependency);
+
 		// https://cmake.org/cmake/help/latest/command/add_executable.html
 		void Add_AddExecutable(const std::string& target, const std::vector<std::string>& sources);
 
@@ -80,6 +131,24 @@ namespace MG
 		void Add_AddLibrary(const std::string& target, const std::string& type,
 		                    const std::vector<std::string>& sources);
 
+		// Adds a library that was built elsewhere, e.g. by an external project.
+		// https://cmake.org/cmake/help/latest/command/add_library.html#imported-libraries
+		void Add_AddImportedLibrary(const std::string& target, const std::string& type, const std::string& location);
+
+		// https://cmake.org/cmake/help/latest/command/include.html
+		void Add_Include(const std::string& module);
+
+		// Adds an external project with one argument per line. Requires include(ExternalProject).
+		// https://cmake.org/cmake/help/latest/module/ExternalProject.html
+		void Add_ExternalProjectAdd(const std::string& name,
+		                            const std::vector<std::pair<std::string, std::string>>& arguments);
+
+		// https://cmake.org/cmake/help/latest/command/enable_testing.html
+		void Add_EnableTesting();
+
+		// https://cmake.org/cmake/help/latest/command/add_test.html
+		void Add_AddTest(const std::string& name, const std::string& command);
+
 		void Add_TargetPrecompileHeaders(const std::string& target, const std::string& mode,
 		                                 const std::string& header);
 
@@ -87,6 +156,12 @@ namespace MG
 		// Returns a newline character.
 		static char End();
 
+		// Wraps the given argument in quotes if it contains characters CMake would split on.
+		static std::string Quote(const std::string& argument);
+
 		std::ofstream m_Stream;
+
+		std::filesystem::path m_Path;
+		double m_StartTime;
 	};
 }
\ No newline at end of file
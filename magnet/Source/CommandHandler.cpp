@@ -2,28 +2,447 @@
 
 #include "yaml-cpp/yaml.h"
 
+#include "AllocationProfile.h"
+#include "Allocator.h"
 #include "Application.h"
+#include "BenchmarkHistory.h"
 #include "CmakeEmitter.h"
 #include "Core.h"
+#include "Elf.h"
+#include "Event.h"
+#include "FlameGraph.h"
+#include "Hash.h"
+#include "JsonWriter.h"
+#include "NativeBuilder.h"
+#include "NinjaEmitter.h"
 #include "Platform/Platform.h"
 #include "Project.h"
+#include "RebuildExplanation.h"
+#include "ResourceLog.h"
+#include "SizeReport.h"
+#include "SourceScanner.h"
+#include "Statistics.h"
+#include "TestHistory.h"
+#include "Timings.h"
 
 namespace MG
 {
+	// Flags handled by Magnet itself, mapped to whether they take a value.
+	static const std::unordered_map<std::string, bool> s_Flags = {
+			{"--resources",     false},
+			{"--force",         false},
+			{"--shard",         true},
+			{"--repetitions",   true},
+			{"--warmup",        true},
+			{"--filter",        true},
+			{"--against",       true},
+			{"--build-only",    false},
+			{"--jobs",          true},
+			{"--repeat",        true},
+			{"--json",          true},
+			{"--counters",      false},
+			{"--alloc-profile", false},
+			{"--allocators",    true},
+			{"--trace",         false},
+			{"--timings",       false},
+			{"--timings-trace", true},
+			{"--output",        true},
+			{"--native",        false},
+			{"--explain",       false},
+	};
+
+	// File types picked up from the Source folder.
+	static const std::vector<std::string> s_SourceExtensions = {".cpp", ".h", ".hpp"};
+	static constexpr const char* s_SourceIndexPath = ".magnet/sourceIndex";
+
+	// A folder next to Source in which every top-level .cpp file and every subfolder becomes an executable.
+	struct TargetFolder
+	{
+		const char* name;
+		const char* indexPath;
+		TargetRole role;
+	};
+
+	static const std::array<TargetFolder, 2> s_TargetFolders = {{
+			{"Tests",      ".magnet/testIndex",  TargetRole::Test},
+			{"Benchmarks", ".magnet/benchIndex", TargetRole::Benchmark},
+	}};
+
+	static constexpr uint32_t s_DefaultBenchmarkRepetitions = 5;
+	static constexpr uint32_t s_DefaultBenchmarkWarmup = 1;
+
+	// Slightly off 1000 Hz, so that sampling doesn't run in lockstep with work that happens every millisecond.
+	static constexpr uint32_t s_ProfileFrequency = 999;
+
+	// Bisecting classifies single revisions, so it measures more carefully.
+	static constexpr uint32_t s_DefaultBisectRepetitions = 10;
+	static constexpr uint32_t s_MaxBisectSteps = 64;
+
+	// Differences with a lower p-value are reported as faster or slower.
+	static constexpr double s_SignificanceLevel = 0.05;
+
+	// Formats a duration given in nanoseconds with the largest unit that keeps it above 1.
+	static std::string FormatDuration(double nanoseconds)
+	{
+		static const std::array<std::pair<double, const char*>, 3> s_Units = {{
+				{1e9, "s"},
+				{1e6, "ms"},
+				{1e3, "us"},
+		}};
+
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(2);
+
+		for (const auto& [factor, unit] : s_Units)
+		{
+			if (nanoseconds >= factor)
+			{
+				stream << nanoseconds / factor << " " << unit;
+				return stream.str();
+			}
+		}
+
+		stream << nanoseconds << " ns";
+		return stream.str();
+	}
+
+	// Formats a size given in bytes with the largest unit that keeps it above 1.
+	static std::string FormatBytes(double bytes)
+	{
+		static const std::array<std::pair<double, const char*>, 3> s_Units = {{
+				{1024.0 * 1024.0 * 1024.0, "GB"},
+				{1024.0 * 1024.0,          "MB"},
+				{1024.0,                   "KB"},
+		}};
+
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1);
+
+		for (const auto& [factor, unit] : s_Units)
+		{
+			if (bytes >= factor)
+			{
+				stream << bytes / factor << " " << unit;
+				return stream.str();
+			}
+		}
+
+		stream << std::setprecision(0) << bytes << " B";
+		return stream.str();
+	}
+
+	// Parses a duration such as "1.5us" into nanoseconds. Plain numbers are nanoseconds as well.
+	static bool ParseDuration(const std::string& string, double& nanoseconds)
+	{
+		static const std::unordered_map<std::string, double> s_Units = {
+				{"",   1.0},
+				{"ns", 1.0},
+				{"us", 1e3},
+				{"ms", 1e6},
+				{"s",  1e9},
+		};
+
+		std::istringstream stream(string);
+		double value = 0.0;
+		std::string unit;
+		if (!(stream >> value) || value <= 0.0)
+			return false;
+
+		stream >> unit;
+		auto it = s_Units.find(unit);
+		if (it == s_Units.end())
+			return false;
+
+		nanoseconds = value * it->second;
+		return true;
+	}
+
+	// Escapes every character that has a special meaning in a regex.
+	static std::string EscapeRegex(const std::string& string)
+	{
+		static const std::regex s_SpecialCharacters(R"([.^$|()\[\]{}*+?\\])");
+		return std::regex_replace(string, s_SpecialCharacters, R"(\$&)");
+	}
+
+	// Removes trailing whitespace and newlines, e.g. from the output of a command.
+	static std::string TrimEnd(std::string string)
+	{
+		string.erase(string.find_last_not_of(" \t\r\n") + 1);
+		return string;
+	}
+
+	// Splits a list such as "mimalloc,jemalloc" at the given separator, leaving out empty entries.
+	static std::vector<std::string> Split(const std::string& string, char separator)
+	{
+		std::vector<std::string> parts;
+		std::istringstream stream(string);
+		std::string part;
+		while (std::getline(stream, part, separator))
+		{
+			if (!part.empty())
+				parts.push_back(part);
+		}
+
+		return parts;
+	}
+
+	// Splits a command line as written to compile_commands.json into its arguments, removing the quotes and
+	// backslashes that escape spaces.
+	static std::vector<std::string> SplitCommandLine(const std::string& commandLine)
+	{
+		std::vector<std::string> arguments;
+		std::string argument;
+		bool hasArgument = false;
+		char quote = 0;
+		for (size_t i = 0; i < commandLine.size(); i++)
+		{
+			char c = commandLine[i];
+			if (c == '\\' && i + 1 < commandLine.size() && quote != '\'')
+			{
+				argument += commandLine[++i];
+				hasArgument = true;
+			} else if (quote != 0 && c == quote)
+			{
+				quote = 0;
+			} else if (quote == 0 && (c == '"' || c == '\''))
+			{
+				quote = c;
+				hasArgument = true;
+			} else if (quote == 0 && (c == ' ' || c == '\t'))
+			{
+				if (hasArgument)
+					arguments.push_back(argument);
+
+				argument.clear();
+				hasArgument = false;
+			} else
+			{
+				argument += c;
+				hasArgument = true;
+			}
+		}
+
+		if (hasArgument)
+			arguments.push_back(argument);
+
+		return arguments;
+	}
+
+	// Counters that are compared with each other share a group, and no group needs more than 4 hardware counters.
+	static const std::vector<CounterGroup> s_DefaultCounterGroups = {
+			{"cycles",           "instructions",          "branches",         "branch-misses"},
+			{"cache-references", "cache-misses"},
+			{"L1-dcache-loads",  "L1-dcache-load-misses", "LLC-loads",        "LLC-load-misses"},
+			{"task-clock",       "page-faults",           "context-switches", "cpu-migrations"},
+	};
+
+	// Ratios between counters that are printed next to them, like `perf stat` does.
+	struct CounterRatio
+	{
+		const char* event;
+		const char* base;
+		const char* description;
+		bool isPercentage;
+	};
+
+	static const std::array<CounterRatio, 5> s_CounterRatios = {{
+			{"instructions",          "cycles",           "instructions per cycle", false},
+			{"branch-misses",         "branches",         "of branches",            true},
+			{"cache-misses",          "cache-references", "of cache references",    true},
+			{"L1-dcache-load-misses", "L1-dcache-loads",  "of L1d loads",           true},
+			{"LLC-load-misses",       "LLC-loads",        "of LLC loads",           true},
+	}};
+
+	// Formats a count with thousands separators, e.g. 1,234,567.
+	static std::string FormatCount(double count)
+	{
+		std::string digits = std::to_string((uint64_t) std::llround(count));
+		for (int i = (int) digits.size() - 3; i > 0; i -= 3)
+			digits.insert((size_t) i, ",");
+
+		return digits;
+	}
+
+	// Returns the median of every counter over several runs, in the order the counters first appeared.
+	static std::vector<CounterValue> AggregateCounters(const std::vector<std::vector<CounterValue>>& runs)
+	{
+		std::vector<CounterValue> medians;
+		std::map<std::string, std::vector<double>> values;
+
+		for (const auto& run : runs)
+		{
+			for (const auto& counter : run)
+			{
+				auto& eventValues = values[counter.event];
+				if (eventValues.empty())
+					medians.push_back({counter.event, 0.0, false});
+
+				eventValues.push_back(counter.value);
+
+				auto median = std::find_if(medians.begin(), medians.end(), [&counter](const CounterValue& value)
+				{
+					return value.event == counter.event;
+				});
+				median->isScaled |= counter.isScaled;
+			}
+		}
+
+		for (auto& median : medians)
+			median.value = Statistics::Median(values[median.event]);
+
+		return medians;
+	}
+
+	static void PrintCounters(const std::vector<CounterValue>& counters, const std::vector<CounterGroup>& groups)
+	{
+		auto find = [&counters](const std::string& event) -> const CounterValue*
+		{
+			for (const auto& counter : counters)
+			{
+				if (counter.event == event)
+					return &counter;
+			}
+
+			return nullptr;
+		};
+
+		for (const auto& counter : counters)
+		{
+			std::ostringstream line;
+			line << std::right << std::setw(18) << FormatCount(counter.value) << "  " << std::left << std::setw(24)
+			     << counter.event;
+
+			for (const auto& ratio : s_CounterRatios)
+			{
+				const CounterValue* base = find(ratio.base);
+				if (counter.event != ratio.event || !base || base->value <= 0.0)
+					continue;
+
+				double value = counter.value / base->value;
+				line << "# " << std::fixed << std::setprecision(2) << (ratio.isPercentage ? value * 100.0 : value)
+				     << (ratio.isPercentage ? "% " : " ") << ratio.description;
+			}
+
+			// The kernel multiplexes counters when there are more than the CPU has.
+			if (counter.isScaled)
+				line << "  (scaled)";
+
+			MG_LOGNH(TrimEnd(line.str()));
+		}
+
+		std::vector<std::string> missing;
+		for (const auto& group : groups)
+		{
+			for (const auto& event : group)
+			{
+				if (!find(event))
+					missing.push_back(event);
+			}
+		}
+
+		if (!missing.empty())
+		{
+			std::string list = std::accumulate(std::next(missing.begin()), missing.end(), missing.front(),
+			                                   [](const std::string& a, const std::string& b)
+			                                   {
+				                                   return a + ", " + b;
+			                                   });
+			MG_LOG("Not available on this machine, e.g. inside a container or VM: " + list + ".");
+		}
+	}
+
+	// Names the function at an address of a profiled process, from the files that were mapped into it.
+	// Every file is read once, and only when one of its addresses shows up.
+	static std::string Symbolize(uint64_t address, const std::vector<MappedFile>& mappings,
+	                             std::map<std::string, ElfFile>& files)
+	{
+		auto mapping = std::find_if(mappings.rbegin(), mappings.rend(), [address](const MappedFile& file)
+		{
+			return address >= file.start && address < file.end;
+		});
+		if (mapping == mappings.rend())
+			return "[unknown]";
+
+		// Pseudo files such as [vdso] are named in brackets already.
+		if (mapping->path.empty() || mapping->path[0] == '[')
+			return mapping->path.empty() ? "[unknown]" : mapping->path;
+
+		auto [file, isNew] = files.try_emplace(mapping->path);
+		if (isNew)
+			file->second = ElfFile::Load(mapping->path);
+
+		uint64_t fileAddress = 0;
+		if (file->second.GetAddressOfOffset(address - mapping->start + mapping->offset, fileAddress))
+		{
+			if (const ElfSymbol* symbol = file->second.FindFunction(fileAddress))
+				return ElfFile::Demangle(symbol->name);
+		}
+
+		return "[" + std::filesystem::path(mapping->path).filename().string() + "]";
+	}
+
+	// Names a subprocess in `--timings` after its program and subcommand, e.g. "git worktree".
+	static std::string GetProcessTimingName(const std::vector<std::string>& arguments)
+	{
+		std::string name = std::filesystem::path(arguments.front()).filename().string();
+		if (arguments.size() > 1 && !arguments[1].empty() && arguments[1][0] != '-')
+			name += " " + arguments[1];
+
+		return name;
+	}
+
+	// Returns a new folder for the results of a profiling run, named after the current time.
+	static std::filesystem::path GetProfilePath(const Project& project)
+	{
+		std::time_t now = std::time(nullptr);
+		std::ostringstream timestamp;
+		timestamp << std::put_time(std::localtime(&now), "%Y-%m-%d_%H-%M-%S");
+
+		return std::filesystem::path(project.GetName()) / "Profiles" / timestamp.str();
+	}
+
+	// Joins arguments into a command for the shell that ninja runs, quoting those with spaces.
+	static std::string JoinCommand(const std::vector<std::string>& arguments)
+	{
+		std::string command;
+		for (const auto& argument : arguments)
+		{
+			if (!command.empty())
+				command += " ";
+
+			command += argument.find(' ') != std::string::npos ? "\"" + argument + "\"" : argument;
+		}
+
+		return command;
+	}
+
+	// Interface library through which executables link the allocator of their configuration.
+	static constexpr const char* s_AllocatorTarget = "magnet-allocator";
+
+	// Used when neither config.yaml nor previous builds provide a memory estimate, in megabytes.
+	static constexpr int s_DefaultCompileMemory = 1024;
+	static constexpr int s_DefaultLinkMemory = 4096;
+
+	// Peaks below this most likely come from no-op builds that only ran the build tool, in megabytes.
+	static constexpr int s_MinimumLearnedMemory = 256;
+
 	std::string CommandHandlerProps::GetArgument(uint32_t index) const
 	{
-		if (index >= nextArguments.size())
+		// Flags such as --timings may appear anywhere, so they don't shift the positional arguments.
+		std::vector<std::string> arguments = GetForwardedArguments();
+		if (index >= arguments.size())
 			return "";
 
-		return nextArguments[index];
+		return arguments[index];
 	}
 
 	std::string CommandHandlerProps::ConvertArgumetsToString() const
 	{
-		if (nextArguments.empty())
+		std::vector<std::string> forwardedArguments = GetForwardedArguments();
+		if (forwardedArguments.empty())
 			return "";
 
-		auto arguments = std::accumulate(nextArguments.begin(), nextArguments.end(), std::string(),
+		auto arguments = std::accumulate(forwardedArguments.begin(), forwardedArguments.end(), std::string(),
 		                                 [](const std::string& a, const std::string& b)
 		                                 {
 			                                 return a + " " + b;
@@ -32,6 +451,54 @@ namespace MG
 		return arguments.substr(1);
 	}
 
+	std::vector<std::string> CommandHandlerProps::GetForwardedArguments() const
+	{
+		std::vector<std::string> forwardedArguments;
+		for (size_t i = 0; i < nextArguments.size(); i++)
+		{
+			auto flag = s_Flags.find(nextArguments[i]);
+			if (flag == s_Flags.end())
+			{
+				forwardedArguments.push_back(nextArguments[i]);
+				continue;
+			}
+
+			// Skip the flag's value as well.
+			if (flag->second)
+				i++;
+		}
+
+		return forwardedArguments;
+	}
+
+	bool CommandHandlerProps::HasFlag(const std::string& flag) const
+	{
+		return std::find(nextArguments.begin(), nextArguments.end(), flag) != nextArguments.end();
+	}
+
+	std::string CommandHandlerProps::GetFlagValue(const std::string& flag) const
+	{
+		auto it = std::find(nextArguments.begin(), nextArguments.end(), flag);
+		if (it == nextArguments.end() || it + 1 == nextArguments.end())
+			return "";
+
+		return *(it + 1);
+	}
+
+	bool CommandHandlerProps::GetFlagValue(const std::string& flag, uint32_t& value) const
+	{
+		if (!HasFlag(flag))
+			return true;
+
+		std::istringstream stream(GetFlagValue(flag));
+		uint32_t number = 0;
+		if (!(stream >> number) || !stream.eof())
+			return false;
+
+		value = number;
+		return true;
+	}
+
 	[[maybe_unused]] bool CommandHandlerProps::HasArguments() const
 	{
 		return !nextArguments.empty();
@@ -46,8 +513,35 @@ namespace MG
 		MG_LOGNH("  config <configuration>       Changes the default configuration.");
 		MG_LOGNH("  new                          Creates a new C++ project.");
 		MG_LOGNH("  generate                     Generates project files.");
+		MG_LOGNH("  generate --force             Generates project files even if nothing changed.");
 		MG_LOGNH("  build                        Builds the project.");
+		MG_LOGNH("  build --resources            Builds and ranks compiles by CPU time and memory.");
+		MG_LOGNH("  build --jobs <n>             Builds with n parallel jobs instead of picking a number.");
+		MG_LOGNH("  build --native               Compiles and links the project itself, without CMake or Ninja.");
+		MG_LOGNH("  build --explain              Explains why files are compiled again before building.");
 		MG_LOGNH("  go                           Launches the project.");
+		MG_LOGNH("  go --repeat <n>              Launches the project n times and reports its time and memory.");
+		MG_LOGNH("  go --repeat <n> --warmup <k> Launches the project k times first without measuring it.");
+		MG_LOGNH("  go --repeat <n> --json <file>");
+		MG_LOGNH("                               Writes every measured run to a JSON file as well.");
+		MG_LOGNH("  go --counters                Reports CPU performance counters, such as IPC and cache misses.");
+		MG_LOGNH("  go --alloc-profile           Reports the top allocation sites and the heap size over time.");
+		MG_LOGNH("  go --trace                   Writes the zones of MagnetTrace.h to a Chrome trace.");
+		MG_LOGNH("  test                         Builds and runs all tests in parallel.");
+		MG_LOGNH("  test --shard <i>/<n>         Runs the i-th of n equally long shards of the tests.");
+		MG_LOGNH("  bench                        Builds and runs all benchmarks, comparing them to the last run.");
+		MG_LOGNH("  bench --repetitions <n>      Runs every benchmark n times (default: 5).");
+		MG_LOGNH("  bench --against <ref>        Compares the benchmarks to another git revision, side by side.");
+		MG_LOGNH("  bench --filter <regex>       Only runs the benchmarks matching the regex.");
+		MG_LOGNH("  bench --build-only           Builds the benchmarks without running them.");
+		MG_LOGNH("  bench --counters             Also reports CPU performance counters, such as IPC and cache misses.");
+		MG_LOGNH("  bench --allocators <a,b,...> Builds the benchmarks with every allocator and compares them.");
+		MG_LOGNH("  bisect-perf <good> <bad> <executable>/<benchmark> <threshold>");
+		MG_LOGNH("                               Finds the commit that made a benchmark slower than the threshold.");
+		MG_LOGNH("  profile                      Profiles the project and writes a flame graph to Profiles.");
+		MG_LOGNH("  size                         Reports the sections, symbols and templates that make up the binary.");
+		MG_LOGNH("  size <baseline> <binary>     Compares the sizes of two builds.");
+		MG_LOGNH("  size --against <ref>         Compares the size of the binary to another git revision.");
 		MG_LOGNH("  clean                        Cleans the project.");
 		MG_LOGNH("  pull                         Installs all dependencies.");
 		MG_LOGNH("  pull <url>                   Installs a new dependency.");
@@ -55,6 +549,10 @@ namespace MG
 		MG_LOGNH("  pull --help                  Shows more information.");
 		MG_LOGNH("  remove <dependency>          Removes a dependency.");
 		MG_LOGNH("  switch <dependency> <branch> Switches a dependency branch.");
+		MG_LOGNH("\nOptions:");
+		MG_LOGNH("  --timings                    Prints how long every phase of the command took.");
+		MG_LOGNH("  --timings-trace <file>       Also writes the phases and build steps to a Chrome trace.");
+		MG_LOGNH("  --output json                Writes newline-delimited JSON events to stdout instead of text.");
 	}
 
 	void CommandHandler::HandleConfigCommand(const CommandHandlerProps& props)
@@ -70,7 +568,7 @@ namespace MG
 
 		if (!configuration.IsValid())
 		{
-			MG_LOG("Usage: magnet config [Debug/Release]");
+			MG_LOG("Usage: magnet config [Debug/Release/Profile]");
 			return;
 		}
 
@@ -133,24 +631,64 @@ namespace MG
 				break;
 		} while (true);
 
-		CreateNewProject(project);
+		bool isTracingIncluded = false;
+		do
+		{
+			MG_LOG_HOST("Project Wizard", "Include MagnetTrace.h to trace hot paths with `magnet go --trace`? (y/N)");
+			Application::PrintPrompt();
+
+			std::string input;
+			std::getline(std::cin, input);
+
+			if (input.empty() || input[0] == 'n' || input[0] == 'N')
+				break;
+
+			if (input[0] == 'y' || input[0] == 'Y')
+			{
+				isTracingIncluded = true;
+				break;
+			}
+
+			MG_LOG_HOST("Project Wizard", "Invalid answer.");
+		} while (true);
+
+		CreateNewProject(project, isTracingIncluded);
 	}
 
 	void CommandHandler::HandleGenerateCommand(const CommandHandlerProps& props)
+	{
+		GenerateProject(props);
+	}
+
+	void CommandHandler::HandleBuildCommand(const CommandHandlerProps& props)
+	{
+		uint32_t jobs = 0;
+		if (!props.GetFlagValue("--jobs", jobs))
+		{
+			MG_LOG("Usage: magnet build --jobs <n>");
+			return;
+		}
+
+		BuildProject(props, jobs);
+	}
+
+	bool CommandHandler::GenerateProject(const CommandHandlerProps& props)
 	{
 		MG_LOG("Generating project files...");
 
 		if (!Application::IsRootLevel())
 		{
 			MG_LOG("In order to generate, run this command at the root of your project, where .magnet can be found.");
-			return;
+			return false;
 		}
 
 		if (!RequireProjectName(props))
-			return;
+			return false;
 
 		std::string projectName = props.project->GetName();
 
+		Timings::Scope dependencyTiming("Check dependencies");
+
 		const std::filesystem::path dependenciesPath = std::filesystem::path(projectName) / "Dependencies";
 		bool hasMissingDependencies = false;
 		if (std::filesystem::exists(dependenciesPath))
@@ -170,581 +708,3997 @@ namespace MG
 		if (hasMissingDependencies)
 		{
 			MG_LOG("Generate failed due to missing dependencies. Run `magnet pull` to install them.");
-			return;
+			return false;
 		}
 
-		GenerateRootCMakeFile(props);
-		GenerateCMakeFiles(props);
-		GenerateDependencyCMakeFiles(props);
+		std::set<std::string> allocators;
+		for (const auto& [configuration, allocator] : Application::GetAllocators())
+			allocators.insert(allocator);
 
-		std::filesystem::path buildPath = std::filesystem::path(projectName) / "Build";
-		std::string generateCommand = "cmake -S . -B " + buildPath.string() + " ";
+		if (!props.project->GetAllocator().empty())
+			allocators.insert(props.project->GetAllocator());
 
-		generateCommand += Platform::GetGenerateCommand(props.project->GetConfiguration().ToString());
-		generateCommand += " " + props.ConvertArgumetsToString();
-
-		if (!ExecuteCommand(generateCommand,
-		                    "CMake failed to generate project files. See messages above for more information."))
-			return;
+		for (const auto& allocator : allocators)
+		{
+			if (!RequireAllocator(allocator))
+				return false;
+		}
 
-		MG_LOG("Successfully generated project files. Run `magnet build` next.");
-	}
+		dependencyTiming.Stop();
 
-	void CommandHandler::HandleBuildCommand(const CommandHandlerProps& props)
-	{
-		std::string configuration = props.project->GetConfiguration().ToString();
-		MG_LOG("Building in " + configuration + " configuration...");
+		std::filesystem::path buildPath = GetBuildPath(props);
 
-		if (!RequireProjectName(props))
-			return;
+		WriteExportHeaders(props);
 
-		std::filesystem::path buildPath = std::filesystem::path(props.project->GetName()) / "Build";
-		std::string command = "cmake --build " + buildPath.string() + " --config " + configuration + " " +
-		                      props.ConvertArgumetsToString();
+		Timings::Scope scanTiming("Scan sources");
+		auto scan = SourceScanner::Scan(std::filesystem::path(projectName) / "Source", s_SourceIndexPath,
+		                                s_SourceExtensions);
 
-		if (!ExecuteCommand(command,
-		                    "CMake couldn't build the project. See messages above for more information. Have you tried generating your project files first? If not, run `magnet generate`."))
-			return;
+		// The fingerprint also covers the file lists, in case the previous generate failed after scanning.
+		std::vector<std::string> scannedFiles = scan.files;
+		bool hasChanged = scan.hasChanged;
 
-		MG_LOG("Build successful. Run `magnet go` to launch your app.");
-	}
+		std::vector<std::string> addedFiles = scan.addedFiles;
+		std::vector<std::string> removedFiles = scan.removedFiles;
 
-	void CommandHandler::HandleGoCommand(const CommandHandlerProps& props)
-	{
-		HandleGenerateCommand(props);
-		HandleBuildCommand(props);
+		std::vector<std::vector<std::string>> folderFiles;
+		for (const auto& folder : s_TargetFolders)
+		{
+			auto folderScan = SourceScanner::Scan(std::filesystem::path(projectName) / folder.name,
+			                                      folder.indexPath, s_SourceExtensions);
+			for (const auto& file : folderScan.files)
+				scannedFiles.push_back(std::string(folder.name) + "/" + file);
 
-		MG_LOG("Launching project...");
+			for (const auto& file : folderScan.addedFiles)
+				addedFiles.push_back(std::string(folder.name) + "/" + file);
 
-		if (!RequireProjectName(props))
-			return;
+			for (const auto& file : folderScan.removedFiles)
+				removedFiles.push_back(std::string(folder.name) + "/" + file);
 
-		std::string projectName = props.project->GetName();
-		std::string configuration = props.project->GetConfiguration().ToString();
+			hasChanged = hasChanged || folderScan.hasChanged;
+			folderFiles.push_back(folderScan.files);
+		}
 
-		auto appPath = std::filesystem::path(projectName) / "Binaries" / configuration / projectName;
-		std::string command = Platform::GetGoCommand(appPath.string());
-		command += " " + props.ConvertArgumetsToString();
+		scanTiming.Stop();
 
-		if (!ExecuteCommand(command, "Failed to launch project. See messages above for more information."))
-			return;
-	}
+		Event("sources").AddNumber("files", (double) scannedFiles.size())
+		                .AddList("added", addedFiles)
+		                .AddList("removed", removedFiles).Emit();
 
-	void CommandHandler::HandleCleanCommand(const CommandHandlerProps& props)
-	{
-		MG_LOG("Clean started...");
+		std::string backend = Application::GetBackend();
+		if (backend != "cmake" && backend != "ninja")
+		{
+			MG_LOG("Unknown backend `" + backend + "` in config.yaml. Use `cmake` or `ninja`.");
+			return false;
+		}
 
-		if (!RequireProjectName(props))
-			return;
+		bool isNinjaBackend = backend == "ninja" && IsSingleTargetProject(props, "The Ninja backend");
 
-		std::array<std::string, 4> removeTargets = {
-				"Build/cmake_install.cmake",
-				"Build/CMakeCache.txt",
-				"Build/CMakeFiles",
-				"Build/Makefile"
-		};
+		std::string fingerprint = GetGenerateFingerprint(props, scannedFiles);
+		bool isGenerated = isNinjaBackend ? IsNinjaBackendBuild(buildPath) :
+		                   std::filesystem::exists("CMakeLists.txt") &&
+		                   std::filesystem::exists(buildPath / "CMakeCache.txt");
 
-		int removedItems = 0;
-		for (const auto& target : removeTargets)
+		if (!hasChanged && isGenerated && fingerprint == Application::GetGenerateFingerprint(buildPath) &&
+		    !props.HasFlag("--force"))
 		{
-			std::filesystem::path path = std::filesystem::path(props.project->GetName()) / target;
-			removedItems += (int) std::filesystem::remove_all(path.generic_string());
+			MG_LOG("Project files are up to date.");
+			return true;
 		}
 
-		if (removedItems == 0)
+		if (isNinjaBackend)
 		{
-			MG_LOG("Looks like your project is already clean. Nice!");
-			return;
-		}
+			Timings::Scope ninjaTiming("Write Ninja files");
+			if (!GenerateNinjaFile(props, scan.files))
+				return false;
 
-		std::stringstream message;
-		message << "Removed " << removedItems << " item" << (removedItems > 1 ? "s" : "") << ".";
+			ninjaTiming.Stop();
 
-		MG_LOG(message.str());
-	}
+			Application::SetGenerateFingerprint(buildPath, fingerprint);
 
-	void CommandHandler::HandlePullCommand(const CommandHandlerProps& props)
-	{
-		std::string nextArgument = props.GetArgument(0);
-		if (nextArgument.empty())
+			MG_LOG("Successfully generated build.ninja. Run `magnet build` next.");
+			return true;
+		}
+
+		Timings::Scope emitTiming("Write CMake files");
+		GenerateRootCMakeFile(props);
+		GenerateCMakeFiles(props, scan.files);
+		GenerateDependencyCMakeFiles(props);
+
+		for (size_t i = 0; i < s_TargetFolders.size(); i++)
 		{
-			std::string command = "git submodule update --init --recursive";
-			if (!ExecuteCommand(command,
-			                    "Failed to install dependencies. See messages above for more information."))
-				return;
+			const auto& folder = s_TargetFolders[i];
+			GenerateFolderTargetsCMakeFile(props, folder.name, folderFiles[i], folder.role);
+		}
 
-			MG_LOG("Successfully installed all dependencies.");
-			HandleGenerateCommand(props);
+		emitTiming.Stop();
+
+		std::vector<std::string> generateCommand = {"cmake", "-S", ".", "-B", buildPath.string()};
+
+		std::vector<std::string> generatorArguments = Platform::GetGenerateArguments(
+				props.project->GetConfiguration().ToString());
+		generateCommand.insert(generateCommand.end(), generatorArguments.begin(), generatorArguments.end());
+		if (!props.project->GetAllocator().empty())
+			generateCommand.push_back("-DMAGNET_ALLOCATOR=" + props.project->GetAllocator());
+
+		std::vector<std::string> forwardedArguments = props.GetForwardedArguments();
+		generateCommand.insert(generateCommand.end(), forwardedArguments.begin(), forwardedArguments.end());
+
+		Timings::Scope configureTiming("CMake configure");
+		if (!ExecuteCommand(generateCommand,
+		                    "CMake failed to generate project files. See messages above for more information."))
+			return false;
+
+		Application::SetGenerateFingerprint(buildPath, fingerprint);
+
+		MG_LOG("Successfully generated project files. Run `magnet build` next.");
+		return true;
+	}
+
+	bool CommandHandler::BuildProject(const CommandHandlerProps& props, uint32_t jobs)
+	{
+		std::string configuration = props.project->GetConfiguration().ToString();
+		MG_LOG("Building in " + configuration + " configuration...");
+
+		if (!RequireProjectName(props))
+			return false;
+
+		if (props.HasFlag("--native") && IsSingleTargetProject(props, "`magnet build --native`"))
+			return BuildProjectNatively(props, jobs);
+
+		if (props.HasFlag("--explain"))
+			ExplainBuild(props);
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		bool isNinjaBackendBuild = IsNinjaBackendBuild(buildPath);
+
+		// The Ninja backend doesn't involve CMake at all, so ninja runs directly.
+		std::vector<std::string> command = {"cmake", "--build", buildPath.string(), "--config", configuration};
+		if (isNinjaBackendBuild)
+			command = {"ninja", "-C", buildPath.string()};
+
+		// Respect an explicit job count, otherwise pick one that fits into memory.
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+		bool hasJobs = std::any_of(arguments.begin(), arguments.end(), [](const std::string& argument)
+		{
+			return argument.rfind("-j", 0) == 0 || argument.rfind("--parallel", 0) == 0;
+		});
+
+		std::string jobsFlag = isNinjaBackendBuild ? "-j" : "--parallel";
+		if (jobs > 0)
+		{
+			command.insert(command.end(), {jobsFlag, std::to_string(jobs)});
+		} else if (!hasJobs)
+		{
+			jobs = GetCompileJobCount();
+			MG_LOG("Using " + std::to_string(jobs) + " parallel jobs (~" +
+			       std::to_string(GetCompileMemoryEstimate()) + " MB per compile).");
+			command.insert(command.end(), {jobsFlag, std::to_string(jobs)});
+		}
+
+		command.insert(command.end(), arguments.begin(), arguments.end());
+
+		// Ninja appends the edges it ran to its log, which `--timings-trace` merges in.
+		std::filesystem::path ninjaLogPath = buildPath / ".ninja_log";
+		std::error_code error;
+		uint64_t ninjaLogSize = std::filesystem::exists(ninjaLogPath) ?
+		                        std::filesystem::file_size(ninjaLogPath, error) : 0;
+
+		// magnet-launcher appends every compile and link of this build to the resource log.
+		std::filesystem::path resourceLogPath = ResourceLog::GetPath(buildPath);
+		uint64_t resourceLogSize = std::filesystem::exists(resourceLogPath) ?
+		                           std::filesystem::file_size(resourceLogPath, error) : 0;
+
+		double buildStart = Timings::GetTime();
+		Timings::Scope buildTiming("Build");
+		bool isBuilt = ExecuteCommand(command, std::string(isNinjaBackendBuild ? "Ninja" : "CMake") +
+		                                       " couldn't build the project. See messages above for more information. Have you tried generating your project files first? If not, run `magnet generate`.");
+		buildTiming.Stop();
+
+		Timings::AddNinjaLog(ninjaLogPath, ninjaLogSize, buildStart);
+
+		Event build("build");
+		build.AddString("configuration", configuration)
+		     .AddNumber("duration_ms", (Timings::GetTime() - buildStart) / 1000.0)
+		     .AddBool("is_successful", isBuilt);
+		if (jobs > 0)
+			build.AddNumber("jobs", jobs);
+		build.Emit();
+
+		if (!isBuilt)
+			return false;
+
+		LearnCompileMemory(buildPath, resourceLogSize);
+
+		if (!CheckBuildBudgets(props, jobs))
+			return false;
+
+		MG_LOG("Build successful. Run `magnet go` to launch your app.");
+
+		PrintLoadCosts(props);
+
+		if (props.HasFlag("--resources"))
+			PrintResourceReport(props);
+
+		return true;
+	}
+
+	void CommandHandler::ExplainBuild(const CommandHandlerProps& props)
+	{
+		Timings::Scope timing("Explain build");
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		RebuildExplanation explanation(buildPath);
+
+		// CMake saves its cache at the end of every configure, and configures again when one of its files is newer.
+		std::filesystem::path cachePath = buildPath / "CMakeCache.txt";
+		if (std::filesystem::exists(cachePath))
+		{
+			std::string projectName = props.project->GetName();
+			std::vector<std::filesystem::path> cmakePaths = {
+					"CMakeLists.txt",
+					std::filesystem::path(projectName) / "Source" / "CMakeLists.txt",
+					std::filesystem::path(projectName) / "Dependencies" / "CMakeLists.txt",
+			};
+
+			for (const auto& folder : s_TargetFolders)
+				cmakePaths.push_back(std::filesystem::path(projectName) / folder.name / "CMakeLists.txt");
+
+			std::error_code error;
+			auto configureTime = std::filesystem::last_write_time(cachePath, error);
+			for (const auto& path : cmakePaths)
+			{
+				if (std::filesystem::exists(path) && std::filesystem::last_write_time(path, error) > configureTime)
+					explanation.AddRewrittenFile(path.generic_string());
+			}
+		}
+
+		if (!std::filesystem::exists(buildPath / "build.ninja"))
+		{
+			explanation.PrintRewrittenFiles();
+			MG_LOG("Only builds with Ninja can explain why files are compiled again. Use the Ninja generator, "
+			       "`backend: ninja` or `--native`.");
+			return;
+		}
+
+		// A dry run only checks which steps are out of date, without running them.
+		ProcessCommand command;
+		command.arguments = {"ninja", "-C", buildPath.string(), "-n", "-d", "explain"};
+		command.output = ProcessOutput::Capture;
+
+		ProcessResult result = Platform::RunCommand(command);
+		if (!result.isStarted)
+		{
+			MG_LOG("Couldn't run ninja to explain the build. Make sure it is installed and in your PATH.");
+			return;
+		}
+
+		explanation.AddNinjaExplanations(result.output);
+		explanation.Print();
+	}
+
+	bool CommandHandler::BuildProjectNatively(const CommandHandlerProps& props, uint32_t jobs)
+	{
+		if (!Application::IsRootLevel())
+		{
+			MG_LOG("In order to build, run this command at the root of your project, where .magnet can be found.");
+			return false;
+		}
+
+		std::string configuration = props.project->GetConfiguration().ToString();
+
+		WriteExportHeaders(props);
+
+		Timings::Scope scanTiming("Scan sources");
+		auto scan = SourceScanner::Scan(std::filesystem::path(props.project->GetName()) / "Source",
+		                                s_SourceIndexPath, s_SourceExtensions);
+		scanTiming.Stop();
+
+		Toolchain toolchain;
+		if (!GetToolchain(props, "`magnet build --native`", toolchain))
+			return false;
+
+		// As many compilers as fit into memory, like with CMake and Ninja.
+		if (jobs == 0)
+		{
+			jobs = GetCompileJobCount();
+			MG_LOG("Using " + std::to_string(jobs) + " parallel jobs (~" +
+			       std::to_string(GetCompileMemoryEstimate()) + " MB per compile).");
+		}
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		RebuildExplanation explanation(buildPath);
+
+		std::error_code error;
+		std::filesystem::path resourceLogPath = ResourceLog::GetPath(buildPath);
+		uint64_t resourceLogSize = std::filesystem::exists(resourceLogPath) ?
+		                           std::filesystem::file_size(resourceLogPath, error) : 0;
+
+		double buildStart = Timings::GetTime();
+		Timings::Scope buildTiming("Build");
+		bool isBuilt = NativeBuilder::Build(toolchain, buildPath, scan.files, jobs,
+		                                    props.HasFlag("--explain") ? &explanation : nullptr);
+		buildTiming.Stop();
+
+		Event("build").AddString("configuration", configuration)
+		              .AddNumber("duration_ms", (Timings::GetTime() - buildStart) / 1000.0)
+		              .AddBool("is_successful", isBuilt)
+		              .AddNumber("jobs", jobs).Emit();
+
+		if (!isBuilt)
+			return false;
+
+		LearnCompileMemory(buildPath, resourceLogSize);
+
+		if (!CheckBuildBudgets(props, jobs))
+			return false;
+
+		MG_LOG("Build successful. Run `magnet go` to launch your app.");
+
+		PrintLoadCosts(props);
+
+		if (props.HasFlag("--resources"))
+			PrintResourceReport(props);
+
+		return true;
+	}
+
+	void CommandHandler::HandleGoCommand(const CommandHandlerProps& props)
+	{
+		uint32_t repeat = 0;
+		uint32_t warmup = 0;
+		if (!props.GetFlagValue("--repeat", repeat) || !props.GetFlagValue("--warmup", warmup) ||
+		    (props.HasFlag("--repeat") && repeat == 0))
+		{
+			MG_LOG("Usage: magnet go [--repeat <n>] [--warmup <k>] [--json <file>] [--counters] [--alloc-profile] "
+			       "[--trace]");
 			return;
 		}
 
+		HandleGenerateCommand(props);
+		HandleBuildCommand(props);
+
+		MG_LOG("Launching project...");
+
 		if (!RequireProjectName(props))
 			return;
 
-		if (nextArgument == "--list")
+		std::string projectName = props.project->GetName();
+		std::string configuration = props.project->GetConfiguration().ToString();
+
+		std::string launchTarget = props.project->GetLaunchTargetName();
+		if (launchTarget.empty())
 		{
-			HandlePullListCommand(props);
+			MG_LOG("There is nothing to launch, since the project has no executable target.");
 			return;
 		}
 
-		if (nextArgument == "--help")
+		if (repeat > 0)
 		{
-			MG_LOGNH("Usage: magnet pull <url>");
-			MG_LOGNH("       magnet pull --list");
+			MeasureLaunches(props, GetTargetBinaryPath(props, launchTarget), repeat, warmup);
 			return;
 		}
 
-		// If the user didn't provide a full URL, we'll assume it's a GitHub repository.
-		if (nextArgument.find("https://") != 0)
+		if (props.HasFlag("--counters"))
 		{
-			nextArgument = "https://github.com/" + nextArgument;
+			CountLaunch(props, GetTargetBinaryPath(props, launchTarget));
+			return;
 		}
 
-		std::string name = ExtractRepositoryName(nextArgument);
-		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
-		                                    name;
-		std::string command = "git submodule add " + nextArgument + " " + installPath.string();
+		if (props.HasFlag("--alloc-profile"))
+		{
+			ProfileAllocations(props, GetTargetBinaryPath(props, launchTarget));
+			return;
+		}
 
-		if (!ExecuteCommand(command,
-		                    "Failed to install dependency. See messages above for more information."))
+		if (props.HasFlag("--trace"))
+		{
+			TraceLaunch(props, GetTargetBinaryPath(props, launchTarget));
 			return;
+		}
 
-		auto dependencies = Application::GetDependencies();
-		dependencies.push_back(name);
-		WriteDependencyFile(dependencies);
+		std::filesystem::path executable = GetTargetBinaryPath(props, launchTarget);
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
 
-		MG_LOG("Installed new dependency: " + name);
+		std::vector<std::string> command = {executable.string()};
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+		command.insert(command.end(), arguments.begin(), arguments.end());
 
-		HandleGenerateCommand(props);
+		Timings::Scope launchTiming("Launch");
+		if (!ExecuteCommand(command, "Failed to launch project. See messages above for more information."))
+			return;
 	}
 
-	void CommandHandler::HandlePullListCommand([[maybe_unused]] const CommandHandlerProps& props)
+	void CommandHandler::MeasureLaunches(const CommandHandlerProps& props, std::filesystem::path executable,
+	                                     uint32_t repeat, uint32_t warmup)
 	{
-		auto dependencies = Application::GetDependencies();
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
 
-		if (dependencies.empty())
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+
+		std::vector<CounterGroup> counterGroups;
+		if (props.HasFlag("--counters"))
+			counterGroups = GetCounterGroups();
+
+		// The output of the project is discarded, so that writing to the terminal isn't part of the measurement.
+		std::vector<ProcessStats> runs;
+		for (uint32_t i = 0; i < warmup + repeat; i++)
 		{
-			MG_LOG("No dependencies installed.");
-			return;
+			bool isWarmup = i < warmup;
+			if (isWarmup)
+				MG_LOG("Warming up (" + std::to_string(i + 1) + " of " + std::to_string(warmup) + ")...");
+			else
+				MG_LOG("Running " + std::to_string(i - warmup + 1) + " of " + std::to_string(repeat) + "...");
+
+			ProcessStats stats;
+			if (!Platform::RunProcess(executable, arguments, true, stats, counterGroups))
+			{
+				MG_LOG("Failed to launch " + executable.string() + ".");
+				return;
+			}
+
+			if (stats.exitCode != 0)
+			{
+				MG_LOG("The project exited with code " + std::to_string(stats.exitCode) + ", so it isn't measured. "
+				       "Run `magnet go` to see its output.");
+				return;
+			}
+
+			Event("run").AddString("executable", executable.string())
+			            .AddBool("is_warmup", isWarmup)
+			            .AddNumber("wall_ns", stats.wallTime)
+			            .AddNumber("user_ns", stats.userTime)
+			            .AddNumber("system_ns", stats.systemTime)
+			            .AddNumber("peak_memory_bytes", (double) stats.peakMemory).Emit();
+
+			if (!isWarmup)
+				runs.push_back(stats);
 		}
 
-		MG_LOG("Here are all the installed dependencies:");
+		auto collect = [&runs](const std::function<double(const ProcessStats&)>& getValue)
+		{
+			std::vector<double> values;
+			for (const auto& run : runs)
+				values.push_back(getValue(run));
+			return values;
+		};
 
-		for (auto& package : dependencies)
-			MG_LOGNH(package);
-	}
+		struct Row
+		{
+			const char* name;
+			std::vector<double> values;
+			std::function<std::string(double)> format;
+		};
 
-	void CommandHandler::HandleRemoveCommand(const CommandHandlerProps& props)
-	{
-		std::string dependency = props.GetArgument(0);
-		if (dependency.empty())
+		std::vector<Row> rows = {
+				{"Wall time",   collect([](const ProcessStats& stats) { return stats.wallTime; }),   FormatDuration},
+				{"User time",   collect([](const ProcessStats& stats) { return stats.userTime; }),   FormatDuration},
+				{"System time", collect([](const ProcessStats& stats) { return stats.systemTime; }), FormatDuration},
+				{"Peak memory", collect([](const ProcessStats& stats) { return (double) stats.peakMemory; }),
+				 FormatBytes},
+		};
+
+		MG_LOGNH("");
+		MG_LOG("Launched " + executable.filename().string() + " " + std::to_string(repeat) + " times:");
+
+		std::ostringstream header;
+		header << std::left << std::setw(14) << "" << std::right << std::setw(12) << "Min" << std::setw(12)
+		       << "Median" << std::setw(12) << "p95" << std::setw(12) << "Max";
+		MG_LOGNH(header.str());
+
+		for (const auto& row : rows)
 		{
-			MG_LOG("Usage: magnet remove <dependency>");
-			return;
+			const auto& values = row.values;
+
+			std::ostringstream line;
+			line << std::left << std::setw(14) << row.name << std::right
+			     << std::setw(12) << row.format(*std::min_element(values.begin(), values.end()))
+			     << std::setw(12) << row.format(Statistics::Median(values))
+			     << std::setw(12) << row.format(Statistics::Percentile(values, 95.0))
+			     << std::setw(12) << row.format(*std::max_element(values.begin(), values.end()));
+			MG_LOGNH(line.str());
 		}
 
-		if (!RequireProjectName(props))
-			return;
+		if (!counterGroups.empty())
+		{
+			std::vector<std::vector<CounterValue>> counters;
+			for (const auto& run : runs)
+				counters.push_back(run.counters);
 
-		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
-		                                    dependency;
-		std::string deinitCommand = "git submodule deinit -f " + installPath.string();
+			MG_LOGNH("");
+			MG_LOG("Median of the performance counters:");
+			PrintCounters(AggregateCounters(counters), counterGroups);
+		}
 
-		if (!ExecuteCommand(deinitCommand,
-		                    "Failed to remove dependency. See messages above for more information."))
+		std::string jsonPath = props.GetFlagValue("--json");
+		if (jsonPath.empty())
 			return;
 
-		std::string gitRemoveCommand = "git rm -f " + installPath.string();
-		if (!ExecuteCommand(gitRemoveCommand,
-		                    "Failed to remove dependency. See messages above for more information."))
+		JsonWriter out;
+		out.BeginObject();
+		out.Key("command").String(executable.string());
+
+		out.Key("arguments").BeginArray();
+		for (const auto& argument : arguments)
+			out.String(argument);
+		out.EndArray();
+
+		out.Key("warmup").Number(warmup);
+		out.Key("runs").BeginArray();
+
+		for (const auto& run : runs)
+		{
+			out.BeginObject();
+			out.Key("wall_ns").Number(run.wallTime);
+			out.Key("user_ns").Number(run.userTime);
+			out.Key("system_ns").Number(run.systemTime);
+			out.Key("peak_memory_bytes").Number(run.peakMemory);
+
+			if (!run.counters.empty())
+			{
+				out.Key("counters").BeginObject();
+				for (const auto& counter : run.counters)
+					out.Key(counter.event).Number(counter.value);
+				out.EndObject();
+			}
+
+			out.EndObject();
+		}
+
+		out.EndArray();
+		out.EndObject();
+
+		std::ofstream file(jsonPath);
+		file << out.GetString() << "\n";
+		if (!file)
+		{
+			MG_LOG("Failed to write " + jsonPath + ".");
 			return;
+		}
 
-		std::filesystem::path gitModulesPath = std::filesystem::path(props.project->GetName()) / ".git" /
-		                                       "modules" / installPath;
-		std::string removeGitModuleCommand = "rm -rf " + gitModulesPath.string();
-		if (!ExecuteCommand(removeGitModuleCommand,
-		                    "Failed to remove dependency. See messages above for more information."))
+		MG_LOG("Wrote every run to " + jsonPath + ".");
+	}
+
+	void CommandHandler::CountLaunch(const CommandHandlerProps& props, std::filesystem::path executable)
+	{
+		std::vector<CounterGroup> counterGroups = GetCounterGroups();
+		if (counterGroups.empty())
 			return;
 
-		auto dependencies = Application::GetDependencies();
-		dependencies.erase(std::remove(dependencies.begin(), dependencies.end(), dependency),
-		                   dependencies.end());
-		WriteDependencyFile(dependencies);
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
 
-		MG_LOG("Removed dependency: " + dependency);
+		ProcessStats stats;
+		if (!Platform::RunProcess(executable, props.GetForwardedArguments(), false, stats, counterGroups))
+		{
+			MG_LOG("Failed to launch " + executable.string() + ".");
+			return;
+		}
 
-		HandleGenerateCommand(props);
+		MG_LOGNH("");
+		if (stats.exitCode != 0)
+			MG_LOG("The project exited with code " + std::to_string(stats.exitCode) + ".");
+
+		MG_LOG("Performance counters of " + executable.filename().string() + ":");
+		PrintCounters(stats.counters, counterGroups);
 	}
 
-	void CommandHandler::HandleSwitchCommand(const CommandHandlerProps& props)
+	void CommandHandler::TraceLaunch(const CommandHandlerProps& props, std::filesystem::path executable)
 	{
-		std::string dependency = props.GetArgument(0);
-		std::string branch = props.GetArgument(1);
+		std::vector<std::string> configurations = Application::GetTracingConfigurations();
+		std::string configuration = props.project->GetConfiguration().ToString();
+		if (std::find(configurations.begin(), configurations.end(), configuration) == configurations.end())
+			MG_LOG(configuration + " isn't listed under `tracing` in config.yaml, so MagnetTrace.h records nothing "
+			                       "in it.");
+
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
+
+		std::filesystem::path profilePath = std::filesystem::absolute(GetProfilePath(*props.project));
+		std::filesystem::create_directories(profilePath);
+		std::filesystem::path tracePath = profilePath / "trace.json";
+
+		// MagnetTrace.h writes the trace when the project exits.
+		ProcessCommand command;
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+		command.arguments = {executable.string()};
+		command.arguments.insert(command.arguments.end(), arguments.begin(), arguments.end());
+		command.environment = {{"MAGNET_TRACE", tracePath.string()}};
+
+		ProcessResult result = Platform::RunCommand(command);
+		if (!result.isStarted)
+		{
+			MG_LOG("Failed to launch " + executable.string() + ".");
+			std::filesystem::remove_all(profilePath);
+			return;
+		}
 
-		if (dependency.empty() || branch.empty())
+		MG_LOGNH("");
+		if (result.stats.exitCode != 0)
+			MG_LOG("The project exited with code " + std::to_string(result.stats.exitCode) + ".");
+
+		if (!std::filesystem::exists(tracePath))
 		{
-			MG_LOG("Usage: magnet switch <dependency> <branch>");
+			MG_LOG("No trace was written. Include MagnetTrace.h, mark code with MG_TRACE_SCOPE and build a "
+			       "configuration listed under `tracing` in config.yaml. The trace is written when the project "
+			       "exits normally.");
+			std::filesystem::remove_all(profilePath);
 			return;
 		}
 
-		if (!RequireProjectName(props))
+		MG_LOG("Wrote " + tracePath.string() + ". Open it in https://ui.perfetto.dev or chrome://tracing.");
+	}
+
+	void CommandHandler::ProfileAllocations(const CommandHandlerProps& props, std::filesystem::path executable)
+	{
+		std::filesystem::path shimPath = Platform::GetAllocationShimPath();
+		if (shimPath.empty())
+		{
+			MG_LOG("Allocation profiling is only supported on Linux.");
 			return;
+		}
 
-		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
-		                                    dependency;
-		std::string command = "git -C " + installPath.string() + " checkout " + branch;
-		if (!ExecuteCommand(command,
-		                    "Failed to switch dependency branch. See messages above for more information."))
+		if (!std::filesystem::exists(shimPath))
+		{
+			MG_LOG("Couldn't find " + shimPath.string() + ". It's built together with Magnet.");
 			return;
+		}
 
-		std::string gitAddCommand = "git add " + installPath.string();
-		if (!ExecuteCommand(gitAddCommand,
-		                    "Failed to switch dependency branch. See messages above for more information."))
+		if (props.project->GetConfiguration().ToString() == "Release")
+			MG_LOG("Release builds omit frame pointers, so call stacks will be cut short. Run `magnet config "
+			       "Profile` to get complete ones.");
+
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
+
+		std::filesystem::path profilePath = std::filesystem::absolute(GetProfilePath(*props.project));
+		std::filesystem::create_directories(profilePath);
+
+		// Every process that inherits the environment writes its own report, named after its process id. Libraries
+		// the user already preloads stay loaded.
+		std::string preload = shimPath.string();
+		if (const char* userPreload = std::getenv("LD_PRELOAD"); userPreload && *userPreload)
+			preload += std::string(":") + userPreload;
+
+		ProcessCommand command;
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+		command.arguments = {executable.string()};
+		command.arguments.insert(command.arguments.end(), arguments.begin(), arguments.end());
+		command.environment = {{"MAGNET_ALLOC_PROFILE", profilePath.string()}, {"LD_PRELOAD", preload}};
+
+		ProcessResult result = Platform::RunCommand(command);
+		if (!result.isStarted)
+		{
+			MG_LOG("Failed to launch " + executable.string() + ".");
+			std::filesystem::remove_all(profilePath);
 			return;
+		}
 
-		MG_LOG("Switched " + dependency + " branch to: " + branch);
+		MG_LOGNH("");
+		if (result.stats.exitCode != 0)
+			MG_LOG("The project exited with code " + std::to_string(result.stats.exitCode) + ".");
+
+		// Child processes of the project are profiled too. The report of the project itself is the one of its
+		// executable with the most allocations.
+		std::vector<AllocationProfile> profiles;
+		for (const auto& entry : std::filesystem::directory_iterator(profilePath))
+		{
+			AllocationProfile profile = AllocationProfile::Load(entry.path());
+			if (profile.isValid)
+				profiles.push_back(std::move(profile));
+		}
+
+		std::error_code error;
+		auto isProject = [&executable, &error](const AllocationProfile& profile)
+		{
+			return std::filesystem::equivalent(profile.executable, executable, error);
+		};
+
+		auto project = std::max_element(profiles.begin(), profiles.end(),
+		                                [&isProject](const AllocationProfile& a, const AllocationProfile& b)
+		                                {
+			                                return std::make_pair(isProject(a), a.allocations) <
+			                                       std::make_pair(isProject(b), b.allocations);
+		                                });
+		if (project == profiles.end() || !isProject(*project))
+		{
+			MG_LOG("No allocations were recorded. Statically linked executables can't be profiled, since they "
+			       "don't load the preloaded library.");
+			std::filesystem::remove_all(profilePath);
+			return;
+		}
+
+		PrintAllocationProfile(*project);
+
+		if (profiles.size() > 1)
+			MG_LOG(std::to_string(profiles.size() - 1) + " child processes were profiled as well.");
+
+		MG_LOG("The raw reports are in " + profilePath.string() + ".");
+	}
+
+	void CommandHandler::PrintAllocationProfile(const AllocationProfile& profile)
+	{
+		static constexpr size_t s_TopSiteCount = 15;
+		static constexpr size_t s_FramesPerSite = 4;
+		static constexpr size_t s_TimelineRows = 20;
+		static constexpr size_t s_TimelineWidth = 50;
+
+		MG_LOG("Allocations of " + profile.executable.filename().string() + ":");
+
+		std::vector<std::pair<const char*, std::string>> totals = {
+				{"Allocations",  FormatCount((double) profile.allocations)},
+				{"Frees",        FormatCount((double) profile.frees)},
+				{"Allocated",    FormatBytes((double) profile.allocatedBytes)},
+				{"Peak heap",    FormatBytes((double) profile.peakBytes)},
+				{"Live at exit", FormatBytes((double) std::max<int64_t>(profile.liveBytes, 0))},
+		};
+
+		for (const auto& [name, value] : totals)
+		{
+			std::ostringstream line;
+			line << std::left << std::setw(16) << name << std::right << std::setw(14) << value;
+			MG_LOGNH(line.str());
+		}
+
+		// Frames inside of the shim itself are dropped, so that every site starts at its caller.
+		std::map<std::string, ElfFile> files;
+		std::unordered_map<uint64_t, std::string> names;
+		auto isShim = [&profile](uint64_t address)
+		{
+			return std::any_of(profile.mappings.begin(), profile.mappings.end(), [address](const MappedFile& file)
+			{
+				return address >= file.start && address < file.end &&
+				       file.path.find("magnet-alloc-shim") != std::string::npos;
+			});
+		};
+
+		// Containers and strings of the standard library allocate on behalf of their caller, which is the
+		// interesting frame. Unoptimized builds don't inline them, so they would take up the whole stack.
+		auto isStandardLibrary = [](const std::string& name)
+		{
+			size_t nameEnd = name.find('(');
+			for (const char* prefix : {"std::", "__gnu_cxx::"})
+			{
+				// Templates are demangled with their return type first.
+				size_t position = name.find(prefix);
+				if (position < nameEnd && (position == 0 || name[position - 1] == ' '))
+					return true;
+			}
+
+			return false;
+		};
+
+		// Sites with the same call stack after symbolization, e.g. from different return addresses in one
+		// function, are merged.
+		std::map<std::string, std::pair<uint64_t, uint64_t>> sites;
+		for (const auto& site : profile.sites)
+		{
+			std::string stack;
+			std::string innermost;
+			size_t frameCount = 0;
+			for (size_t i = 0; i < site.frames.size() && frameCount < s_FramesPerSite; i++)
+			{
+				if (isShim(site.frames[i]))
+					continue;
+
+				// Return addresses point behind the call, which might already be the next function.
+				uint64_t address = site.frames[i] - 1;
+
+				auto name = names.find(address);
+				if (name == names.end())
+					name = names.emplace(address, Symbolize(address, profile.mappings, files)).first;
+
+				if (isStandardLibrary(name->second))
+				{
+					innermost = innermost.empty() ? name->second : innermost;
+					continue;
+				}
+
+				stack += (frameCount++ == 0 ? "" : " <- ") + name->second;
+			}
+
+			if (stack.empty())
+				stack = innermost;
+
+			auto& totalsOfSite = sites[stack.empty() ? "[unknown]" : stack];
+			totalsOfSite.first += site.count;
+			totalsOfSite.second += site.bytes;
+		}
+
+		std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> ranking(sites.begin(), sites.end());
+		std::sort(ranking.begin(), ranking.end(), [](const auto& a, const auto& b)
+		{
+			return a.second.first > b.second.first;
+		});
+
+		MG_LOGNH("");
+		MG_LOG("Top allocation sites, estimated from one sample per " + FormatBytes((double) profile.sampleBytes) +
+		       " allocated:");
+
+		std::ostringstream header;
+		header << std::right << std::setw(14) << "Allocations" << std::setw(12) << "Bytes" << "  " << "Call stack";
+		MG_LOGNH(header.str());
+
+		for (size_t i = 0; i < std::min(ranking.size(), s_TopSiteCount); i++)
+		{
+			const auto& [stack, estimate] = ranking[i];
+
+			std::ostringstream line;
+			line << std::right << std::setw(14) << FormatCount((double) estimate.first) << std::setw(12)
+			     << FormatBytes((double) estimate.second) << "  " << stack;
+			MG_LOGNH(line.str());
+		}
+
+		if (profile.droppedSamples > 0)
+			MG_LOG(std::to_string(profile.droppedSamples) + " samples were dropped, since there were too many "
+			       "distinct call stacks.");
+
+		if (profile.timeline.empty() || profile.peakBytes <= 0)
+			return;
+
+		// The timeline is shown in equal steps, each with the highest heap size reached during it.
+		uint64_t duration = profile.timeline.back().time;
+		uint64_t step = std::max<uint64_t>(1, (duration + s_TimelineRows - 1) / s_TimelineRows);
+
+		MG_LOGNH("");
+		MG_LOG("Peak heap over time:");
+
+		// Steps without a snapshot had no sampled allocations, so the heap size stayed at the previous one.
+		size_t point = 0;
+		int64_t live = 0;
+		for (uint64_t start = 0; start <= duration && point < profile.timeline.size(); start += step)
+		{
+			int64_t peak = live;
+			while (point < profile.timeline.size() && profile.timeline[point].time < start + step)
+			{
+				peak = std::max(peak, profile.timeline[point].peakBytes);
+				live = profile.timeline[point++].liveBytes;
+			}
+
+			auto width = (size_t) std::llround((double) s_TimelineWidth * (double) std::max<int64_t>(peak, 0) /
+			                                   (double) profile.peakBytes);
+
+			std::ostringstream line;
+			line << std::right << std::setw(10) << std::to_string(start) + " ms" << "  " << std::left
+			     << std::setw((int) s_TimelineWidth) << std::string(width, '#') << "  "
+			     << FormatBytes((double) std::max<int64_t>(peak, 0));
+			MG_LOGNH(line.str());
+		}
+	}
+
+	void CommandHandler::HandleTestCommand(const CommandHandlerProps& props)
+	{
+		if (!RequireProjectName(props))
+			return;
+
+		uint32_t shardIndex = 0;
+		uint32_t shardCount = 1;
+
+		std::string shard = props.GetFlagValue("--shard");
+		if (props.HasFlag("--shard"))
+		{
+			char separator = 0;
+			std::istringstream stream(shard);
+			if (!(stream >> shardIndex >> separator >> shardCount) || separator != '/' || shardIndex == 0 ||
+			    shardIndex > shardCount)
+			{
+				MG_LOG("Usage: magnet test --shard <i>/<n>, where 1 <= i <= n.");
+				return;
+			}
+
+			shardIndex--;
+		}
+
+		uint32_t buildJobs = 0;
+		if (!props.GetFlagValue("--jobs", buildJobs))
+		{
+			MG_LOG("Usage: magnet test --jobs <n>");
+			return;
+		}
+
+		// Running the tests of a failed build would only report stale results.
+		if (!GenerateProject(props) || !BuildProject(props, buildJobs))
+			return;
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		std::string configuration = props.project->GetConfiguration().ToString();
+
+		// CTest keeps its own history in the build folder, but that is lost on a clean or a fresh checkout.
+		auto history = TestHistory::Load();
+		history.WriteCostData(buildPath);
+
+		uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::string> command = {"ctest", "--test-dir", buildPath.string(), "-C", configuration,
+		                                    "--output-on-failure", "-j", std::to_string(jobs)};
+
+		if (shardCount > 1)
+		{
+			auto tests = history.GetShard(GetTargetNames(props, TargetRole::Test), shardIndex, shardCount);
+			if (tests.empty())
+			{
+				MG_LOG("Shard " + shard + " has no tests to run.");
+				return;
+			}
+
+			std::string regex = std::accumulate(std::next(tests.begin()), tests.end(), EscapeRegex(tests.front()),
+			                                    [](const std::string& a, const std::string& b)
+			                                    {
+				                                    return a + "|" + EscapeRegex(b);
+			                                    });
+
+			command.insert(command.end(), {"-R", "^(" + regex + ")$"});
+
+			MG_LOG("Running shard " + shard + " with " + std::to_string(tests.size()) + " test" +
+			       (tests.size() > 1 ? "s" : "") + "...");
+		}
+
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+		command.insert(command.end(), arguments.begin(), arguments.end());
+
+		bool isSuccessful = ExecuteCommand(command, "Some tests failed. See messages above for more information.");
+
+		history.ReadCostData(buildPath);
+		history.Save();
+
+		auto slowestTests = history.GetSlowestTests(5);
+		if (!slowestTests.empty())
+		{
+			MG_LOG("Slowest tests:");
+			for (const auto& [name, duration] : slowestTests)
+			{
+				std::ostringstream line;
+				line << std::fixed << std::setprecision(2) << std::setw(10) << duration << " s  " << name;
+				MG_LOGNH(line.str());
+			}
+		}
+
+		if (isSuccessful)
+			MG_LOG("All tests passed.");
+	}
+
+	void CommandHandler::HandleBenchCommand(const CommandHandlerProps& props)
+	{
+		if (!RequireProjectName(props))
+			return;
+
+		uint32_t repetitions = s_DefaultBenchmarkRepetitions;
+		uint32_t warmup = s_DefaultBenchmarkWarmup;
+		uint32_t jobs = 0;
+		std::vector<std::string> allocators = Split(props.GetFlagValue("--allocators"), ',');
+		if (!props.GetFlagValue("--repetitions", repetitions) || !props.GetFlagValue("--warmup", warmup) ||
+		    !props.GetFlagValue("--jobs", jobs) || repetitions == 0 ||
+		    (props.HasFlag("--against") && props.GetFlagValue("--against").empty()) ||
+		    (props.HasFlag("--allocators") && (allocators.empty() || props.HasFlag("--against"))))
+		{
+			MG_LOG("Usage: magnet bench [--against <ref> | --allocators <a,b,...>] [--repetitions <n>] "
+			       "[--warmup <n>] [--filter <regex>] [--counters]");
+			return;
+		}
+
+		for (const auto& allocator : allocators)
+		{
+			if (!RequireAllocator(allocator))
+				return;
+		}
+
+		// Benchmarks always run optimized, with frame pointers so that they can be profiled as they are.
+		Project project = *props.project;
+		project.SetConfiguration(Configuration::FromString("Profile"));
+
+		CommandHandlerProps profileProps = props;
+		profileProps.project = &project;
+
+		// The other revision is built by a second Magnet in its worktree, at the same time as this one.
+		std::string against = props.GetFlagValue("--against");
+		Revision baseline;
+		std::thread baselineBuild;
+		bool isBaselineBuilt = false;
+
+		if (!against.empty())
+		{
+			baseline = PrepareRevision(against);
+			if (baseline.commit.empty())
+				return;
+
+			jobs = std::max(1u, (jobs > 0 ? jobs : GetCompileJobCount()) / 2);
+
+			MG_LOG("Building " + against + " (" + baseline.commit + ") in " + baseline.worktreePath.string() +
+			       "...");
+			baselineBuild = std::thread([&baseline, jobs, &isBaselineBuilt]()
+			                            {
+				                            isBaselineBuilt = BuildRevision(baseline, jobs);
+			                            });
+		}
+
+		// Every allocator is built into folders of its own, one after the other.
+		std::vector<BenchmarkBuild> builds;
+		std::vector<Project> allocatorProjects(allocators.size(), project);
+		for (size_t i = 0; i < allocators.size(); i++)
+		{
+			allocatorProjects[i].SetAllocator(allocators[i]);
+
+			CommandHandlerProps allocatorProps = props;
+			allocatorProps.project = &allocatorProjects[i];
+			builds.push_back({allocatorProps, ""});
+		}
+
+		if (allocators.empty())
+			builds.push_back({profileProps, ""});
+
+		bool isBuilt = true;
+		for (const auto& build : builds)
+		{
+			if (!build.props.project->GetAllocator().empty())
+				MG_LOG("Building with " + build.props.project->GetAllocator() + "...");
+
+			if (!GenerateProject(build.props) || !BuildProject(build.props, jobs))
+			{
+				isBuilt = false;
+				break;
+			}
+		}
+
+		if (baselineBuild.joinable())
+			baselineBuild.join();
+
+		if (!against.empty() && !isBaselineBuilt)
+		{
+			PrintRevisionBuildLog(baseline);
+			MG_LOG("Failed to build " + against + ". See messages above for more information.");
+		}
+
+		if (!isBuilt || (!against.empty() && !isBaselineBuilt) || props.HasFlag("--build-only"))
+		{
+			RemoveRevision(baseline);
+			return;
+		}
+
+		auto benchmarks = GetTargetNames(profileProps, TargetRole::Benchmark);
+		if (benchmarks.empty())
+		{
+			MG_LOG("There are no benchmarks yet. Create a Benchmarks folder next to Source, in which every .cpp file "
+			       "and every subfolder becomes a benchmark. See MagnetBench.h for a minimal harness.");
+			RemoveRevision(baseline);
+			return;
+		}
+
+		for (const auto& warning : Platform::GetBenchmarkWarnings())
+			MG_LOG("Warning: " + warning);
+
+		// The smallest possible p-value of the Mann-Whitney U test depends on the number of samples.
+		if (repetitions < 4)
+			MG_LOG("Warning: With fewer than 4 repetitions, no difference can be statistically significant.");
+
+		if (!against.empty())
+			builds.push_back({profileProps, baseline.projectPath});
+
+		std::vector<CounterGroup> counterGroups;
+		if (props.HasFlag("--counters"))
+			counterGroups = GetCounterGroups();
+
+		std::vector<CounterResults> counters;
+		auto samples = RunBenchmarks(builds, benchmarks, repetitions, warmup,
+		                             props.GetFlagValue("--filter"), counterGroups, &counters);
+
+		RemoveRevision(baseline);
+
+		// Counters cover the whole executable, including finding the number of iterations, so only the ratios
+		// between them carry over to the benchmarks.
+		for (size_t i = 0; i < counters.size(); i++)
+		{
+			for (const auto& [name, values] : counters[i])
+			{
+				MG_LOGNH("");
+				const std::string& allocator = builds[i].props.project->GetAllocator();
+				std::string label = !allocator.empty() ? " with " + allocator : i > 0 ? " at " + baseline.commit : "";
+
+				MG_LOG("Performance counters of `" + name + "`" + label + ":");
+				PrintCounters(values, counterGroups);
+			}
+		}
+
+		BenchmarkRun run;
+		run.commit = GetGitRevision(run.isDirty);
+		run.samples = samples[0];
+
+		std::time_t now = std::time(nullptr);
+		std::ostringstream date;
+		date << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S");
+		run.date = date.str();
+
+		if (run.samples.empty())
+		{
+			MG_LOG("No benchmark results were recorded.");
+			return;
+		}
+
+		// Every allocator is compared to the first one, e.g. to the system's. Like side by side comparisons, these
+		// don't become part of the history.
+		if (!allocators.empty())
+		{
+			BenchmarkRun firstRun;
+			firstRun.commit = allocators[0];
+			firstRun.samples = samples[0];
+
+			if (allocators.size() == 1)
+				PrintBenchmarkComparison(BenchmarkRun(), firstRun);
+
+			for (size_t i = 1; i < allocators.size(); i++)
+			{
+				BenchmarkRun allocatorRun;
+				allocatorRun.commit = allocators[i];
+				allocatorRun.samples = samples[i];
+
+				PrintBenchmarkComparison(firstRun, allocatorRun);
+			}
+
+			return;
+		}
+
+		// Side by side comparisons are one-offs, only regular runs become part of the history.
+		if (!against.empty())
+		{
+			BenchmarkRun baselineRun;
+			baselineRun.commit = baseline.commit;
+			baselineRun.samples = samples[1];
+
+			PrintBenchmarkComparison(baselineRun, run);
+			return;
+		}
+
+		auto history = BenchmarkHistory::Load();
+
+		const BenchmarkRun* previousRun = history.GetLatestRun();
+		PrintBenchmarkComparison(previousRun ? *previousRun : BenchmarkRun(), run);
+
+		history.AddRun(run);
+		history.Save();
+	}
+
+	void CommandHandler::HandleBisectPerfCommand(const CommandHandlerProps& props)
+	{
+		std::string good = props.GetArgument(0);
+		std::string bad = props.GetArgument(1);
+		std::string benchmark = props.GetArgument(2);
+		std::string threshold = props.GetArgument(3);
+
+		// The threshold is either a time per iteration or a slowdown relative to the good revision.
+		bool isRelative = !threshold.empty() && threshold.back() == '%';
+		double thresholdValue = 0.0;
+		bool isValidThreshold = isRelative ? ParseDuration(threshold.substr(0, threshold.size() - 1), thresholdValue)
+		                                   : ParseDuration(threshold, thresholdValue);
+
+		uint32_t repetitions = s_DefaultBisectRepetitions;
+		uint32_t warmup = s_DefaultBenchmarkWarmup;
+		size_t separator = benchmark.find('/');
+		if (!isValidThreshold || separator == std::string::npos || !props.GetFlagValue("--repetitions", repetitions) ||
+		    !props.GetFlagValue("--warmup", warmup) || repetitions == 0)
+		{
+			MG_LOG("Usage: magnet bisect-perf <good> <bad> <executable>/<benchmark> <threshold> [--repetitions <n>]");
+			MG_LOGNH("The threshold is a time per iteration, e.g. 1.5us, or a slowdown compared to <good>, e.g. 10%.");
+			return;
+		}
+
+		if (!RequireProjectName(props))
+			return;
+
+		std::string output;
+		if (CaptureCommand({"git", "bisect", "log"}, output))
+		{
+			MG_LOG("A git bisect is already in progress. Finish it with `git bisect reset` first.");
+			return;
+		}
+
+		std::string executable = benchmark.substr(0, separator);
+		std::string filter = "^" + EscapeRegex(benchmark.substr(separator + 1)) + "$";
+
+		Project project = *props.project;
+		project.SetConfiguration(Configuration::FromString("Profile"));
+
+		CommandHandlerProps profileProps = props;
+		profileProps.project = &project;
+
+		// Every revision is built in a fresh worktree, so a compiler cache saves most of the work. Relative paths
+		// let revisions share cache entries even though their worktrees are in different folders.
+		std::string ccacheVersion;
+		if (CaptureCommand({"ccache", "--version"}, ccacheVersion))
+		{
+			Platform::SetEnvironment("CMAKE_CXX_COMPILER_LAUNCHER", "ccache");
+			Platform::SetEnvironment("CCACHE_BASEDIR", GetWorktreesPath().string());
+			Platform::SetEnvironment("CCACHE_NOHASHDIR", "true");
+		} else
+		{
+			MG_LOG("Tip: Install ccache to make building every revision a lot faster.");
+		}
+
+		struct Step
+		{
+			std::string commit;
+			std::vector<double> samples;
+			std::string verdict;
+		};
+
+		std::vector<Step> steps;
+		auto measure = [&](const std::string& reference) -> Step&
+		{
+			Step& step = steps.emplace_back();
+
+			Revision revision = PrepareRevision(reference);
+			step.commit = revision.commit.empty() ? reference : revision.commit;
+
+			if (!revision.commit.empty())
+			{
+				MG_LOG("Measuring " + benchmark + " at " + revision.commit + "...");
+
+				if (BuildRevision(revision, 0))
+				{
+					auto samples = RunBenchmarks({{profileProps, revision.projectPath}}, {executable}, repetitions,
+					                             warmup, filter);
+					step.samples = samples[0][benchmark];
+				} else
+				{
+					PrintRevisionBuildLog(revision);
+					MG_LOG("Failed to build " + revision.commit + ".");
+				}
+			}
+
+			RemoveRevision(revision);
+			return step;
+		};
+
+		// Both ends are measured first, to make sure the regression can be told apart at all.
+		double goodMedian = Statistics::Median(measure(good).samples);
+		double badMedian = Statistics::Median(measure(bad).samples);
+		steps[0].verdict = "good";
+		steps[1].verdict = "bad";
+
+		if (steps[0].samples.empty() || steps[1].samples.empty())
+		{
+			MG_LOG("Couldn't measure " + benchmark + " at both " + good + " and " + bad + ".");
+			return;
+		}
+
+		double limit = isRelative ? goodMedian * (1.0 + thresholdValue / 100.0) : thresholdValue;
+		if (goodMedian > limit || badMedian <= limit)
+		{
+			MG_LOG(benchmark + " takes " + FormatDuration(goodMedian) + " at " + good + " and " +
+			       FormatDuration(badMedian) + " at " + bad + ", so the threshold of " + FormatDuration(limit) +
+			       " doesn't separate them.");
+			return;
+		}
+
+		MG_LOG("Revisions slower than " + FormatDuration(limit) + " count as bad.");
+
+		// Without checking out, git only moves BISECT_HEAD and the working tree stays untouched.
+		if (!ExecuteCommand({"git", "bisect", "start", "--no-checkout", steps[1].commit, steps[0].commit},
+		                    "Failed to start git bisect. See messages above for more information."))
+			return;
+
+		std::string firstBadCommit;
+		while (steps.size() < s_MaxBisectSteps)
+		{
+			std::string commit;
+			if (!CaptureCommand({"git", "rev-parse", "--short", "BISECT_HEAD"}, commit))
+				break;
+
+			Step& step = measure(TrimEnd(commit));
+			if (step.samples.empty())
+				step.verdict = "skip";
+			else
+				step.verdict = Statistics::Median(step.samples) > limit ? "bad" : "good";
+
+			CaptureCommand({"git", "bisect", step.verdict, step.commit}, output);
+
+			size_t position = output.find(" is the first bad commit");
+			if (position != std::string::npos)
+			{
+				firstBadCommit = output.substr(0, position);
+				break;
+			}
+
+			if (output.find("only 'skip'ped commits left") != std::string::npos)
+			{
+				MG_LOGNH(output);
+				break;
+			}
+		}
+
+		CaptureCommand({"git", "bisect", "reset"}, output);
+
+		MG_LOGNH("");
+		MG_LOG("Measured " + benchmark + " at every step:");
+
+		std::ostringstream header;
+		header << std::right << std::setw(6) << "Step" << "  " << std::left << std::setw(14) << "Commit"
+		       << std::right << std::setw(12) << "Min" << std::setw(12) << "Median" << std::setw(12) << "Max"
+		       << "  " << "Verdict";
+		MG_LOGNH(header.str());
+
+		for (size_t i = 0; i < steps.size(); i++)
+		{
+			const auto& samples = steps[i].samples;
+
+			std::ostringstream line;
+			line << std::right << std::setw(6) << i + 1 << "  " << std::left << std::setw(14) << steps[i].commit
+			     << std::right;
+
+			if (samples.empty())
+				line << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+			else
+				line << std::setw(12) << FormatDuration(*std::min_element(samples.begin(), samples.end()))
+				     << std::setw(12) << FormatDuration(Statistics::Median(samples))
+				     << std::setw(12) << FormatDuration(*std::max_element(samples.begin(), samples.end()));
+
+			line << "  " << steps[i].verdict;
+			MG_LOGNH(line.str());
+		}
+
+		MG_LOGNH("");
+		if (firstBadCommit.empty())
+		{
+			MG_LOG("Couldn't narrow the regression down to a single commit.");
+			return;
+		}
+
+		std::string summary;
+		CaptureCommand({"git", "log", "-1", "--format=%h %s (%an, %ad)", "--date=short", firstBadCommit}, summary);
+		MG_LOG("First bad commit: " + TrimEnd(summary));
+	}
+
+	void CommandHandler::HandleProfileCommand(const CommandHandlerProps& props)
+	{
+		if (!RequireProjectName(props))
+			return;
+
+		// Profiles are taken of optimized code, with frame pointers so that call stacks are cheap to walk.
+		Project project = *props.project;
+		project.SetConfiguration(Configuration::FromString("Profile"));
+
+		CommandHandlerProps profileProps = props;
+		profileProps.project = &project;
+
+		if (!GenerateProject(profileProps) || !BuildProject(profileProps, 0))
+			return;
+
+		std::string launchTarget = project.GetLaunchTargetName();
+		if (launchTarget.empty())
+		{
+			MG_LOG("There is nothing to profile, since the project has no executable target.");
+			return;
+		}
+
+		std::filesystem::path executable = GetTargetBinaryPath(profileProps, launchTarget);
+		if (!std::filesystem::exists(executable) && std::filesystem::exists(executable.string() + ".exe"))
+			executable += ".exe";
+
+		std::filesystem::path profilePath = GetProfilePath(project);
+		std::filesystem::create_directories(profilePath);
+
+		MG_LOG("Profiling " + launchTarget + "...");
+
+		FlameGraph flameGraph;
+		std::vector<std::string> arguments = props.GetForwardedArguments();
+
+		// perf may be installed but not allowed to record, e.g. because of kernel.perf_event_paranoid.
+		std::string perfVersion;
+		bool isProfiled = CaptureCommand({"perf", "--version"}, perfVersion) &&
+		                  ProfileWithPerf(executable, arguments, profilePath, flameGraph);
+		if (!isProfiled)
+			isProfiled = ProfileWithSampler(executable, arguments, flameGraph);
+		if (!isProfiled || flameGraph.GetSampleCount() == 0)
+		{
+			if (isProfiled)
+				MG_LOG("No samples were recorded, since " + launchTarget + " exited too quickly.");
+
+			std::filesystem::remove_all(profilePath);
+			return;
+		}
+
+		std::filesystem::path svgPath = profilePath / "flamegraph.svg";
+		if (!flameGraph.WriteFolded(profilePath / "stacks.folded") ||
+		    !flameGraph.WriteSvg(svgPath, launchTarget + " (" + profilePath.filename().string() + ")"))
+		{
+			MG_LOG("Failed to write the profile to " + profilePath.string() + ".");
+			return;
+		}
+
+		MG_LOG("Recorded " + std::to_string(flameGraph.GetSampleCount()) + " samples. Open " + svgPath.string() +
+		       " in a browser, or load stacks.folded into speedscope.app.");
+	}
+
+	void CommandHandler::HandleSizeCommand(const CommandHandlerProps& props)
+	{
+		std::vector<std::string> paths = props.GetForwardedArguments();
+		std::string against = props.GetFlagValue("--against");
+		if (paths.size() > 2 || (props.HasFlag("--against") && (against.empty() || !paths.empty())))
+		{
+			MG_LOG("Usage: magnet size [<binary> | <baseline> <binary> | --against <ref>]");
+			return;
+		}
+
+		// Binaries given on the command line, e.g. of two builds, are read as they are.
+		if (!paths.empty())
+		{
+			std::vector<SizeReport> reports;
+			for (const auto& path : paths)
+			{
+				SizeReport& report = reports.emplace_back(SizeReport::FromFile(path));
+				if (!report.IsValid())
+				{
+					MG_LOG(path + " isn't an ELF executable or shared library.");
+					return;
+				}
+			}
+
+			if (reports.size() == 1)
+				reports[0].Print();
+			else
+				reports[1].PrintDifference(reports[0]);
+
+			return;
+		}
+
+		if (!RequireProjectName(props))
+			return;
+
+		if (props.project->GetType() == ProjectType::StaticLibrary)
+		{
+			MG_LOG("Static libraries are archives of object files, which only take up space once they are linked "
+			       "into an executable or shared library. Run `magnet size` on that instead.");
+			return;
+		}
+
+		// Revisions are compared the way `magnet bench --against` builds them, optimized.
+		Project project = *props.project;
+		if (!against.empty())
+			project.SetConfiguration(Configuration::FromString("Profile"));
+
+		CommandHandlerProps sizeProps = props;
+		sizeProps.project = &project;
+
+		if (!GenerateProject(sizeProps) || !BuildProject(sizeProps, 0))
+			return;
+
+		std::string target = project.GetLaunchTargetName();
+		if (target.empty())
+			target = "lib" + project.GetName() + ".so";
+
+		SizeReport report = SizeReport::FromFile(GetTargetBinaryPath(sizeProps, target));
+		if (!report.IsValid())
+		{
+			MG_LOG(GetTargetBinaryPath(sizeProps, target).string() + " isn't an ELF executable or shared library. "
+			                                                         "Size reports are only supported on Linux.");
+			return;
+		}
+
+		if (against.empty())
+		{
+			report.Print();
+			return;
+		}
+
+		Revision baseline = PrepareRevision(against);
+		if (baseline.commit.empty())
+			return;
+
+		MG_LOG("Building " + against + " (" + baseline.commit + ") in " + baseline.worktreePath.string() + "...");
+		if (!BuildRevision(baseline, 0))
+		{
+			PrintRevisionBuildLog(baseline);
+			MG_LOG("Failed to build " + against + ". See messages above for more information.");
+			RemoveRevision(baseline);
+			return;
+		}
+
+		SizeReport baselineReport = SizeReport::FromFile(GetTargetBinaryPath(sizeProps, target,
+		                                                                     baseline.projectPath));
+		RemoveRevision(baseline);
+
+		if (!baselineReport.IsValid())
+		{
+			MG_LOG(target + " wasn't built at " + baseline.commit + ".");
+			return;
+		}
+
+		report.PrintDifference(baselineReport);
+	}
+
+	void CommandHandler::HandleCleanCommand(const CommandHandlerProps& props)
+	{
+		MG_LOG("Clean started...");
+
+		if (!RequireProjectName(props))
+			return;
+
+		std::array<std::string, 5> removeTargets = {
+				"Build/cmake_install.cmake",
+				"Build/CMakeCache.txt",
+				"Build/CMakeFiles",
+				"Build/Makefile",
+				"Build/Profile"
+		};
+
+		int removedItems = 0;
+		for (const auto& target : removeTargets)
+		{
+			std::filesystem::path path = std::filesystem::path(props.project->GetName()) / target;
+			removedItems += (int) std::filesystem::remove_all(path.generic_string());
+		}
+
+		if (removedItems == 0)
+		{
+			MG_LOG("Looks like your project is already clean. Nice!");
+			return;
+		}
+
+		std::stringstream message;
+		message << "Removed " << removedItems << " item" << (removedItems > 1 ? "s" : "") << ".";
+
+		MG_LOG(message.str());
+	}
+
+	void CommandHandler::HandlePullCommand(const CommandHandlerProps& props)
+	{
+		std::string nextArgument = props.GetArgument(0);
+		if (nextArgument.empty())
+		{
+			if (!ExecuteCommand({"git", "submodule", "update", "--init", "--recursive"},
+			                    "Failed to install dependencies. See messages above for more information."))
+				return;
+
+			MG_LOG("Successfully installed all dependencies.");
+			HandleGenerateCommand(props);
+			return;
+		}
+
+		if (!RequireProjectName(props))
+			return;
+
+		if (nextArgument == "--list")
+		{
+			HandlePullListCommand(props);
+			return;
+		}
+
+		if (nextArgument == "--help")
+		{
+			MG_LOGNH("Usage: magnet pull <url>");
+			MG_LOGNH("       magnet pull --list");
+			return;
+		}
+
+		// Allocators can be installed by their name, e.g. `magnet pull mimalloc`.
+		if (const Allocator* allocator = Allocator::Find(nextArgument))
+			nextArgument = allocator->repository;
+
+		// If the user didn't provide a full URL, we'll assume it's a GitHub repository.
+		if (nextArgument.find("https://") != 0)
+		{
+			nextArgument = "https://github.com/" + nextArgument;
+		}
+
+		std::string name = ExtractRepositoryName(nextArgument);
+		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
+		                                    name;
+		if (!ExecuteCommand({"git", "submodule", "add", nextArgument, installPath.generic_string()},
+		                    "Failed to install dependency. See messages above for more information."))
+			return;
+
+		auto dependencies = Application::GetDependencies();
+		dependencies.push_back(name);
+		WriteDependencyFile(dependencies);
+
+		MG_LOG("Installed new dependency: " + name);
+
+		HandleGenerateCommand(props);
+	}
+
+	void CommandHandler::HandlePullListCommand([[maybe_unused]] const CommandHandlerProps& props)
+	{
+		auto dependencies = Application::GetDependencies();
+
+		if (dependencies.empty())
+		{
+			MG_LOG("No dependencies installed.");
+			return;
+		}
+
+		MG_LOG("Here are all the installed dependencies:");
+
+		for (auto& package : dependencies)
+			MG_LOGNH(package);
+	}
+
+	void CommandHandler::HandleRemoveCommand(const CommandHandlerProps& props)
+	{
+		std::string dependency = props.GetArgument(0);
+		if (dependency.empty())
+		{
+			MG_LOG("Usage: magnet remove <dependency>");
+			return;
+		}
+
+		if (!RequireProjectName(props))
+			return;
+
+		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
+		                                    dependency;
+		if (!ExecuteCommand({"git", "submodule", "deinit", "-f", installPath.generic_string()},
+		                    "Failed to remove dependency. See messages above for more information."))
+			return;
+
+		if (!ExecuteCommand({"git", "rm", "-f", installPath.generic_string()},
+		                    "Failed to remove dependency. See messages above for more information."))
+			return;
+
+		std::filesystem::path gitModulesPath = std::filesystem::path(props.project->GetName()) / ".git" /
+		                                       "modules" / installPath;
+		std::error_code error;
+		std::filesystem::remove_all(gitModulesPath, error);
+		if (error)
+		{
+			MG_LOG("Failed to remove " + gitModulesPath.string() + ": " + error.message());
+			return;
+		}
+
+		auto dependencies = Application::GetDependencies();
+		dependencies.erase(std::remove(dependencies.begin(), dependencies.end(), dependency),
+		                   dependencies.end());
+		WriteDependencyFile(dependencies);
+
+		MG_LOG("Removed dependency: " + dependency);
+
+		HandleGenerateCommand(props);
+	}
+
+	void CommandHandler::HandleSwitchCommand(const CommandHandlerProps& props)
+	{
+		std::string dependency = props.GetArgument(0);
+		std::string branch = props.GetArgument(1);
+
+		if (dependency.empty() || branch.empty())
+		{
+			MG_LOG("Usage: magnet switch <dependency> <branch>");
+			return;
+		}
+
+		if (!RequireProjectName(props))
+			return;
+
+		std::filesystem::path installPath = std::filesystem::path(props.project->GetName()) / "Dependencies" /
+		                                    dependency;
+		if (!ExecuteCommand({"git", "-C", installPath.string(), "checkout", branch},
+		                    "Failed to switch dependency branch. See messages above for more information."))
+			return;
+
+		if (!ExecuteCommand({"git", "add", installPath.generic_string()},
+		                    "Failed to switch dependency branch. See messages above for more information."))
+			return;
+
+		MG_LOG("Switched " + dependency + " branch to: " + branch);
+
+		HandleGenerateCommand(props);
+	}
+
+	bool CommandHandler::IsCommandGlobal(const std::string& command)
+	{
+		return command == "new" || command == "help" || command == "version";
+	}
+
+	void CommandHandler::CreateNewProject(const Project& project, bool isTracingIncluded)
+	{
+		MG_LOG_HOST("Project Wizard", "Creating new C++ project...");
+
+		const std::string& name = project.GetName();
+
+		std::filesystem::path templatePath = Platform::GetExecutablePath() /
+		                                     "../../Templates/MAGNET_NEW_PROJECT";
+		std::filesystem::path newPath = Application::GetCurrentWorkingDirectory() / name;
+
+		templatePath = templatePath.generic_string();
+		newPath = newPath.generic_string();
+
+		std::filesystem::copy(templatePath, newPath, std::filesystem::copy_options::recursive);
+
+		{
+			std::filesystem::path fromPath = std::filesystem::path(name) / "MAGNET_NEW_PROJECT";
+			std::filesystem::path toPath = std::filesystem::path(name) / name;
+			std::filesystem::rename(fromPath, toPath);
+		}
+
+		// Read .gitignore file and replace MAGNET_NEW_PROJECT with project name
+		std::filesystem::path gitignorePath = std::filesystem::path(name) / ".gitignore";
+		std::ifstream gitignore(gitignorePath);
+		std::string gitignoreContent((std::istreambuf_iterator<char>(gitignore)),
+		                             std::istreambuf_iterator<char>());
+		gitignore.close();
+
+		std::ofstream newGitignore(gitignorePath);
+		std::string newGitignoreContent = std::regex_replace(gitignoreContent,
+		                                                     std::regex("MAGNET_NEW_PROJECT"), name);
+		newGitignore << newGitignoreContent;
+		newGitignore.close();
+
+		// Read README.md file and replace MAGNET_NEW_PROJECT with project name
+		std::filesystem::path readmePath = std::filesystem::path(name) / "README.md";
+		std::ifstream readme(readmePath);
+		std::string readmeContent((std::istreambuf_iterator<char>(readme)),
+		                          std::istreambuf_iterator<char>());
+		readme.close();
+
+		std::ofstream newReadme(readmePath);
+		std::string newReadmeContent = std::regex_replace(readmeContent,
+		                                                  std::regex("MAGNET_NEW_PROJECT"), name);
+		newReadme << newReadmeContent;
+		newReadme.close();
+
+		// Read .idea/cmake.xml file and replace MAGNET_NEW_PROJECT with project name
+		std::filesystem::path cmakePath = std::filesystem::path(name) / ".idea" / "cmake.xml";
+		std::ifstream cmake(cmakePath);
+		std::string cmakeContent((std::istreambuf_iterator<char>(cmake)),
+		                         std::istreambuf_iterator<char>());
+		cmake.close();
+
+		std::ofstream newCmake(cmakePath);
+		std::string newCmakeContent = std::regex_replace(cmakeContent,
+		                                                 std::regex("MAGNET_NEW_PROJECT"), name);
+		newCmake << newCmakeContent;
+		newCmake.close();
+
+		YAML::Emitter out;
+
+		out << YAML::BeginMap;
+		out << YAML::Key << "name";
+		out << YAML::Value << name;
+		out << YAML::Key << "projectType";
+		out << YAML::Value << project.GetTypeString();
+		out << YAML::Key << "cppVersion";
+		out << YAML::Value << project.GetCppVersion();
+		out << YAML::Key << "cmakeVersion";
+		out << YAML::Value << project.GetCmakeVersion();
+		out << YAML::Key << "defaultConfiguration";
+		out << YAML::Value << project.GetConfiguration().ToString();
+		if (isTracingIncluded)
+		{
+			out << YAML::Key << "tracing";
+			out << YAML::Value << YAML::Flow << std::vector<std::string>{"Debug", "Profile"};
+		}
+		out << YAML::EndMap;
+
+		// Create config.yaml file in .magnet folder which does not exist yet
+		std::filesystem::path magnetPath = std::filesystem::path(name) / ".magnet";
+		std::filesystem::create_directory(magnetPath);
+		std::ofstream config(magnetPath / "config.yaml");
+		config << out.c_str();
+
+		if (!config)
+		{
+			MG_LOG_HOST("Project Wizard", "Failed to create config.yaml file.");
+			return;
+		}
+
+		WriteDependencyFile({}, magnetPath / "dependencies.yaml");
+
+		std::filesystem::path dependenciesPath = std::filesystem::path(name) / name / "Dependencies";
+		std::filesystem::create_directory(dependenciesPath);
+
+		if (isTracingIncluded)
+		{
+			std::filesystem::path tracePath = Platform::GetExecutablePath() / "../../Templates/Include/MagnetTrace.h";
+			std::filesystem::path sourcePath = std::filesystem::path(name) / name / "Source";
+
+			std::error_code error;
+			std::filesystem::copy_file(tracePath, sourcePath / "MagnetTrace.h", error);
+			if (error)
+				MG_LOG_HOST("Project Wizard", "Failed to copy MagnetTrace.h: " + error.message());
+			else
+				std::ofstream(sourcePath / "PCH.h", std::ios::app) << "#include \"MagnetTrace.h\"\n";
+		}
+
+		ProcessCommand gitCommand;
+		gitCommand.arguments = {"git", "init", name};
+		if (!Platform::RunCommand(gitCommand).IsSuccessful())
+		{
+			MG_LOG_HOST("Project Wizard", "Failed to initialize git repository.");
+			return;
+		}
+
+		MG_LOG_HOST("Project Wizard", name + " has been created.\nNext steps: `cd " + name +
+		                              " && magnet generate` to generate project files.");
+	}
+
+	bool CommandHandler::GenerateRootCMakeFile(const CommandHandlerProps& props)
+	{
+		if (!RequireProjectName(props))
+			return false;
+
+		CmakeEmitter emitter("CMakeLists.txt");
+
+		emitter.Add_Header();
+		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
+		emitter.Add_Project(props.project->GetName());
+
+		emitter.Add_Newline();
+
+		emitter.Add_SetCmakeCxxStandard(props.project->GetCppVersion());
+
+		emitter.Add_Newline();
+		emitter.Add_Comment("Optimized build with debug info and frame pointers, used by `magnet bench`");
+		emitter.Add_IfElse("MSVC", [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_SetCmakeCxxFlags("Profile", "/O2 /Ob2 /Zi /Oy- /DNDEBUG");
+			emitter.Add_Indentation();
+			emitter.Add_SetCmakeLinkerFlags("EXE", "Profile", "/DEBUG /INCREMENTAL:NO");
+			emitter.Add_Indentation();
+			emitter.Add_SetCmakeLinkerFlags("SHARED", "Profile", "/DEBUG /INCREMENTAL:NO");
+		}, [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_SetCmakeCxxFlags("Profile", "-O2 -g -fno-omit-frame-pointer -DNDEBUG");
+		});
+
+		emitter.Add_If("CMAKE_CONFIGURATION_TYPES", [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_Literal("list(APPEND CMAKE_CONFIGURATION_TYPES Profile)");
+			emitter.Add_Newline();
+			emitter.Add_Indentation();
+			emitter.Add_Literal("list(REMOVE_DUPLICATES CMAKE_CONFIGURATION_TYPES)");
+			emitter.Add_Newline();
+		});
+
+		std::vector<std::string> tracingConfigurations = Application::GetTracingConfigurations();
+		if (!tracingConfigurations.empty())
+		{
+			std::vector<std::string> definitions;
+			for (const auto& configuration : tracingConfigurations)
+				definitions.push_back("$<$<CONFIG:" + configuration + ">:MG_TRACING=1>");
+
+			emitter.Add_Newline();
+			emitter.Add_Comment("Records the zones of MagnetTrace.h, which `magnet go --trace` writes to a file");
+			emitter.Add_AddCompileDefinitions(definitions);
+		}
+
+		if (Application::GetBuildBudgets().preprocessedMegabytes > 0.0)
+		{
+			emitter.Add_Newline();
+			emitter.Add_Comment("Lists the compile of every file, which the preprocessed size budget reruns with -E");
+			emitter.Add_SetCmakeExportCompileCommands(true);
+		}
+
+		std::filesystem::path launcherPath = Platform::GetExecutablePath() / "magnet-launcher";
+		if (Application::IsCompilerLauncherEnabled() && std::filesystem::exists(launcherPath))
+		{
+			// An explicitly configured launcher (e.g. ccache) takes precedence.
+			std::string launcher = "\"" + launcherPath.generic_string() + ";${CMAKE_BINARY_DIR}/" +
+			                       ResourceLog::GetPath("").generic_string() + "\"";
+
+			emitter.Add_Newline();
+			emitter.Add_Comment("Record CPU time and peak memory of every compile and link");
+			emitter.Add_If("NOT CMAKE_CXX_COMPILER_LAUNCHER", [&]()
+			{
+				emitter.Add_Indentation();
+				emitter.Add_SetCmakeCxxCompilerLauncher(launcher);
+				emitter.Add_Indentation();
+				emitter.Add_SetCmakeCxxLinkerLauncher(launcher);
+			});
+		}
+
+		emitter.Add_Newline();
+
+		// Builds with another allocator, e.g. those of `magnet bench --allocators`, keep their binaries apart.
+		emitter.Add_Comment("Links the given allocator in every configuration, instead of those in config.yaml");
+		emitter.Add_SetCacheVariable("MAGNET_ALLOCATOR", "", "STRING",
+		                             "Allocator linked into executables, e.g. mimalloc or system");
+		emitter.Add_Literal("set(MAGNET_BINARIES_DIR ${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries)");
+		emitter.Add_Newline();
+		emitter.Add_If("MAGNET_ALLOCATOR", [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_Literal("string(APPEND MAGNET_BINARIES_DIR /${MAGNET_ALLOCATOR})");
+			emitter.Add_Newline();
+		});
+
+		emitter.Add_Newline();
+
+		auto ifTrue = [&emitter]()
+		{
+			emitter.Add_SetCmakeArchiveOutputDirectory("${MAGNET_BINARIES_DIR}/${CMAKE_BUILD_TYPE}");
+			emitter.Add_SetCmakeLibraryOutputDirectory("${MAGNET_BINARIES_DIR}/${CMAKE_BUILD_TYPE}");
+			emitter.Add_SetCmakeRuntimeOutputDirectory("${MAGNET_BINARIES_DIR}/${CMAKE_BUILD_TYPE}");
+		};
+
+		auto ifFalse = [&emitter]()
+		{
+			emitter.Add_SetCmakeArchiveOutputDirectory("${MAGNET_BINARIES_DIR}");
+			emitter.Add_SetCmakeLibraryOutputDirectory("${MAGNET_BINARIES_DIR}");
+			emitter.Add_SetCmakeRuntimeOutputDirectory("${MAGNET_BINARIES_DIR}");
+		};
+
+		emitter.Add_IfElse("CMAKE_GENERATOR MATCHES Ninja", ifTrue, ifFalse);
+
+		emitter.Add_Newline();
+
+		// Links usually need far more memory than compiles, so they get their own, smaller pool.
+		// This must come before any target is created.
+		emitter.Add_Comment("Limit parallel links to what fits into memory");
+		emitter.Add_If("CMAKE_GENERATOR MATCHES Ninja", [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_SetJobPools({{"link", GetLinkJobCount()}});
+			emitter.Add_Indentation();
+			emitter.Add_SetCmakeJobPoolLink("link");
+		});
+
+		emitter.Add_Newline();
+
+		auto targets = props.project->GetTargets();
+		std::filesystem::path testsPath = std::filesystem::path(props.project->GetName()) / "Tests";
+		bool hasTestFolder = std::filesystem::is_directory(testsPath);
+		bool hasTests = hasTestFolder || std::any_of(targets.begin(), targets.end(), [](const Target& target)
+		{
+			return target.role == TargetRole::Test;
+		});
+
+		// Must be called at the top level so that CTest finds tests from the build folder.
+		if (hasTests)
+		{
+			emitter.Add_EnableTesting();
+			emitter.Add_Newline();
+		}
+
+		emitter.Add_AddSubdirectory("${PROJECT_NAME}/Source");
+		emitter.Add_AddSubdirectory("${PROJECT_NAME}/Dependencies");
+
+		for (const auto& folder : s_TargetFolders)
+		{
+			if (std::filesystem::is_directory(std::filesystem::path(props.project->GetName()) / folder.name))
+				emitter.Add_AddSubdirectory(std::string("${PROJECT_NAME}/") + folder.name);
+		}
+
+		emitter.Add_Newline();
+
+		for (const auto& target : props.project->GetTargets())
+		{
+			emitter.Add_TargetIncludeDirectories(target.name, "PUBLIC",
+			                                     "${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Source");
+		}
+
+		std::string launchTarget = props.project->GetLaunchTargetName();
+		if (!launchTarget.empty())
+		{
+			emitter.Add_Newline();
+
+			emitter.Add_If("MSVC", [&]()
+			{
+				emitter.Add_Indentation();
+				emitter.Add_Literal(
+						"set_property(DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR} PROPERTY VS_STARTUP_PROJECT " +
+						launchTarget + ")");
+				emitter.Add_Newline();
+			});
+		}
+
+		return true;
+	}
+
+	bool CommandHandler::GenerateCMakeFiles(const CommandHandlerProps& props,
+	                                        const std::vector<std::string>& scannedFiles)
+	{
+		if (!RequireProjectName(props))
+			return false;
+
+		std::string projectName = props.project->GetName();
+
+		std::filesystem::path cmakePath = std::filesystem::path(projectName) / "Source" / "CMakeLists.txt";
+		CmakeEmitter emitter(cmakePath);
+
+		emitter.Add_Header();
+		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
+		emitter.Add_Project(projectName);
+		emitter.Add_SetCmakeCxxStandard(props.project->GetCppVersion());
+
+		auto targets = props.project->GetTargets();
+
+		// In a workspace, the precompiled header is compiled once by a target that doesn't link any other
+		// target of the project, so that reusing it can't introduce a dependency cycle.
+		std::string pchTarget;
+		if (props.project->IsWorkspace())
+		{
+			for (const auto& target : targets)
+			{
+				bool linksProjectTarget = std::any_of(target.links.begin(), target.links.end(),
+				                                      [&targets](const std::string& link)
+				                                      {
+					                                      return std::any_of(targets.begin(), targets.end(),
+					                                                         [&link](const Target& other)
+					                                                         {
+						                                                         return other.name == link;
+					                                                         });
+				                                      });
+
+				if (target.type != ProjectType::DynamicLibrary && !linksProjectTarget)
+				{
+					pchTarget = target.name;
+					break;
+				}
+			}
+		}
+
+		for (const auto& target : targets)
+		{
+			auto sourceFiles = SourceScanner::Filter(scannedFiles, target.sources);
+			if (sourceFiles.empty())
+				MG_LOG("Target `" + target.name + "` has no source files. Check its `sources` in config.yaml.");
+
+			emitter.Add_Newline();
+			GenerateTarget(props, emitter, target, sourceFiles, pchTarget);
+		}
+
+		return true;
+	}
+
+	void CommandHandler::GenerateTarget(const CommandHandlerProps& props, CmakeEmitter& emitter,
+	                                    const Target& target, const std::vector<std::string>& targetFiles,
+	                                    const std::string& pchTarget)
+	{
+		const std::string& name = target.name;
+
+		// Files directly inside Source always belong to the main target. With objectLibraries, every top-level
+		// subfolder that has at least one .cpp file becomes an OBJECT library of its own. Workspaces are
+		// already split into targets, so this only applies to single target projects.
+		bool useObjectLibraries = Application::IsObjectLibrariesEnabled() && !props.project->IsWorkspace();
+
+		std::vector<std::string> sourceFiles;
+		std::map<std::string, std::vector<std::string>> modules;
+		for (const auto& file : targetFiles)
+		{
+			size_t separator = file.find('/');
+			if (!useObjectLibraries || separator == std::string::npos)
+				sourceFiles.push_back(file);
+			else
+				modules[file.substr(0, separator)].push_back(file);
+		}
+
+		for (auto it = modules.begin(); it != modules.end();)
+		{
+			bool hasSources = std::any_of(it->second.begin(), it->second.end(), [](const std::string& file)
+			{
+				return std::filesystem::path(file).extension() == ".cpp";
+			});
+
+			if (hasSources)
+			{
+				it++;
+				continue;
+			}
+
+			sourceFiles.insert(sourceFiles.end(), it->second.begin(), it->second.end());
+			it = modules.erase(it);
+		}
+
+		if (target.type == ProjectType::Executable)
+		{
+			emitter.Add_AddExecutable(name, sourceFiles);
+		} else
+		{
+			emitter.Add_AddLibrary(name, target.GetCmakeTypeString(), sourceFiles);
+		}
+
+		if (target.type != ProjectType::StaticLibrary)
+		{
+			auto ifTrue = [&]()
+			{
+				emitter.Add_Indentation();
+				emitter.Add_SetTargetProperties(name, "LINK_FLAGS", "\"-Wl,-rpath,./\"");
+			};
+
+			auto ifFalse = [&]()
+			{
+				emitter.Add_Indentation();
+				emitter.Add_SetTargetProperties(name, "VS_DEBUGGER_WORKING_DIRECTORY",
+				                                "${CMAKE_SOURCE_DIR}/${PROJECT_NAME}/Binaries/Debug");
+			};
+
+			emitter.Add_Newline();
+
+			emitter.Add_Comment("Set rpath relative to app");
+			emitter.Add_IfElse("NOT MSVC", ifTrue, ifFalse);
+		}
+
+		SharedLibraryOptimizations optimizations = Application::GetSharedLibraryOptimizations();
+		bool isOptimizedLibrary = target.type == ProjectType::DynamicLibrary && optimizations.isEnabled;
+		if (isOptimizedLibrary)
+		{
+			emitter.Add_Newline();
+			emitter.Add_Comment("Load faster, see sharedLibOptimizations in config.yaml");
+
+			if (optimizations.hideSymbols)
+			{
+				emitter.Add_SetTargetProperties(name, "CXX_VISIBILITY_PRESET", "hidden");
+				emitter.Add_SetTargetProperties(name, "VISIBILITY_INLINES_HIDDEN", "ON");
+			}
+
+			// The linkers of macOS and MSVC don't know these flags.
+			emitter.Add_If("UNIX AND NOT APPLE", [&]()
+			{
+				emitter.Add_Indentation();
+				emitter.Add_TargetLinkOptions(name, "PRIVATE", optimizations.GetLinkFlags());
+			});
+		}
+
+		emitter.Add_Newline();
+
+		if (!props.project->IsWorkspace())
+			emitter.Add_TargetPrecompileHeaders("${PROJECT_NAME}", "PUBLIC", "PCH.h");
+		else if (name == pchTarget || pchTarget.empty() || target.type == ProjectType::DynamicLibrary)
+			emitter.Add_TargetPrecompileHeaders(name, "PRIVATE", "PCH.h");
+		else
+			emitter.Add_TargetPrecompileHeaders(name, "REUSE_FROM", pchTarget);
+
+		if (target.role == TargetRole::Test)
+			emitter.Add_AddTest(name, name);
+
+		std::string harnessPath = GetBenchmarkHarnessPath();
+		if (target.role == TargetRole::Benchmark && !harnessPath.empty())
+			emitter.Add_TargetIncludeDirectories(name, "PRIVATE", harnessPath);
+
+		auto dependencies = GetLibraryDependencies();
+		std::vector<std::string> libraries;
+
+		// Linked as a whole, so that its malloc takes precedence over the one of the system.
+		if (target.type == ProjectType::Executable && !GetInstalledAllocators().empty())
+			libraries.push_back(s_AllocatorTarget);
+
+		if (!modules.empty())
+		{
+			emitter.Add_Newline();
+			emitter.Add_Comment("Modules");
+
+			// The first module compiles the precompiled header, all other modules reuse it.
+			std::string modulePchTarget;
+			for (const auto& [directory, files] : modules)
+			{
+				std::string moduleName = GetModuleTargetName(name, directory);
+				emitter.Add_AddLibrary(moduleName, "OBJECT", files);
+
+				// Modules see the same include directories as the main target, including dependencies.
+				emitter.Add_TargetIncludeDirectories(moduleName, "PRIVATE",
+				                                     "$<TARGET_PROPERTY:" + name + ",INCLUDE_DIRECTORIES>");
+
+				if (modulePchTarget.empty())
+				{
+					emitter.Add_TargetPrecompileHeaders(moduleName, "PRIVATE", "PCH.h");
+					modulePchTarget = moduleName;
+				} else
+				{
+					emitter.Add_TargetPrecompileHeaders(moduleName, "REUSE_FROM", modulePchTarget);
+				}
+
+				if (target.type == ProjectType::DynamicLibrary)
+					emitter.Add_SetTargetProperties(moduleName, "POSITION_INDEPENDENT_CODE", "ON");
+
+				// CMake only defines <target>_EXPORTS for the library itself, which the export header checks.
+				if (isOptimizedLibrary && optimizations.hideSymbols)
+				{
+					emitter.Add_SetTargetProperties(moduleName, "CXX_VISIBILITY_PRESET", "hidden");
+					emitter.Add_SetTargetProperties(moduleName, "VISIBILITY_INLINES_HIDDEN", "ON");
+					emitter.Add_TargetCompileDefinitions(moduleName, "PRIVATE", {ToIdentifier(name) + "_EXPORTS"});
+				}
+
+				if (!dependencies.empty())
+					emitter.Add_TargetLinkLibraries(moduleName, dependencies);
+
+				libraries.push_back(moduleName);
+			}
+		}
+
+		libraries.insert(libraries.end(), target.links.begin(), target.links.end());
+		libraries.insert(libraries.end(), dependencies.begin(), dependencies.end());
+		if (!libraries.empty())
+		{
+			emitter.Add_Newline();
+			emitter.Add_TargetLinkLibraries(name, libraries);
+		}
+	}
+
+	bool CommandHandler::GenerateFolderTargetsCMakeFile(const CommandHandlerProps& props, const std::string& folder,
+	                                                    const std::vector<std::string>& scannedFiles, TargetRole role)
+	{
+		if (!RequireProjectName(props))
+			return false;
+
+		std::string projectName = props.project->GetName();
+		std::filesystem::path folderPath = std::filesystem::path(projectName) / folder;
+		if (!std::filesystem::is_directory(folderPath))
+			return true;
+
+		CmakeEmitter emitter(folderPath / "CMakeLists.txt");
+
+		emitter.Add_Header();
+		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
+		emitter.Add_Project(projectName);
+		emitter.Add_SetCmakeCxxStandard(props.project->GetCppVersion());
+
+		// Every library of the project is linked, so its code can be tested directly.
+		std::vector<std::string> libraries;
+		for (const auto& target : props.project->GetTargets())
+		{
+			if (target.type != ProjectType::Executable)
+				libraries.push_back(target.name);
+		}
+
+		auto dependencies = GetLibraryDependencies();
+		libraries.insert(libraries.end(), dependencies.begin(), dependencies.end());
+
+		if (!GetInstalledAllocators().empty())
+			libraries.insert(libraries.begin(), s_AllocatorTarget);
+
+		std::string harnessPath = GetBenchmarkHarnessPath();
+
+		for (const auto& [name, files] : GetFolderTargets(scannedFiles))
+		{
+			emitter.Add_Newline();
+
+			emitter.Add_AddExecutable(name, files);
+			emitter.Add_TargetIncludeDirectories(name, "PRIVATE", "${CMAKE_SOURCE_DIR}/${PROJECT_NAME}/Source");
+
+			if (!libraries.empty())
+				emitter.Add_TargetLinkLibraries(name, libraries);
+
+			if (role == TargetRole::Test)
+				emitter.Add_AddTest(name, name);
+
+			if (role == TargetRole::Benchmark && !harnessPath.empty())
+				emitter.Add_TargetIncludeDirectories(name, "PRIVATE", harnessPath);
+		}
+
+		return true;
+	}
+
+	bool CommandHandler::IsSingleTargetProject(const CommandHandlerProps& props, const std::string& feature)
+	{
+		std::string reason;
+		if (props.project->IsWorkspace())
+			reason = "it has more than one target";
+		else if (!GetLibraryDependencies().empty())
+			reason = "it has dependencies";
+		else if (!Application::GetAllocators().empty() || !props.project->GetAllocator().empty())
+			reason = "it links another allocator";
+
+		for (const auto& folder : s_TargetFolders)
+		{
+			if (reason.empty() && std::filesystem::is_directory(std::filesystem::path(props.project->GetName()) /
+			                                                    folder.name))
+				reason = "it has a " + std::string(folder.name) + " folder";
+		}
+
+		if (reason.empty())
+			return true;
+
+		MG_LOG(feature + " only supports single target projects, but " + reason + ". Using CMake instead.");
+		return false;
+	}
+
+	bool CommandHandler::GetToolchain(const CommandHandlerProps& props, const std::string& feature,
+	                                  Toolchain& toolchain)
+	{
+		const char* compilerVariable = std::getenv("CXX");
+		std::string compiler = compilerVariable ? compilerVariable : "c++";
+
+		// CXX may start with a launcher, e.g. "ccache g++".
+		toolchain.compiler = Split(compiler, ' ');
+
+		// Only the flags of GCC and Clang are known, since MSVC needs rules of its own.
+		std::vector<std::string> versionCommand = toolchain.compiler;
+		versionCommand.push_back("--version");
+
+		std::string compilerVersion;
+		if (!CaptureCommand(versionCommand, compilerVersion))
+		{
+			MG_LOG("Couldn't run the compiler " + compiler + ". Set CXX to GCC or Clang.");
+			return false;
+		}
+
+		toolchain.isClang = compilerVersion.find("clang") != std::string::npos;
+		bool isGcc = compilerVersion.find("GCC") != std::string::npos ||
+		             compilerVersion.find("Free Software Foundation") != std::string::npos;
+		if (!toolchain.isClang && !isGcc)
+		{
+			MG_LOG(feature + " only supports GCC and Clang, but " + compiler + " is neither. Set CXX to one of "
+			       "them.");
+			return false;
+		}
+
+		std::string projectName = props.project->GetName();
+		Configuration configuration = props.project->GetConfiguration();
+		ProjectType type = props.project->GetType();
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		std::filesystem::create_directories(buildPath / "pch");
+
+		// The compiler runs in the build folder. Paths relative to it keep spaces in the project's location out of
+		// the commands, since ninja doesn't quote $in and $out.
+		std::filesystem::path projectPath = std::filesystem::relative(projectName, buildPath);
+		std::filesystem::path binariesPath = projectPath / "Binaries" / configuration.ToString();
+		toolchain.sourcePath = projectPath / "Source";
+
+		toolchain.compileFlags = {"-std=gnu++" + std::to_string(props.project->GetCppVersion())};
+		switch (configuration.m_Mode)
+		{
+			case ConfigurationMode::Release:
+				toolchain.compileFlags.insert(toolchain.compileFlags.end(), {"-O3", "-DNDEBUG"});
+				break;
+			case ConfigurationMode::Profile:
+				toolchain.compileFlags.insert(toolchain.compileFlags.end(),
+				                              {"-O2", "-g", "-fno-omit-frame-pointer", "-DNDEBUG"});
+				break;
+			default:
+				toolchain.compileFlags.push_back("-g");
+				break;
+		}
+
+		std::vector<std::string> tracingConfigurations = Application::GetTracingConfigurations();
+		if (std::find(tracingConfigurations.begin(), tracingConfigurations.end(), configuration.ToString()) !=
+		    tracingConfigurations.end())
+			toolchain.compileFlags.push_back("-DMG_TRACING=1");
+
+		SharedLibraryOptimizations optimizations = Application::GetSharedLibraryOptimizations();
+		if (type == ProjectType::DynamicLibrary)
+		{
+			// Like CMake, which defines <target>_EXPORTS for shared libraries.
+			toolchain.compileFlags.insert(toolchain.compileFlags.end(),
+			                              {"-fPIC", "-D" + ToIdentifier(projectName) + "_EXPORTS"});
+
+			std::vector<std::string> optimizationFlags = optimizations.GetCompileFlags();
+			toolchain.compileFlags.insert(toolchain.compileFlags.end(), optimizationFlags.begin(),
+			                              optimizationFlags.end());
+		}
+
+		toolchain.compileFlags.push_back("-I" + toolchain.sourcePath.generic_string());
+
+		// Clang finds PCH.h.pch and GCC finds PCH.h.gch next to the header included with -include.
+		if (std::filesystem::exists(std::filesystem::path(projectName) / "Source" / "PCH.h"))
+		{
+			std::filesystem::path wrapperPath = buildPath / "pch" / "PCH.h";
+			std::string wrapper = "#include \"" + std::filesystem::absolute(std::filesystem::path(projectName) /
+			                                                                "Source" / "PCH.h").generic_string() +
+			                      "\"\n";
+
+			// Only rewritten when it changes, since every object depends on it.
+			std::ifstream existingWrapper(wrapperPath);
+			std::string existing((std::istreambuf_iterator<char>(existingWrapper)), std::istreambuf_iterator<char>());
+			existingWrapper.close();
+			if (existing != wrapper)
+				std::ofstream(wrapperPath) << wrapper;
+
+			toolchain.pchHeader = "pch/PCH.h";
+			toolchain.pchOutput = toolchain.isClang ? "pch/PCH.h.pch" : "pch/PCH.h.gch";
+		}
+
+		if (type == ProjectType::StaticLibrary)
+		{
+			toolchain.output = binariesPath / ("lib" + projectName + ".a");
+			toolchain.isArchive = true;
+		} else if (type == ProjectType::DynamicLibrary)
+		{
+#ifdef __APPLE__
+			toolchain.output = binariesPath / ("lib" + projectName + ".dylib");
+#else
+			toolchain.output = binariesPath / ("lib" + projectName + ".so");
+			toolchain.linkFlags = optimizations.GetLinkFlags();
+#endif
+			toolchain.isShared = true;
+		} else
+		{
+			toolchain.output = binariesPath / projectName;
+			toolchain.linkFlags = {"-Wl,-rpath,./"};
+		}
+
+		return true;
+	}
+
+	bool CommandHandler::GenerateNinjaFile(const CommandHandlerProps& props, const std::vector<std::string>& scannedFiles)
+	{
+		Toolchain toolchain;
+		if (!GetToolchain(props, "The Ninja backend", toolchain))
+		{
+			MG_LOG("Use `backend: cmake` to build with another compiler.");
+			return false;
+		}
+
+		std::string projectName = props.project->GetName();
+		std::filesystem::path buildPath = GetBuildPath(props);
+
+		// A cache left by the CMake backend would make the build folder look like one of CMake's.
+		std::filesystem::remove(buildPath / "CMakeCache.txt");
+
+		NinjaEmitter emitter(buildPath / "build.ninja");
+
+		emitter.Add_Header();
+		emitter.Add_RequiredVersion("1.5");
+		emitter.Add_Newline();
+
+		emitter.Add_Variable("cxx", JoinCommand(toolchain.compiler));
+		emitter.Add_Variable("cxxflags", JoinCommand(toolchain.compileFlags));
+
+		if (!toolchain.pchHeader.empty())
+		{
+			emitter.Add_Variable("pchflags", "-include " + toolchain.pchHeader +
+			                                 (toolchain.isClang ? "" : " -Winvalid-pch"));
+		}
+
+		std::filesystem::path launcherPath = Platform::GetExecutablePath() / "magnet-launcher";
+		if (Application::IsCompilerLauncherEnabled() && std::filesystem::exists(launcherPath))
+		{
+			emitter.Add_Variable("launcher", "\"" + launcherPath.generic_string() + "\" \"" +
+			                                 ResourceLog::GetPath("").generic_string() + "\"");
+		}
+
+		emitter.Add_Newline();
+
+		// Links usually need far more memory than compiles, so they get their own, smaller pool.
+		emitter.Add_Pool("link", GetLinkJobCount());
+		emitter.Add_Newline();
+
+		emitter.Add_Rule("cxx", {
+				{"command",     "$launcher $cxx -MMD -MF $out.d $cxxflags $pchflags -c $in -o $out"},
+				{"depfile",     "$out.d"},
+				{"deps",        "gcc"},
+				{"description", "Compiling $in"},
+		});
+		emitter.Add_Newline();
+
+		emitter.Add_Rule("pch", {
+				{"command",     "$launcher $cxx -MMD -MF $out.d $cxxflags -x c++-header -c $in -o $out"},
+				{"depfile",     "$out.d"},
+				{"deps",        "gcc"},
+				{"description", "Precompiling $in"},
+		});
+		emitter.Add_Newline();
+
+		std::string linkCommand;
+		if (toolchain.isArchive)
+			linkCommand = "rm -f $out && ar rcs $out $in";
+		else if (toolchain.isShared)
+			linkCommand = "$launcher $cxx -shared $in -o $out " + JoinCommand(toolchain.linkFlags);
+		else
+			linkCommand = "$launcher $cxx $in -o $out " + JoinCommand(toolchain.linkFlags);
+
+		emitter.Add_Rule("link", {
+				{"command",     linkCommand},
+				{"pool",        "link"},
+				{"description", "Linking $out"},
+		});
+		emitter.Add_Newline();
+
+		std::vector<std::string> implicitInputs;
+		if (!toolchain.pchOutput.empty())
+		{
+			emitter.Add_Build({toolchain.pchOutput}, "pch", {toolchain.pchHeader});
+			implicitInputs.push_back(toolchain.pchOutput);
+		}
+
+		std::vector<std::string> objects;
+		for (const auto& file : scannedFiles)
+		{
+			if (std::filesystem::path(file).extension() != ".cpp")
+				continue;
+
+			std::string object = "obj/" + file + ".o";
+			emitter.Add_Build({object}, "cxx", {(toolchain.sourcePath / file).generic_string()}, implicitInputs);
+			objects.push_back(object);
+		}
+
+		std::string output = toolchain.output.generic_string();
+		emitter.Add_Newline();
+		emitter.Add_Build({output}, "link", objects);
+		emitter.Add_Build({projectName}, "phony", {output});
+		emitter.Add_Default({output});
+
+		return true;
+	}
+
+	bool CommandHandler::IsNinjaBackendBuild(const std::filesystem::path& buildPath)
+	{
+		return std::filesystem::exists(buildPath / "build.ninja") &&
+		       !std::filesystem::exists(buildPath / "CMakeCache.txt");
+	}
+
+	std::map<std::string, std::vector<std::string>> CommandHandler::GetFolderTargets(
+			const std::vector<std::string>& scannedFiles)
+	{
+		std::map<std::string, std::vector<std::string>> targets;
+
+		for (const auto& file : scannedFiles)
+		{
+			size_t separator = file.find('/');
+			if (separator != std::string::npos)
+			{
+				targets[ToTargetName(file.substr(0, separator))].push_back(file);
+				continue;
+			}
+
+			// Headers at the top level are shared and only need to be included.
+			std::filesystem::path path = file;
+			if (path.extension() == ".cpp")
+				targets[ToTargetName(path.stem().string())].push_back(file);
+		}
+
+		return targets;
+	}
+
+	std::string CommandHandler::ToTargetName(const std::string& name)
+	{
+		std::string targetName = name;
+		std::replace_if(targetName.begin(), targetName.end(), [](unsigned char c)
+		{
+			return !std::isalnum(c) && c != '_' && c != '-';
+		}, '_');
+
+		return targetName;
+	}
+
+	std::string CommandHandler::ToIdentifier(const std::string& name)
+	{
+		std::string identifier = name;
+		std::replace_if(identifier.begin(), identifier.end(), [](unsigned char c)
+		{
+			return !std::isalnum(c) && c != '_';
+		}, '_');
+
+		return identifier;
+	}
+
+	std::string CommandHandler::GetModuleTargetName(const std::string& targetName, const std::string& directory)
+	{
+		return ToTargetName(targetName + "_" + directory);
+	}
+
+	bool CommandHandler::GenerateDependencyCMakeFiles(const CommandHandlerProps& props)
+	{
+		if (!RequireProjectName(props))
+			return false;
+
+		std::string projectName = props.project->GetName();
+
+		std::filesystem::path cmakePath = std::filesystem::path(projectName) / "Dependencies" /
+		                                  "CMakeLists.txt";
+		CmakeEmitter emitter(cmakePath);
+
+		emitter.Add_Header();
+		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
+		emitter.Add_Project(projectName);
+
+		emitter.Add_Newline();
+
+		auto dependencies = GetLibraryDependencies();
+		if (!dependencies.empty())
+		{
+			emitter.Add_AddSubdirectory(dependencies);
+
+			emitter.Add_Newline();
+
+			for (const auto& target : props.project->GetTargets())
+			{
+				emitter.Begin_TargetIncludeDirectories(target.name, "PUBLIC");
+
+				for (const auto& package : dependencies)
+				{
+					std::filesystem::path packagePath = std::filesystem::path(projectName) / "Dependencies" /
+					                                    package;
+					if (!std::filesystem::exists(packagePath))
+						continue;
+
+					emitter.Add_Indentation();
+
+					emitter.Add_Literal("\"");
+					emitter.Add_Literal(package);
+
+					if (std::filesystem::exists(packagePath / "include"))
+						emitter.Add_Literal("/include");
+
+					emitter.Add_Literal("\"");
+					emitter.Add_Newline();
+				}
+
+				emitter.End_TargetIncludeDirectories();
+			}
+		}
+
+		auto allocators = GetInstalledAllocators();
+		if (!allocators.empty())
+		{
+			if (!dependencies.empty())
+				emitter.Add_Newline();
+
+			GenerateAllocatorTargets(emitter, allocators);
+		}
+
+		return true;
+	}
+
+	void CommandHandler::GenerateAllocatorTargets(CmakeEmitter& emitter,
+	                                              const std::vector<const Allocator*>& allocators)
+	{
+		emitter.Add_Comment("Allocators, which replace the one of the system in executables");
+
+		bool hasExternalProjects = false;
+		for (const auto* allocator : allocators)
+		{
+			if (!allocator->HasCmakeProject())
+			{
+				hasExternalProjects = true;
+				continue;
+			}
+
+			for (const auto& [name, value] : allocator->options)
+				emitter.Add_SetCacheVariable(name, value, "BOOL", "Set by Magnet");
+
+			emitter.Add_AddSubdirectory(allocator->dependency);
+		}
+
+		if (hasExternalProjects)
+		{
+			emitter.Add_Newline();
+			emitter.Add_Literal("find_package(Threads REQUIRED)");
+			emitter.Add_Newline();
+			emitter.Add_Include("ExternalProject");
+		}
+
+		// Building in a folder of its own keeps the submodule clean, apart from what autotools generates.
+		for (const auto* allocator : allocators)
+		{
+			if (allocator->HasCmakeProject())
+				continue;
+
+			std::string binaryPath = "${CMAKE_CURRENT_BINARY_DIR}/" + allocator->dependency;
+			std::string libraryPath = binaryPath + "/" + allocator->libraryPath;
+
+			std::vector<std::pair<std::string, std::string>> arguments = {
+					{"SOURCE_DIR", "${CMAKE_CURRENT_SOURCE_DIR}/" + allocator->dependency},
+					{"BINARY_DIR", binaryPath},
+			};
+
+			for (size_t i = 0; i < allocator->configureCommands.size(); i++)
+				arguments.emplace_back(i == 0 ? "CONFIGURE_COMMAND" : "COMMAND", allocator->configureCommands[i]);
+
+			arguments.emplace_back("BUILD_COMMAND", allocator->buildCommand);
+			arguments.emplace_back("BUILD_BYPRODUCTS", libraryPath);
+			arguments.emplace_back("INSTALL_COMMAND", "\"\"");
+
+			emitter.Add_Newline();
+			emitter.Add_ExternalProjectAdd(allocator->target + "-build", arguments);
+			emitter.Add_AddImportedLibrary(allocator->target, "STATIC", libraryPath);
+			emitter.Add_AddDependencies(allocator->target, allocator->target + "-build");
+
+			if (!allocator->libraries.empty())
+				emitter.Add_TargetLinkLibraries(allocator->target, "INTERFACE", allocator->libraries);
+		}
+
+		// Linking the whole archive keeps the linker from skipping malloc, which the system already defines.
+		emitter.Add_Newline();
+		emitter.Add_IfElse("APPLE", [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_Literal("set(MAGNET_WHOLE_ARCHIVE -Wl,-force_load)");
+			emitter.Add_Newline();
+			emitter.Add_Indentation();
+			emitter.Add_Literal("set(MAGNET_NO_WHOLE_ARCHIVE \"\")");
+			emitter.Add_Newline();
+		}, [&emitter]()
+		{
+			emitter.Add_Indentation();
+			emitter.Add_Literal("set(MAGNET_WHOLE_ARCHIVE -Wl,--whole-archive)");
+			emitter.Add_Newline();
+			emitter.Add_Indentation();
+			emitter.Add_Literal("set(MAGNET_NO_WHOLE_ARCHIVE -Wl,--no-whole-archive)");
+			emitter.Add_Newline();
+		});
+
+		// Returns the link items of an allocator, limited to the given configuration unless it's empty.
+		auto getLinkItems = [](const Allocator& allocator, const std::string& configuration)
+		{
+			std::vector<std::string> items = {"${MAGNET_WHOLE_ARCHIVE}", allocator.target,
+			                                  "${MAGNET_NO_WHOLE_ARCHIVE}"};
+			if (!configuration.empty())
+			{
+				for (auto& item : items)
+					item = "$<$<CONFIG:" + configuration + ">:" + item + ">";
+			}
+
+			return items;
+		};
+
+		std::vector<std::string> configuredItems;
+		for (const auto& [configuration, name] : Application::GetAllocators())
+		{
+			const Allocator* allocator = Allocator::Find(name);
+			if (!allocator)
+				continue;
+
+			auto items = getLinkItems(*allocator, configuration);
+			configuredItems.insert(configuredItems.end(), items.begin(), items.end());
+		}
+
+		// MSVC can't replace malloc with a static library, which is why allocators are skipped there.
+		emitter.Add_Newline();
+		emitter.Add_Literal(std::string("add_library(") + s_AllocatorTarget + " INTERFACE)");
+		emitter.Add_Newline();
+		emitter.Add_Literal("if(MSVC)");
+		emitter.Add_Newline();
+
+		for (const auto* allocator : allocators)
+		{
+			emitter.Add_Literal("elseif(MAGNET_ALLOCATOR STREQUAL " + allocator->name + ")");
+			emitter.Add_Newline();
+			emitter.Add_Indentation();
+			emitter.Add_TargetLinkLibraries(s_AllocatorTarget, "INTERFACE", getLinkItems(*allocator, ""));
+		}
+
+		if (!configuredItems.empty())
+		{
+			emitter.Add_Literal("elseif(NOT MAGNET_ALLOCATOR)");
+			emitter.Add_Newline();
+			emitter.Add_Indentation();
+			emitter.Add_TargetLinkLibraries(s_AllocatorTarget, "INTERFACE", configuredItems);
+		}
+
+		emitter.Add_Literal("endif()");
+		emitter.Add_Newline();
+	}
+
+	std::vector<const Allocator*> CommandHandler::GetInstalledAllocators()
+	{
+		std::vector<const Allocator*> allocators;
+		for (const auto& dependency : Application::GetDependencies())
+		{
+			if (const Allocator* allocator = Allocator::FindByDependency(dependency))
+				allocators.push_back(allocator);
+		}
+
+		return allocators;
+	}
+
+	std::vector<std::string> CommandHandler::GetLibraryDependencies()
+	{
+		auto dependencies = Application::GetDependencies();
+		dependencies.erase(std::remove_if(dependencies.begin(), dependencies.end(), [](const std::string& dependency)
+		{
+			return Allocator::FindByDependency(dependency) != nullptr;
+		}), dependencies.end());
+
+		return dependencies;
+	}
+
+	bool CommandHandler::RequireAllocator(const std::string& name)
+	{
+		if (name == Allocator::s_SystemName)
+			return true;
+
+		const Allocator* allocator = Allocator::Find(name);
+		if (!allocator)
+		{
+			std::string names = Allocator::s_SystemName;
+			for (const auto& known : Allocator::GetAll())
+				names += ", " + known.name;
+
+			MG_LOG("Unknown allocator `" + name + "`. Choose one of: " + names + ".");
+			return false;
+		}
+
+		auto installed = GetInstalledAllocators();
+		if (std::find(installed.begin(), installed.end(), allocator) == installed.end())
+		{
+			MG_LOG("The allocator `" + name + "` isn't installed yet. Run `magnet pull " + name + "` to install it.");
+			return false;
+		}
+
+		return true;
+	}
+
+	std::vector<std::string> CommandHandler::GetTargetNames(const CommandHandlerProps& props, TargetRole role)
+	{
+		std::vector<std::string> names;
+		for (const auto& target : props.project->GetTargets())
+		{
+			if (target.role == role)
+				names.push_back(target.name);
+		}
+
+		for (const auto& folder : s_TargetFolders)
+		{
+			if (folder.role != role)
+				continue;
+
+			auto scan = SourceScanner::Scan(std::filesystem::path(props.project->GetName()) / folder.name,
+			                                folder.indexPath, s_SourceExtensions);
+			for (const auto& [name, files] : GetFolderTargets(scan.files))
+				names.push_back(name);
+		}
+
+		return names;
+	}
+
+	std::filesystem::path CommandHandler::GetBuildPath(const CommandHandlerProps& props)
+	{
+		std::filesystem::path buildPath = std::filesystem::path(props.project->GetName()) / "Build";
+
+		// Builds that override the allocator in config.yaml, e.g. for `magnet bench --allocators`, as well.
+		const std::string& allocator = props.project->GetAllocator();
+		if (!allocator.empty())
+			return buildPath / (props.project->GetConfiguration().ToString() + "-" + allocator);
+
+		// Profile builds get their own folder, so that benchmarking doesn't invalidate the regular build.
+		if (props.project->GetConfiguration().m_Mode == ConfigurationMode::Profile)
+			return buildPath / "Profile";
+
+		return buildPath;
+	}
+
+	std::filesystem::path CommandHandler::GetTargetBinaryPath(const CommandHandlerProps& props,
+	                                                          const std::string& target,
+	                                                          const std::filesystem::path& root)
+	{
+		std::filesystem::path binariesPath = root / props.project->GetName() / "Binaries";
+		if (!props.project->GetAllocator().empty())
+			binariesPath /= props.project->GetAllocator();
+		std::filesystem::path path = binariesPath / props.project->GetConfiguration().ToString() / target;
+
+		// Only Ninja and Visual Studio put binaries into a folder per configuration.
+		if (!std::filesystem::exists(path) && !std::filesystem::exists(path.string() + ".exe"))
+			return binariesPath / target;
+
+		return path;
+	}
+
+	std::string CommandHandler::GetBenchmarkHarnessPath()
+	{
+		std::filesystem::path path = (Platform::GetExecutablePath() / "../../Templates/Include").lexically_normal();
+		if (!std::filesystem::exists(path / "MagnetBench.h"))
+			return "";
+
+		return "\"" + path.generic_string() + "\"";
+	}
+
+	std::string CommandHandler::GetGenerateFingerprint(const CommandHandlerProps& props,
+	                                                   const std::vector<std::string>& sourceFiles)
+	{
+		uint64_t hash = Hash::FromString(MG_VERSION);
+		hash = Hash::FromFile(".magnet/config.yaml", hash);
+		hash = Hash::FromFile(".magnet/dependencies.yaml", hash);
+		hash = Hash::FromString(props.ConvertArgumetsToString(), hash);
+
+		// The link pool depth is written into the build files and depends on the memory of this machine.
+		hash = Hash::FromString(std::to_string(GetLinkJobCount()), hash);
+
+		for (const auto& file : sourceFiles)
+			hash = Hash::FromString(file + "\n", hash);
+
+		return Hash::ToString(hash);
+	}
+
+	std::string CommandHandler::ExtractRepositoryName(const std::string& url)
+	{
+		std::string name = url;
+		name = url.substr(url.find_last_of('/') + 1);
+		name = name.substr(0, name.find_last_of('.'));
+		return name;
+	}
+
+	bool CommandHandler::WriteDependencyFile(const std::vector<std::string>& dependencies,
+	                                         const std::filesystem::path& path)
+	{
+		YAML::Emitter out;
+
+		out << YAML::BeginMap;
+		out << YAML::Key << "dependencies";
+		out << YAML::Value << dependencies;
+		out << YAML::EndMap;
+
+		std::filesystem::path dependenciesPath = std::filesystem::path(".magnet") / "dependencies.yaml";
+		std::ofstream file(path.empty() ? dependenciesPath : path);
+		file << out.c_str();
+
+		if (!file)
+		{
+			MG_LOG("Failed to update dependencies.yaml file.");
+			return false;
+		}
+
+		return true;
+	}
+
+	int CommandHandler::GetCompileMemoryEstimate()
+	{
+		int configured = Application::GetCompileMemory();
+		if (configured > 0)
+			return configured;
+
+		int learned = Application::GetLearnedCompileMemory();
+		if (learned > 0)
+			return learned;
+
+		return s_DefaultCompileMemory;
+	}
+
+	uint32_t CommandHandler::GetCompileJobCount()
+	{
+		uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+		uint64_t availableMemory = Platform::GetAvailableMemory() / (1024 * 1024);
+		if (availableMemory == 0)
+			return cores;
+
+		auto jobs = (uint32_t) (availableMemory / (uint64_t) GetCompileMemoryEstimate());
+		return std::clamp(jobs, 1u, cores);
+	}
+
+	uint32_t CommandHandler::GetLinkJobCount()
+	{
+		int linkMemory = Application::GetLinkMemory();
+		if (linkMemory <= 0)
+			linkMemory = std::max(s_DefaultLinkMemory, GetCompileMemoryEstimate());
+
+		uint32_t compileJobs = GetCompileJobCount();
+
+		uint64_t availableMemory = Platform::GetAvailableMemory() / (1024 * 1024);
+		if (availableMemory == 0)
+			return std::max(1u, compileJobs / 4);
+
+		auto jobs = (uint32_t) (availableMemory / (uint64_t) linkMemory);
+		return std::clamp(jobs, 1u, compileJobs);
+	}
+
+	void CommandHandler::LearnCompileMemory(const std::filesystem::path& buildPath, uint64_t resourceLogOffset)
+	{
+		// Only compiles count, since a link easily takes several times their memory and has a pool of its own.
+		// Without magnet-launcher, there is no way to tell them apart, so nothing is learned.
+		uint64_t peakMemory = 0;
+		for (const auto& record : ResourceLog::Load(ResourceLog::GetPath(buildPath), resourceLogOffset))
+		{
+			if (!record.isLink)
+				peakMemory = std::max(peakMemory, record.peakMemory);
+		}
+
+		auto peak = (int) (peakMemory / 1024);
+		if (peak < s_MinimumLearnedMemory)
+			return;
+
+		// Keep a high-water mark, but let it decay slowly so that a split-up translation unit eventually
+		// frees up parallelism again. Builds that only touched small files are ignored.
+		int learned = Application::GetLearnedCompileMemory();
+		if (learned <= 0 || peak > learned)
+			learned = peak;
+		else if (peak > learned / 2)
+			learned = (learned * 3 + peak) / 4;
+		else
+			return;
+
+		Application::SetLearnedCompileMemory(learned);
+	}
+
+	bool CommandHandler::RequireProjectName(const CommandHandlerProps& props)
+	{
+		if (props.project->GetName().empty())
+		{
+			MG_LOG("Command failed due to unknown project name.");
+			return false;
+		}
+
+		return true;
+	}
+
+	void CommandHandler::PrintResourceReport(const CommandHandlerProps& props)
+	{
+		std::filesystem::path buildPath = GetBuildPath(props);
+		auto records = ResourceLog::Load(ResourceLog::GetPath(buildPath));
+
+		if (records.empty())
+		{
+			MG_LOG("No resource usage has been recorded yet. Make sure `compilerLauncher` is not disabled in "
+			       "config.yaml and regenerate your project with `magnet generate`.");
+			return;
+		}
+
+		std::vector<double> cpuTimes;
+		std::vector<double> peakMemories;
+		for (const auto& record : records)
+		{
+			cpuTimes.push_back((double) record.GetCpuTime());
+			peakMemories.push_back((double) record.peakMemory);
+		}
+
+		// Anything two standard deviations above the mean is worth a closer look.
+		double cpuThreshold = Statistics::Mean(cpuTimes) + 2.0 * Statistics::StandardDeviation(cpuTimes);
+		double memoryThreshold =
+				Statistics::Mean(peakMemories) + 2.0 * Statistics::StandardDeviation(peakMemories);
+
+		auto printTop = [&](const std::string& title, auto compare)
+		{
+			std::sort(records.begin(), records.end(), compare);
+
+			MG_LOGNH("");
+			MG_LOG(title);
+
+			std::ostringstream header;
+			header << std::right << std::setw(10) << "CPU (s)" << std::setw(10) << "Wall (s)" << std::setw(10)
+			       << "Peak (MB)" << "  " << "Output";
+			MG_LOGNH(header.str());
+
+			size_t count = std::min<size_t>(records.size(), 10);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& record = records[i];
+				bool isOutlier = (double) record.GetCpuTime() > cpuThreshold ||
+				                 (double) record.peakMemory > memoryThreshold;
+
+				std::ostringstream line;
+				line << std::fixed << std::setprecision(2) << std::right
+				     << std::setw(10) << (double) record.GetCpuTime() / 1000.0
+				     << std::setw(10) << (double) record.wallTime / 1000.0
+				     << std::setw(10) << record.peakMemory / 1024
+				     << "  " << (isOutlier ? "! " : "  ") << record.output;
+				MG_LOGNH(line.str());
+			}
+		};
+
+		printTop("Top compiles and links by CPU time:", [](const ResourceRecord& a, const ResourceRecord& b)
+		{
+			return a.GetCpuTime() > b.GetCpuTime();
+		});
+
+		printTop("Top compiles and links by peak memory:", [](const ResourceRecord& a, const ResourceRecord& b)
+		{
+			return a.peakMemory > b.peakMemory;
+		});
+
+		uint64_t totalCpuTime = std::accumulate(records.begin(), records.end(), uint64_t(0),
+		                                        [](uint64_t sum, const ResourceRecord& record)
+		                                        {
+			                                        return sum + record.GetCpuTime();
+		                                        });
+
+		std::ostringstream summary;
+		summary << std::fixed << std::setprecision(1) << records.size() << " outputs, "
+		        << (double) totalCpuTime / 1000.0 << " s total CPU time. Entries marked with ! are outliers "
+		        << "(more than two standard deviations above the mean).";
+		MG_LOGNH("");
+		MG_LOG(summary.str());
+	}
+
+	bool CommandHandler::CheckBuildBudgets(const CommandHandlerProps& props, uint32_t jobs)
+	{
+		BuildBudgets budgets = Application::GetBuildBudgets();
+		if (budgets.IsEmpty())
+			return true;
+
+		Timings::Scope timing("Check budgets");
+
+		std::filesystem::path buildPath = GetBuildPath(props);
+		auto records = ResourceLog::Load(ResourceLog::GetPath(buildPath));
+		if (records.empty())
+			records = ResourceLog::LoadNinjaLog(buildPath / ".ninja_log");
+
+		// Both logs keep the records of outputs that have since been deleted or renamed, which no longer count.
+		// `--native` builds write to native/, which isn't part of a build.ninja that may share the build folder.
+		std::set<std::string> graphOutputs;
+		if (!props.HasFlag("--native"))
+			graphOutputs = GetBuildGraphOutputs(buildPath);
+		records.erase(std::remove_if(records.begin(), records.end(), [&](const ResourceRecord& record)
+		{
+			std::error_code error;
+			if (!std::filesystem::exists(buildPath / record.output, error))
+				return true;
+
+			std::string output = std::filesystem::path(record.output).lexically_normal().generic_string();
+			return !graphOutputs.empty() && !graphOutputs.count(output);
+		}), records.end());
+
+		MG_LOG("Checking build budgets...");
+
+		bool isExceeded = false;
+		auto check = [&isExceeded](const std::string& name, double limit, const std::string& unit,
+		                           std::vector<std::pair<std::string, double>> values)
+		{
+			std::sort(values.begin(), values.end(), [](const auto& a, const auto& b)
+			{
+				return a.second > b.second;
+			});
+
+			auto end = std::find_if(values.begin(), values.end(), [limit](const auto& value)
+			{
+				return value.second <= limit;
+			});
+
+			std::vector<std::string> offenders;
+			std::transform(values.begin(), end, std::back_inserter(offenders), [](const auto& value)
+			{
+				return value.first;
+			});
+
+			std::ostringstream line;
+			line << "  " << name << " (" << limit << " " << unit << "): " << std::fixed << std::setprecision(2);
+			if (values.empty())
+				line << "nothing measured";
+			else if (offenders.empty())
+				line << "within budget, at most " << values.front().second << " " << unit;
+			else
+				line << offenders.size() << " over budget";
+			MG_LOGNH(line.str());
+
+			// A full list would bury everything else if a budget is far off.
+			for (auto it = values.begin(); it != end && it - values.begin() < 10; ++it)
+			{
+				std::ostringstream offender;
+				offender << std::fixed << std::setprecision(2) << std::right << std::setw(14) << it->second << " "
+				         << unit << "  " << it->first;
+				MG_LOGNH(offender.str());
+			}
+
+			Event("budget").AddString("budget", name)
+			               .AddNumber("limit", limit)
+			               .AddNumber("value", values.empty() ? 0.0 : values.front().second)
+			               .AddList("offenders", offenders).Emit();
+
+			isExceeded = isExceeded || !offenders.empty();
+		};
+
+		// Without magnet-launcher, only ninja's wall times are known.
+		auto getSeconds = [](const ResourceRecord& record)
+		{
+			return (double) (record.GetCpuTime() > 0 ? record.GetCpuTime() : record.wallTime) / 1000.0;
+		};
+
+		if (budgets.compileSeconds > 0.0)
+		{
+			std::vector<std::pair<std::string, double>> values;
+			for (const auto& record : records)
+			{
+				if (!record.isLink)
+					values.emplace_back(record.output, getSeconds(record));
+			}
+
+			check("Compile time per file", budgets.compileSeconds, "s", values);
+		}
+
+		if (budgets.totalCompileSeconds > 0.0 && !records.empty())
+		{
+			double total = std::accumulate(records.begin(), records.end(), 0.0,
+			                               [&getSeconds](double sum, const ResourceRecord& record)
+			                               {
+				                               return sum + getSeconds(record);
+			                               });
+
+			check("Clean build time", budgets.totalCompileSeconds, "s", {{"all compiles and links", total}});
+		} else if (budgets.totalCompileSeconds > 0.0)
+		{
+			check("Clean build time", budgets.totalCompileSeconds, "s", {});
+		}
+
+		if (budgets.preprocessedMegabytes > 0.0)
+		{
+			std::vector<std::pair<std::string, double>> values;
+			for (const auto& [source, size] : GetPreprocessedSizes(props, jobs))
+				values.emplace_back(source, (double) size / (1024.0 * 1024.0));
+
+			check("Preprocessed size per file", budgets.preprocessedMegabytes, "MB", values);
+		}
+
+		if (budgets.binaryMegabytes > 0.0)
+		{
+			std::filesystem::path binariesPath = std::filesystem::path(props.project->GetName()) / "Binaries";
+			if (!props.project->GetAllocator().empty())
+				binariesPath /= props.project->GetAllocator();
+
+			// Only Ninja and Visual Studio put binaries into a folder per configuration.
+			std::string configuration = props.project->GetConfiguration().ToString();
+			if (std::filesystem::is_directory(binariesPath / configuration))
+				binariesPath /= configuration;
+
+			static const std::set<std::string> binaryExtensions = {"", ".exe", ".dll", ".so", ".dylib", ".a", ".lib"};
+
+			std::vector<std::pair<std::string, double>> values;
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(binariesPath, error))
+			{
+				if (entry.is_regular_file() && binaryExtensions.count(entry.path().extension().string()))
+				{
+					values.emplace_back(entry.path().generic_string(),
+					                    (double) entry.file_size() / (1024.0 * 1024.0));
+				}
+			}
+
+			check("Binary size", budgets.binaryMegabytes, "MB", values);
+		}
+
+		if (records.empty() && (budgets.compileSeconds > 0.0 || budgets.totalCompileSeconds > 0.0))
+		{
+			MG_LOG("No compiles have been recorded to check the time budgets against. Make sure `compilerLauncher` is "
+			       "not disabled in config.yaml and regenerate your project with `magnet generate`.");
+		}
+
+		if (!isExceeded)
+			return true;
+
+		if (!budgets.isEnforced)
+		{
+			MG_LOG("The build exceeds its budgets. See messages above for more information.");
+			return true;
+		}
+
+		MG_LOG("The build exceeds its budgets. See messages above for more information. Set `enforce: false` under "
+		       "budgets in config.yaml to only warn.");
+		return false;
+	}
+
+	std::set<std::string> CommandHandler::GetBuildGraphOutputs(const std::filesystem::path& buildPath)
+	{
+		if (!std::filesystem::exists(buildPath / "build.ninja"))
+			return {};
+
+		ProcessCommand command;
+		command.arguments = {"ninja", "-t", "targets", "all"};
+		command.workingDirectory = buildPath;
+		command.output = ProcessOutput::Capture;
+
+		ProcessResult result = Platform::RunCommand(command);
+		if (!result.IsSuccessful())
+			return {};
+
+		// Every line is `<output>: <rule>`.
+		std::set<std::string> outputs;
+		std::istringstream lines(result.output);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t separator = line.rfind(": ");
+			if (separator != std::string::npos)
+				outputs.insert(std::filesystem::path(line.substr(0, separator)).lexically_normal().generic_string());
+		}
+
+		return outputs;
+	}
+
+	std::map<std::string, uint64_t> CommandHandler::GetPreprocessedSizes(const CommandHandlerProps& props,
+	                                                                    uint32_t jobs)
+	{
+		std::filesystem::path buildPath = GetBuildPath(props);
+		std::string projectName = props.project->GetName();
+
+		// Preprocessed files can be tens of megabytes each, so they are written to disk instead of being captured.
+		std::filesystem::path outputPath = std::filesystem::absolute(buildPath / "preprocessed");
+		std::filesystem::create_directories(outputPath);
+
+		std::vector<ProcessCommand> commands;
+		std::vector<std::string> sources;
+		auto addCommand = [&](std::vector<std::string> arguments, const std::filesystem::path& workingDirectory,
+		                      const std::string& source)
+		{
+			std::string output = (outputPath / (std::to_string(commands.size()) + ".ii")).string();
+			arguments.insert(arguments.end(), {"-E", "-o", output});
+
+			ProcessCommand command;
+			command.arguments = arguments;
+			command.workingDirectory = workingDirectory;
+			command.output = ProcessOutput::Discard;
+			commands.push_back(command);
+			sources.push_back(source);
+		};
+
+		std::filesystem::path databasePath = buildPath / "compile_commands.json";
+		if (props.HasFlag("--native") || IsNinjaBackendBuild(buildPath))
+		{
+			Toolchain toolchain;
+			if (!GetToolchain(props, "The preprocessed size budget", toolchain))
+				return {};
+
+			auto scan = SourceScanner::Scan(std::filesystem::path(projectName) / "Source", s_SourceIndexPath,
+			                                s_SourceExtensions);
+			for (const auto& file : scan.files)
+			{
+				if (std::filesystem::path(file).extension() != ".cpp")
+					continue;
+
+				std::vector<std::string> arguments = toolchain.compiler;
+				arguments.insert(arguments.end(), toolchain.compileFlags.begin(), toolchain.compileFlags.end());
+				if (!toolchain.pchHeader.empty())
+					arguments.insert(arguments.end(), {"-include", toolchain.pchHeader});
+
+				arguments.push_back((toolchain.sourcePath / file).generic_string());
+				addCommand(arguments, buildPath,
+				           (std::filesystem::path(projectName) / "Source" / file).generic_string());
+			}
+		} else if (std::filesystem::exists(databasePath))
+		{
+			// JSON is a subset of YAML.
+			YAML::Node database = YAML::LoadFile(databasePath.string());
+			for (const auto& entry : database)
+			{
+				std::vector<std::string> compile = entry["arguments"] ?
+				                                   entry["arguments"].as<std::vector<std::string>>() :
+				                                   SplitCommandLine(entry["command"].as<std::string>());
+
+				// MSVC preprocesses with different flags.
+				std::string compiler = std::filesystem::path(compile.empty() ? "" : compile.front()).stem().string();
+				if (compile.empty() || compiler == "cl" || compiler == "clang-cl")
+					continue;
+
+				// Everything but the output and dependency files, which preprocessing would overwrite.
+				std::vector<std::string> arguments;
+				for (size_t i = 0; i < compile.size(); i++)
+				{
+					const std::string& argument = compile[i];
+					if (argument == "-o" || argument == "-MF" || argument == "-MT" || argument == "-MQ")
+						i++;
+					else if (argument != "-c" && argument != "-MD" && argument != "-MMD")
+						arguments.push_back(argument);
+				}
+
+				std::error_code error;
+				std::filesystem::path source = std::filesystem::relative(entry["file"].as<std::string>(), error);
+				addCommand(arguments, entry["directory"].as<std::string>(),
+				           error ? entry["file"].as<std::string>() : source.generic_string());
+			}
+		} else
+		{
+			MG_LOG("The preprocessed size budget needs the compile_commands.json that CMake writes once the budget "
+			       "is set. Run `magnet generate` first.");
+			return {};
+		}
+
+		std::vector<ProcessResult> results = Platform::RunCommands(commands, jobs > 0 ? jobs : GetCompileJobCount());
+
+		std::map<std::string, uint64_t> sizes;
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			std::error_code error;
+			uint64_t size = std::filesystem::file_size(commands[i].arguments.back(), error);
+			if (results[i].IsSuccessful() && !error)
+				sizes[sources[i]] = size;
+		}
+
+		std::filesystem::remove_all(outputPath);
+		return sizes;
+	}
+
+	void CommandHandler::WriteExportHeaders(const CommandHandlerProps& props)
+	{
+		SharedLibraryOptimizations optimizations = Application::GetSharedLibraryOptimizations();
+		if (!optimizations.isEnabled || !optimizations.hideSymbols)
+			return;
+
+		std::filesystem::path sourcePath = std::filesystem::path(props.project->GetName()) / "Source";
+		for (const auto& target : props.project->GetTargets())
+		{
+			// Never overwritten, since it belongs to the project once it's there.
+			std::filesystem::path path = sourcePath / (target.name + "Export.h");
+			if (target.type != ProjectType::DynamicLibrary || std::filesystem::exists(path))
+				continue;
+
+			std::string identifier = ToIdentifier(target.name);
+			std::string macro = identifier + "_API";
+			std::transform(macro.begin(), macro.end(), macro.begin(), [](unsigned char c)
+			{
+				return (char) std::toupper(c);
+			});
+
+			std::ofstream header(path);
+			header << "#pragma once\n"
+			          "\n"
+			          "// Only what is marked with " << macro << " is exported from " << target.name << ", e.g.\n"
+			          "// `class " << macro << " Plugin` or `" << macro << " void Load();`. Everything else is hidden, so\n"
+			          "// that loading the library takes fewer symbol lookups.\n"
+			          "#if defined(_WIN32)\n"
+			          "\t#if defined(" << identifier << "_EXPORTS)\n"
+			          "\t\t#define " << macro << " __declspec(dllexport)\n"
+			          "\t#else\n"
+			          "\t\t#define " << macro << " __declspec(dllimport)\n"
+			          "\t#endif\n"
+			          "#else\n"
+			          "\t#define " << macro << " __attribute__((visibility(\"default\")))\n"
+			          "#endif\n";
+
+			if (!header)
+			{
+				MG_LOG("Failed to write " + path.string() + ".");
+				continue;
+			}
+
+			MG_LOG("Created " + path.string() + ". Mark what " + target.name + " exports with " + macro +
+			       ", since sharedLibOptimizations hides everything else.");
+		}
+	}
+
+	void CommandHandler::PrintLoadCosts(const CommandHandlerProps& props)
+	{
+		// Exported symbols, lookups when loading, lookups on first use and relocations without lookup.
+		using Counts = std::array<uint64_t, 4>;
+
+		std::filesystem::path countsPath = GetBuildPath(props) / "load_costs";
+
+		std::map<std::string, Counts> previousCounts;
+		std::ifstream previousFile(countsPath);
+		Counts previous{};
+		std::string path;
+		while (previousFile >> previous[0] >> previous[1] >> previous[2] >> previous[3] &&
+		       std::getline(previousFile >> std::ws, path))
+			previousCounts[path] = previous;
+
+		previousFile.close();
+
+		std::map<std::string, Counts> counts;
+		for (const auto& target : props.project->GetTargets())
+		{
+			if (target.type != ProjectType::DynamicLibrary)
+				continue;
+
+			std::filesystem::path binaryPath = GetTargetBinaryPath(props, "lib" + target.name + ".so");
+			ElfFile file = ElfFile::Load(binaryPath);
+			if (!file.IsValid())
+				continue;
+
+			// Calls through the PLT are looked up when the library is loaded as well if it's bound now.
+			const ElfLoadCost& cost = file.GetLoadCost();
+			Counts current = {cost.exportedSymbols,
+			                  cost.symbolRelocations + (cost.isBoundNow ? cost.lazyRelocations : 0),
+			                  cost.isBoundNow ? 0 : cost.lazyRelocations, cost.relativeRelocations};
+
+			std::string key = binaryPath.generic_string();
+			counts[key] = current;
+
+			Event("load_cost").AddString("path", key).AddNumber("exported_symbols", (double) current[0])
+			                  .AddNumber("load_lookups", (double) current[1])
+			                  .AddNumber("first_use_lookups", (double) current[2])
+			                  .AddNumber("relative_relocations", (double) current[3]).Emit();
+
+			auto it = previousCounts.find(key);
+			if (it != previousCounts.end() && it->second == current)
+				continue;
+
+			auto format = [&](size_t index)
+			{
+				std::string count = std::to_string(current[index]);
+				if (it != previousCounts.end() && it->second[index] != current[index])
+					count += " (was " + std::to_string(it->second[index]) + ")";
+
+				return count;
+			};
+
+			MG_LOG(binaryPath.filename().string() + " exports " + format(0) + " symbols. Loading it takes " +
+			       format(1) + " symbol lookups and " + format(3) + " relocations without one, and " + format(2) +
+			       " calls are looked up on first use.");
+		}
+
+		if (counts.empty())
+			return;
+
+		std::ofstream file(countsPath);
+		for (const auto& [binaryPath, current] : counts)
+			file << current[0] << " " << current[1] << " " << current[2] << " " << current[3] << " " << binaryPath
+			     << "\n";
+	}
+
+	std::vector<BenchmarkSamples> CommandHandler::RunBenchmarks(const std::vector<BenchmarkBuild>& builds,
+	                                                            const std::vector<std::string>& benchmarks,
+	                                                            uint32_t repetitions, uint32_t warmup,
+	                                                            const std::string& filter,
+	                                                            const std::vector<CounterGroup>& counterGroups,
+	                                                            std::vector<CounterResults>* counters)
+	{
+		struct Command
+		{
+			std::string benchmark;
+			size_t build;
+			std::filesystem::path executable;
+			std::vector<std::string> arguments;
+			std::filesystem::path reportPath;
+		};
+
+		std::vector<Command> commands;
+		for (const auto& name : benchmarks)
+		{
+			for (size_t i = 0; i < builds.size(); i++)
+			{
+				const auto& [props, root] = builds[i];
+				const std::string& allocator = props.project->GetAllocator();
+
+				std::filesystem::path path = GetTargetBinaryPath(props, name, root);
+				if (!std::filesystem::exists(path) && !std::filesystem::exists(path.string() + ".exe"))
+				{
+					MG_LOG("Benchmark `" + name + "` hasn't been built" + (root.empty() ? "" : " in " + root.string()) +
+					       (allocator.empty() ? "" : " with " + allocator) + ".");
+					continue;
+				}
+
+				if (!std::filesystem::exists(path))
+					path += ".exe";
+
+				std::filesystem::path reportPath = root / GetBuildPath(props) / "benchmark.json";
+				std::vector<std::string> arguments = {"--benchmark_out=" + reportPath.string(),
+				                                      "--benchmark_out_format=json"};
+				if (!filter.empty())
+					arguments.push_back("--benchmark_filter=" + filter);
+
+				commands.push_back({name, i, path, arguments, reportPath});
+			}
+		}
+
+		// Repetitions take turns between the executables, and every other repetition runs them in reverse order,
+		// so that slow changes of the machine's state, such as heating up, affect all of them alike.
+		std::vector<BenchmarkSamples> samples(builds.size());
+		std::set<std::pair<std::string, size_t>> failedCommands;
+		std::map<std::pair<std::string, size_t>, std::vector<std::vector<CounterValue>>> counterRuns;
+
+		for (uint32_t i = 0; i < warmup + repetitions; i++)
+		{
+			MG_LOG(i < warmup ? "Warming up..." : "Running repetition " + std::to_string(i - warmup + 1) + " of " +
+			                                      std::to_string(repetitions) + "...");
+
+			std::vector<Command> order = commands;
+			if (i % 2 == 1)
+				std::reverse(order.begin(), order.end());
 
-		HandleGenerateCommand(props);
-	}
+			for (const auto& command : order)
+			{
+				std::pair<std::string, size_t> key = {command.benchmark, command.build};
+				if (failedCommands.count(key) > 0)
+					continue;
 
-	bool CommandHandler::IsCommandGlobal(const std::string& command)
-	{
-		return command == "new" || command == "help" || command == "version";
-	}
+				std::filesystem::remove(command.reportPath);
 
-	void CommandHandler::CreateNewProject(const Project& project)
-	{
-		MG_LOG_HOST("Project Wizard", "Creating new C++ project...");
+				// Counters are attached to the process itself, so it can't run through the shell like otherwise.
+				if (!counterGroups.empty())
+				{
+					ProcessStats stats;
+					if (!Platform::RunProcess(command.executable, command.arguments, true, stats, counterGroups) ||
+					    stats.exitCode != 0)
+					{
+						MG_LOG("Benchmark `" + command.benchmark + "` failed with exit code " +
+						       std::to_string(stats.exitCode) + ". Run it without --counters to see its output.");
+						failedCommands.insert(key);
+						continue;
+					}
 
-		const std::string& name = project.GetName();
+					if (i >= warmup)
+						counterRuns[key].push_back(stats.counters);
+				} else
+				{
+					ProcessCommand process;
+					process.arguments = {command.executable.string()};
+					process.arguments.insert(process.arguments.end(), command.arguments.begin(),
+					                         command.arguments.end());
+					process.output = ProcessOutput::Capture;
+
+					ProcessResult result = Platform::RunCommand(process);
+					if (!result.IsSuccessful())
+					{
+						MG_LOGNH(result.output);
+						MG_LOG("Benchmark `" + command.benchmark + "` failed. See messages above for more "
+						       "information.");
+						failedCommands.insert(key);
+						continue;
+					}
+				}
 
-		std::filesystem::path templatePath = Platform::GetExecutablePath() /
-		                                     "../../Templates/MAGNET_NEW_PROJECT";
-		std::filesystem::path newPath = Application::GetCurrentWorkingDirectory() / name;
+				if (i < warmup)
+					continue;
 
-		templatePath = templatePath.generic_string();
-		newPath = newPath.generic_string();
+				if (!BenchmarkHistory::ReadResults(command.reportPath, command.benchmark, samples[command.build]))
+				{
+					MG_LOG("Couldn't read the results of `" + command.benchmark + "`. Benchmarks must support "
+					       "Google Benchmark's --benchmark_out flag, like MagnetBench.h does.");
+					failedCommands.insert(key);
+				}
+			}
+		}
 
-		std::filesystem::copy(templatePath, newPath, std::filesystem::copy_options::recursive);
+		for (const auto& command : commands)
+			std::filesystem::remove(command.reportPath);
 
+		if (counters)
 		{
-			std::filesystem::path fromPath = std::filesystem::path(name) / "MAGNET_NEW_PROJECT";
-			std::filesystem::path toPath = std::filesystem::path(name) / name;
-			std::filesystem::rename(fromPath, toPath);
+			counters->assign(builds.size(), {});
+			for (const auto& [key, runs] : counterRuns)
+				(*counters)[key.second][key.first] = AggregateCounters(runs);
 		}
 
-		// Read .gitignore file and replace MAGNET_NEW_PROJECT with project name
-		std::filesystem::path gitignorePath = std::filesystem::path(name) / ".gitignore";
-		std::ifstream gitignore(gitignorePath);
-		std::string gitignoreContent((std::istreambuf_iterator<char>(gitignore)),
-		                             std::istreambuf_iterator<char>());
-		gitignore.close();
-
-		std::ofstream newGitignore(gitignorePath);
-		std::string newGitignoreContent = std::regex_replace(gitignoreContent,
-		                                                     std::regex("MAGNET_NEW_PROJECT"), name);
-		newGitignore << newGitignoreContent;
-		newGitignore.close();
+		return samples;
+	}
 
-		// Read README.md file and replace MAGNET_NEW_PROJECT with project name
-		std::filesystem::path readmePath = std::filesystem::path(name) / "README.md";
-		std::ifstream readme(readmePath);
-		std::string readmeContent((std::istreambuf_iterator<char>(readme)),
-		                          std::istreambuf_iterator<char>());
-		readme.close();
+	void CommandHandler::PrintBenchmarkComparison(const BenchmarkRun& baseline, const BenchmarkRun& run)
+	{
+		MG_LOGNH("");
+		if (baseline.samples.empty())
+			MG_LOG("Results of " + run.GetLabel() + ":");
+		else if (baseline.date.empty())
+			MG_LOG("Results of " + run.GetLabel() + " compared to " + baseline.GetLabel() + ":");
+		else
+			MG_LOG("Results of " + run.GetLabel() + " compared to " + baseline.GetLabel() + " from " + baseline.date +
+			       ":");
+
+		size_t nameWidth = 20;
+		for (const auto& [name, samples] : run.samples)
+			nameWidth = std::max(nameWidth, name.size() + 2);
+
+		std::ostringstream header;
+		header << std::left << std::setw((int) nameWidth) << "Benchmark" << std::right << std::setw(12) << "Before"
+		       << std::setw(12) << "After" << std::setw(10) << "Change" << std::setw(20) << "95% CI"
+		       << std::setw(10) << "p-value" << std::setw(8) << "+/-";
+		MG_LOGNH(header.str());
+
+		uint32_t faster = 0;
+		uint32_t slower = 0;
+
+		for (const auto& [name, samples] : run.samples)
+		{
+			double median = Statistics::Median(samples);
+			double deviation = median > 0.0 ? Statistics::StandardDeviation(samples) / median * 100.0 : 0.0;
 
-		std::ofstream newReadme(readmePath);
-		std::string newReadmeContent = std::regex_replace(readmeContent,
-		                                                  std::regex("MAGNET_NEW_PROJECT"), name);
-		newReadme << newReadmeContent;
-		newReadme.close();
+			std::ostringstream line;
+			line << std::fixed << std::setprecision(1) << std::left << std::setw((int) nameWidth) << name
+			     << std::right;
 
-		// Read .idea/cmake.xml file and replace MAGNET_NEW_PROJECT with project name
-		std::filesystem::path cmakePath = std::filesystem::path(name) / ".idea" / "cmake.xml";
-		std::ifstream cmake(cmakePath);
-		std::string cmakeContent((std::istreambuf_iterator<char>(cmake)),
-		                         std::istreambuf_iterator<char>());
-		cmake.close();
+			std::string verdict;
+			auto previous = baseline.samples.find(name);
+			if (previous == baseline.samples.end())
+			{
+				line << std::setw(12) << "-" << std::setw(12) << FormatDuration(median) << std::setw(10) << "-"
+				     << std::setw(20) << "-" << std::setw(10) << "-";
+			} else
+			{
+				double previousMedian = Statistics::Median(previous->second);
+				double pValue = Statistics::MannWhitneyU(previous->second, samples);
 
-		std::ofstream newCmake(cmakePath);
-		std::string newCmakeContent = std::regex_replace(cmakeContent,
-		                                                 std::regex("MAGNET_NEW_PROJECT"), name);
-		newCmake << newCmakeContent;
-		newCmake.close();
+				// Relative to the previous median, so that the interval reads like the change.
+				ShiftEstimate shift = Statistics::HodgesLehmann(previous->second, samples);
+				auto toPercent = [previousMedian](double value)
+				{
+					return previousMedian > 0.0 ? value / previousMedian * 100.0 : 0.0;
+				};
 
-		YAML::Emitter out;
+				std::ostringstream interval;
+				interval << std::fixed << std::setprecision(1) << std::showpos << "[" << toPercent(shift.lower)
+				         << "%, " << toPercent(shift.upper) << "%]";
 
-		out << YAML::BeginMap;
-		out << YAML::Key << "name";
-		out << YAML::Value << name;
-		out << YAML::Key << "projectType";
-		out << YAML::Value << project.GetTypeString();
-		out << YAML::Key << "cppVersion";
-		out << YAML::Value << project.GetCppVersion();
-		out << YAML::Key << "cmakeVersion";
-		out << YAML::Value << project.GetCmakeVersion();
-		out << YAML::Key << "defaultConfiguration";
-		out << YAML::Value << project.GetConfiguration().ToString();
-		out << YAML::EndMap;
+				line << std::setw(12) << FormatDuration(previousMedian) << std::setw(12) << FormatDuration(median)
+				     << std::setw(9) << std::showpos << toPercent(shift.estimate) << "%" << std::noshowpos
+				     << std::setw(20) << interval.str() << std::setw(10) << std::setprecision(3) << pValue;
 
-		// Create config.yaml file in .magnet folder which does not exist yet
-		std::filesystem::path magnetPath = std::filesystem::path(name) / ".magnet";
-		std::filesystem::create_directory(magnetPath);
-		std::ofstream config(magnetPath / "config.yaml");
-		config << out.c_str();
+				if (pValue < s_SignificanceLevel)
+				{
+					verdict = shift.estimate > 0.0 ? "  slower" : "  faster";
+					(shift.estimate > 0.0 ? slower : faster)++;
+				}
+			}
 
-		if (!config)
-		{
-			MG_LOG_HOST("Project Wizard", "Failed to create config.yaml file.");
-			return;
+			line << std::setw(7) << std::setprecision(1) << deviation << "%" << verdict;
+			MG_LOGNH(line.str());
 		}
 
-		WriteDependencyFile({}, magnetPath / "dependencies.yaml");
+		if (baseline.samples.empty())
+			return;
 
-		std::filesystem::path dependenciesPath = std::filesystem::path(name) / name / "Dependencies";
-		std::filesystem::create_directory(dependenciesPath);
+		std::ostringstream summary;
+		summary << slower << " benchmark" << (slower == 1 ? "" : "s") << " got slower and " << faster
+		        << " got faster (p < " << s_SignificanceLevel << ", Mann-Whitney U test).";
+		MG_LOGNH("");
+		MG_LOG(summary.str());
+	}
 
-		std::string gitCommand = "git init " + name;
-		int status = std::system(gitCommand.c_str());
-		if (status != 0)
+	std::string CommandHandler::GetGitRevision(bool& isDirty)
+	{
+		std::string revision;
+		if (!CaptureCommand({"git", "rev-parse", "--short", "HEAD"}, revision))
 		{
-			MG_LOG_HOST("Project Wizard", "Failed to initialize git repository.");
-			return;
+			isDirty = false;
+			return "unknown";
 		}
 
-		MG_LOG_HOST("Project Wizard", name + " has been created.\nNext steps: `cd " + name +
-		                              " && magnet generate` to generate project files.");
+		revision = TrimEnd(revision);
+
+		// Magnet's own state in .magnet changes with every build.
+		std::string status;
+		isDirty = CaptureCommand({"git", "status", "--porcelain", "--untracked-files=no", "--", ".", ":(exclude).magnet"},
+		                         status) && !status.empty();
+
+		return revision;
 	}
 
-	bool CommandHandler::GenerateRootCMakeFile(const CommandHandlerProps& props)
+	CommandHandler::Revision CommandHandler::PrepareRevision(const std::string& reference)
 	{
-		if (!RequireProjectName(props))
-			return false;
+		// The reference is passed as an argument of its own, so that it can't be interpreted by a shell.
+		ProcessCommand resolve;
+		resolve.arguments = {"git", "rev-parse", "--short", "--verify", "--quiet", reference + "^{commit}"};
+		resolve.output = ProcessOutput::Capture;
 
-		CmakeEmitter emitter("CMakeLists.txt");
+		ProcessResult resolved = Platform::RunCommand(resolve);
+		if (!resolved.IsSuccessful())
+		{
+			MG_LOG("Unknown revision `" + reference + "`.");
+			return {};
+		}
 
-		emitter.Add_Header();
-		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
-		emitter.Add_Project(props.project->GetName());
+		std::string topLevel;
+		std::string prefix;
+		if (!CaptureCommand({"git", "rev-parse", "--show-toplevel"}, topLevel) ||
+		    !CaptureCommand({"git", "rev-parse", "--show-prefix"}, prefix))
+		{
+			MG_LOG("Comparing revisions requires the project to be inside a git repository.");
+			return {};
+		}
 
-		emitter.Add_Newline();
+		Revision revision;
+		revision.commit = TrimEnd(resolved.output);
 
-		emitter.Add_SetCmakeCxxStandard(props.project->GetCppVersion());
+		// Worktrees are named after their commit, so that one left behind by an interrupted run is reused.
+		std::string repositoryName = std::filesystem::path(TrimEnd(topLevel)).filename().string();
+		revision.worktreePath = GetWorktreesPath() / (repositoryName + "-" + revision.commit);
+		revision.projectPath = revision.worktreePath / TrimEnd(prefix);
 
-		auto ifTrue = [&emitter]()
+		std::string worktreePath = revision.worktreePath.string();
+		if (!std::filesystem::exists(revision.worktreePath / ".git"))
 		{
-			emitter.Add_SetCmakeArchiveOutputDirectory(
-					"${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries/${CMAKE_BUILD_TYPE}");
-			emitter.Add_SetCmakeLibraryOutputDirectory(
-					"${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries/${CMAKE_BUILD_TYPE}");
-			emitter.Add_SetCmakeRuntimeOutputDirectory(
-					"${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries/${CMAKE_BUILD_TYPE}");
-		};
+			// Forget worktrees whose folders have been deleted, e.g. by cleaning up the temp folder.
+			ExecuteCommand({"git", "worktree", "prune"}, "Failed to prune stale git worktrees.");
 
-		auto ifFalse = [&emitter]()
+			std::filesystem::create_directories(revision.worktreePath.parent_path());
+			if (!ExecuteCommand({"git", "worktree", "add", "--quiet", "--detach", worktreePath, revision.commit},
+			                    "Failed to check out " + reference + ". See messages above for more information."))
+				return {};
+		}
+
+		if (std::filesystem::exists(revision.worktreePath / ".gitmodules") &&
+		    !ExecuteCommand({"git", "-C", worktreePath, "submodule", "update", "--init", "--recursive", "--quiet"},
+		                    "Failed to install the dependencies of " + reference + "."))
 		{
-			emitter.Add_SetCmakeArchiveOutputDirectory("${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries");
-			emitter.Add_SetCmakeLibraryOutputDirectory("${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries");
-			emitter.Add_SetCmakeRuntimeOutputDirectory("${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Binaries");
-		};
+			RemoveRevision(revision);
+			return {};
+		}
 
-		emitter.Add_IfElse("CMAKE_GENERATOR MATCHES Ninja", ifTrue, ifFalse);
+		return revision;
+	}
 
-		emitter.Add_Newline();
+	void CommandHandler::RemoveRevision(const Revision& revision)
+	{
+		if (revision.worktreePath.empty())
+			return;
 
-		emitter.Add_AddSubdirectory("${PROJECT_NAME}/Source");
-		emitter.Add_AddSubdirectory("${PROJECT_NAME}/Dependencies");
+		ExecuteCommand({"git", "worktree", "remove", "--force", revision.worktreePath.string()},
+		               "Failed to remove the worktree in " + revision.worktreePath.string() + ".");
+	}
 
-		emitter.Add_Newline();
+	bool CommandHandler::BuildRevision(const Revision& revision, uint32_t jobs)
+	{
+		std::filesystem::path magnetPath = Platform::GetExecutablePath() / Application::GetExecutableName();
 
-		emitter.Add_TargetIncludeDirectories(
-				props.project->GetName(), "PUBLIC", "${PROJECT_SOURCE_DIR}/${PROJECT_NAME}/Source");
+		ProcessCommand command;
+		command.arguments = {magnetPath.string(), "bench", "--build-only"};
+		if (jobs > 0)
+			command.arguments.insert(command.arguments.end(), {"--jobs", std::to_string(jobs)});
 
-		emitter.Add_Newline();
+		command.workingDirectory = revision.projectPath;
+		command.output = ProcessOutput::Capture;
 
-		emitter.Add_If("MSVC", [&]()
-		{
-			emitter.Add_Indentation();
-			emitter.Add_Literal(
-					"set_property(DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR} PROPERTY VS_STARTUP_PROJECT " +
-					props.project->GetName() + ")");
-			emitter.Add_Newline();
-		});
+		ProcessResult result = Platform::RunCommand(command);
+		std::ofstream(GetRevisionBuildLogPath(revision)) << result.output;
 
-		return true;
+		return result.IsSuccessful();
 	}
 
-	bool CommandHandler::GenerateCMakeFiles(const CommandHandlerProps& props)
+	void CommandHandler::PrintRevisionBuildLog(const Revision& revision)
 	{
-		if (!RequireProjectName(props))
-			return false;
-
-		std::string projectName = props.project->GetName();
-		std::vector<std::string> sourceFiles;
+		std::ifstream log(GetRevisionBuildLogPath(revision));
+		std::string line;
+		while (std::getline(log, line))
+			MG_LOGNH(line);
+	}
 
-		std::filesystem::path sourceFilesPath = std::filesystem::path(projectName) / "Source";
-		for (auto& path : std::filesystem::recursive_directory_iterator(sourceFilesPath))
-		{
-			if (path.path().extension() == ".cpp" || path.path().extension() == ".h" ||
-			    path.path().extension() == ".hpp")
-			{
-				sourceFiles.push_back(path.path().filename().string());
-			}
-		}
+	bool CommandHandler::ProfileWithPerf(const std::filesystem::path& executable,
+	                                     const std::vector<std::string>& arguments,
+	                                     const std::filesystem::path& profilePath, FlameGraph& flameGraph)
+	{
+		std::filesystem::path dataPath = profilePath / "perf.data";
 
-		std::filesystem::path cmakePath = std::filesystem::path(projectName) / "Source" / "CMakeLists.txt";
-		CmakeEmitter emitter(cmakePath);
+		ProcessCommand command;
+		command.arguments = {"perf", "record", "--call-graph", "fp", "-F", std::to_string(s_ProfileFrequency), "-o",
+		                     dataPath.string(), "--", executable.string()};
+		command.arguments.insert(command.arguments.end(), arguments.begin(), arguments.end());
 
-		emitter.Add_Header();
-		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
-		emitter.Add_Project(projectName);
-		emitter.Add_SetCmakeCxxStandard(props.project->GetCppVersion());
+		Platform::RunCommand(command);
 
-		bool isExecutable = props.project->GetType() == ProjectType::Executable;
-		if (isExecutable)
-		{
-			emitter.Add_AddExecutable(projectName, sourceFiles);
-		} else
+		std::string script;
+		if (!std::filesystem::exists(dataPath) ||
+		    !CaptureCommand({"perf", "script", "-F", "comm,ip,sym,dso", "-i", dataPath.string()}, script,
+		                    ProcessOutput::CaptureStdout))
 		{
-			std::string type = props.project->GetCmakeTypeString();
-			emitter.Add_AddLibrary(projectName, type, sourceFiles);
+			MG_LOG("perf couldn't record a profile, so the built-in sampler is used instead.");
+			return false;
 		}
 
-		auto ifTrue = [&]()
+		// Every sample starts with the name of its thread, followed by one indented line per frame, innermost
+		// first, in the form `<address> <symbol> (<file>)`.
+		std::vector<std::string> frames;
+		auto addSample = [&]()
 		{
-			emitter.Add_Indentation();
-			emitter.Add_SetTargetProperties(projectName, "LINK_FLAGS", "\"-Wl,-rpath,./\"");
-		};
+			if (frames.size() > 1)
+			{
+				std::reverse(frames.begin() + 1, frames.end());
+				flameGraph.AddStack(frames);
+			}
 
-		auto ifFalse = [&]()
-		{
-			emitter.Add_Indentation();
-			emitter.Add_SetTargetProperties(projectName, "VS_DEBUGGER_WORKING_DIRECTORY",
-			                                "${CMAKE_SOURCE_DIR}/${PROJECT_NAME}/Binaries/Debug");
+			frames.clear();
 		};
 
-		emitter.Add_Newline();
-
-		emitter.Add_Comment("Set rpath relative to app");
-		emitter.Add_IfElse("NOT MSVC", ifTrue, ifFalse);
+		std::istringstream lines(script);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			if (line.empty() || !std::isspace((unsigned char) line[0]))
+			{
+				addSample();
+				if (!line.empty())
+					frames.push_back(TrimEnd(line));
 
-		emitter.Add_Newline();
+				continue;
+			}
 
-		emitter.Add_TargetPrecompileHeaders("${PROJECT_NAME}", "PUBLIC", "PCH.h");
+			std::istringstream frame(line);
+			std::string address;
+			std::string rest;
+			frame >> address;
+			std::getline(frame >> std::ws, rest);
 
-		emitter.Add_Newline();
+			size_t fileStart = rest.rfind(" (");
+			std::string symbol = rest.substr(0, fileStart);
+			if (symbol == "[unknown]" && fileStart != std::string::npos)
+			{
+				std::string file = rest.substr(fileStart + 2, rest.size() - fileStart - 3);
+				symbol = "[" + std::filesystem::path(file).filename().string() + "]";
+			}
 
-		auto dependencies = Application::GetDependencies();
-		if (!dependencies.empty())
-		{
-			emitter.Add_TargetLinkLibraries(projectName, dependencies);
+			if (!frames.empty())
+				frames.push_back(symbol);
 		}
 
+		addSample();
 		return true;
 	}
 
-	bool CommandHandler::GenerateDependencyCMakeFiles(const CommandHandlerProps& props)
+	bool CommandHandler::ProfileWithSampler(const std::filesystem::path& executable,
+	                                        const std::vector<std::string>& arguments, FlameGraph& flameGraph)
 	{
-		if (!RequireProjectName(props))
+		ProcessSamples samples;
+		if (!Platform::SampleProcess(executable, arguments, s_ProfileFrequency, samples))
+		{
+			MG_LOG("Couldn't sample " + executable.filename().string() + ". Install perf, or allow profiling with "
+			       "`sudo sysctl kernel.perf_event_paranoid=2` on Linux.");
 			return false;
+		}
 
-		std::string projectName = props.project->GetName();
-
-		std::filesystem::path cmakePath = std::filesystem::path(projectName) / "Dependencies" /
-		                                  "CMakeLists.txt";
-		CmakeEmitter emitter(cmakePath);
-
-		emitter.Add_Header();
-		emitter.Add_CmakeMinimumRequired(props.project->GetCmakeVersion());
-		emitter.Add_Project(projectName);
-
-		emitter.Add_Newline();
+		if (samples.lostCount > 0)
+			MG_LOG(std::to_string(samples.lostCount) + " samples were lost, since they were taken faster than they "
+			       "could be read.");
 
-		auto dependencies = Application::GetDependencies();
-		if (!dependencies.empty())
+		std::map<std::string, ElfFile> files;
+		std::unordered_map<uint64_t, std::string> names;
+		for (const auto& stack : samples.stacks)
 		{
-			emitter.Add_AddSubdirectory(dependencies);
+			std::vector<std::string> frames = {executable.filename().string()};
+			for (size_t i = stack.size(); i-- > 0;)
+			{
+				// Return addresses point behind the call, which might already be the next function.
+				uint64_t address = i == 0 ? stack[i] : stack[i] - 1;
 
-			emitter.Add_Newline();
+				auto name = names.find(address);
+				if (name == names.end())
+					name = names.emplace(address, Symbolize(address, samples.mappings, files)).first;
 
-			emitter.Begin_TargetIncludeDirectories(projectName, "PUBLIC");
+				frames.push_back(name->second);
+			}
 
-			for (const auto& package : dependencies)
-			{
-				std::filesystem::path packagePath = std::filesystem::path(projectName) / "Dependencies" /
-				                                    package;
-				if (!std::filesystem::exists(packagePath))
-					continue;
+			flameGraph.AddStack(frames);
+		}
 
-				emitter.Add_Indentation();
+		return true;
+	}
 
-				emitter.Add_Literal("\"");
-				emitter.Add_Literal(package);
+	std::vector<CounterGroup> CommandHandler::GetCounterGroups()
+	{
+		std::vector<std::string> events = Platform::GetCounterEvents();
+		if (events.empty())
+		{
+			MG_LOG("Performance counters are only supported on Linux.");
+			return {};
+		}
 
-				if (std::filesystem::exists(packagePath / "include"))
-					emitter.Add_Literal("/include");
+		std::vector<CounterGroup> groups = Application::GetCounterGroups();
+		if (groups.empty())
+			return s_DefaultCounterGroups;
 
-				emitter.Add_Literal("\"");
-				emitter.Add_Newline();
+		for (auto& group : groups)
+		{
+			for (const auto& event : group)
+			{
+				if (std::find(events.begin(), events.end(), event) == events.end())
+					MG_LOG("Unknown counter `" + event + "` in config.yaml. Counters are named like in `perf list`.");
 			}
-
-			emitter.End_TargetIncludeDirectories();
 		}
 
-		return true;
+		return groups;
 	}
 
-	std::string CommandHandler::ExtractRepositoryName(const std::string& url)
+	std::filesystem::path CommandHandler::GetWorktreesPath()
 	{
-		std::string name = url;
-		name = url.substr(url.find_last_of('/') + 1);
-		name = name.substr(0, name.find_last_of('.'));
-		return name;
+		return std::filesystem::temp_directory_path() / "magnet-worktrees";
 	}
 
-	bool CommandHandler::WriteDependencyFile(const std::vector<std::string>& dependencies,
-	                                         const std::filesystem::path& path)
+	std::filesystem::path CommandHandler::GetRevisionBuildLogPath(const Revision& revision)
 	{
-		YAML::Emitter out;
+		return revision.worktreePath / "magnet-build.log";
+	}
 
-		out << YAML::BeginMap;
-		out << YAML::Key << "dependencies";
-		out << YAML::Value << dependencies;
-		out << YAML::EndMap;
+	ProcessResult CommandHandler::RunTimedCommand(const ProcessCommand& command)
+	{
+		const std::vector<std::string>& arguments = command.arguments;
+		std::string commandLine = std::accumulate(std::next(arguments.begin()), arguments.end(), arguments.front(),
+		                                          [](const std::string& a, const std::string& b)
+		                                          {
+			                                          return a + " " + b;
+		                                          });
+		Timings::Scope timing(GetProcessTimingName(arguments), "process", commandLine);
+
+		ProcessResult result = Platform::RunCommand(command);
+		timing.Stop();
+
+		Event("process").AddList("arguments", arguments)
+		                .AddBool("is_started", result.isStarted)
+		                .AddNumber("exit_code", result.stats.exitCode)
+		                .AddNumber("signal", result.signal)
+		                .AddNumber("wall_ns", result.stats.wallTime)
+		                .AddNumber("user_ns", result.stats.userTime)
+		                .AddNumber("system_ns", result.stats.systemTime)
+		                .AddNumber("peak_memory_bytes", (double) result.stats.peakMemory).Emit();
+
+		return result;
+	}
 
-		std::filesystem::path dependenciesPath = std::filesystem::path(".magnet") / "dependencies.yaml";
-		std::ofstream file(path.empty() ? dependenciesPath : path);
-		file << out.c_str();
+	bool CommandHandler::ExecuteCommand(const std::vector<std::string>& arguments, const std::string& errorMessage)
+	{
+		ProcessCommand command;
+		command.arguments = arguments;
 
-		if (!file)
-		{
-			MG_LOG("Failed to update dependencies.yaml file.");
-			return false;
-		}
+		ProcessResult result = RunTimedCommand(command);
+		if (result.IsSuccessful())
+			return true;
 
-		return true;
+		std::string program = std::filesystem::path(arguments.front()).filename().string();
+		if (!result.isStarted)
+			MG_LOG("Couldn't start " + program + ". Make sure it's installed and in your PATH.");
+		else if (result.signal != 0)
+			MG_LOG(program + " was terminated by signal " + std::to_string(result.signal) + ".");
+
+		MG_LOG(errorMessage);
+		return false;
 	}
 
-	bool CommandHandler::RequireProjectName(const CommandHandlerProps& props)
+	bool CommandHandler::CaptureCommand(const std::vector<std::string>& arguments, std::string& output)
 	{
-		if (props.project->GetName().empty())
-		{
-			MG_LOG("Command failed due to unknown project name.");
-			return false;
-		}
-
-		return true;
+		return CaptureCommand(arguments, output, ProcessOutput::Capture);
 	}
 
-	bool CommandHandler::ExecuteCommand(const std::string& command, const std::string& errorMessage)
+	bool CommandHandler::CaptureCommand(const std::vector<std::string>& arguments, std::string& output,
+	                                    ProcessOutput mode)
 	{
-		int status = std::system((command).c_str());
-		if (status != 0)
-		{
-			MG_LOG(errorMessage);
-			return false;
-		}
+		ProcessCommand command;
+		command.arguments = arguments;
+		command.output = mode;
 
-		return true;
+		ProcessResult result = RunTimedCommand(command);
+		output = std::move(result.output);
+		return result.IsSuccessful();
 	}
 }
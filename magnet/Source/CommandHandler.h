@@ -5,7 +5,19 @@
 
 namespace MG
 {
+	class CmakeEmitter;
 	class Project;
+	struct Target;
+	enum class TargetRole;
+	struct BenchmarkRun;
+	struct CounterValue;
+	class FlameGraph;
+	struct AllocationProfile;
+	struct Allocator;
+	struct Toolchain;
+	enum class ProcessOutput;
+	struct ProcessCommand;
+	struct ProcessResult;
 
 	struct CommandLineArguments;
 
@@ -14,12 +26,26 @@ namespace MG
 	{
 		Project* project;
 
-		// Returns the argument by index.
+		// Returns the argument by index, not counting Magnet's own flags and their values.
 		[[maybe_unused]] [[nodiscard]] std::string GetArgument(uint32_t index) const;
 
 		// Consolidates all the arguments into a single string.
+		// Magnet's own flags (e.g. --resources) are left out, since they are not meant for CMake or the app.
 		[[nodiscard]] std::string ConvertArgumetsToString() const;
 
+		// Returns all the arguments except Magnet's own flags, one by one.
+		[[nodiscard]] std::vector<std::string> GetForwardedArguments() const;
+
+		// Returns whether the given Magnet flag was passed.
+		[[nodiscard]] bool HasFlag(const std::string& flag) const;
+
+		// Returns the value following the given Magnet flag, or an empty string if there is none.
+		[[nodiscard]] std::string GetFlagValue(const std::string& flag) const;
+
+		// Parses the value following the given Magnet flag as a number. Leaves value untouched if the flag wasn't
+		// passed, and returns false if its value isn't a number.
+		[[nodiscard]] bool GetFlagValue(const std::string& flag, uint32_t& value) const;
+
 		// Returns whether there are any arguments left.
 		[[maybe_unused]] [[nodiscard]] bool HasArguments() const;
 
@@ -40,6 +66,11 @@ namespace MG
 		MG_DEFINE_COMMAND(Generate);
 		MG_DEFINE_COMMAND(Build);
 		MG_DEFINE_COMMAND(Go);
+		MG_DEFINE_COMMAND(Test);
+		MG_DEFINE_COMMAND(Bench);
+		MG_DEFINE_COMMAND(BisectPerf);
+		MG_DEFINE_COMMAND(Profile);
+		MG_DEFINE_COMMAND(Size);
 		MG_DEFINE_COMMAND(Clean);
 		MG_DEFINE_COMMAND(Pull);
 		MG_DEFINE_COMMAND(PullList);
@@ -50,21 +81,131 @@ namespace MG
 		// require a project to be present.
 		static bool IsCommandGlobal(const std::string& command);
 	private:
+		// A revision of the project checked out into a git worktree, so it can be built next to the working tree.
+		struct Revision
+		{
+			// Abbreviated hash of the commit, or empty if the revision couldn't be prepared.
+			std::string commit;
+			std::filesystem::path worktreePath;
+
+			// The folder inside of the worktree that contains .magnet.
+			std::filesystem::path projectPath;
+		};
+
+		// A build of the benchmarks, e.g. of another revision or with another allocator, whose results are
+		// measured separately.
+		struct BenchmarkBuild
+		{
+			CommandHandlerProps props;
+
+			// The folder that contains .magnet, e.g. that of another revision. Empty for the current one.
+			std::filesystem::path root;
+		};
+
+		// Generates the project files, unless they are up to date. Returns whether it was successful.
+		static bool GenerateProject(const CommandHandlerProps& props);
+
+		// Builds the project with the given number of parallel jobs, or as many as fit into memory if it's 0.
+		// Returns whether it was successful.
+		static bool BuildProject(const CommandHandlerProps& props, uint32_t jobs);
+
+		// Prints why the next build compiles files again for `--explain`, from a dry run of ninja and from the
+		// generated CMake files that changed since the last configure.
+		static void ExplainBuild(const CommandHandlerProps& props);
+
+		// Builds the project with `--native`, compiling and linking the files in Source without CMake or Ninja.
+		static bool BuildProjectNatively(const CommandHandlerProps& props, uint32_t jobs);
+
 		// Creates a new project by initializing the template folder and
 		// generating a unique config.yaml file inside the .magnet folder.
-		static void CreateNewProject(const Project& project);
+		// With tracing, MagnetTrace.h is copied into Source and included by PCH.h.
+		static void CreateNewProject(const Project& project, bool isTracingIncluded);
 
 		// Creates a CMakeLists.txt file at the root of the project.
 		static bool GenerateRootCMakeFile(const CommandHandlerProps& props);
 
-		// Scans the Source folder for .h / .cpp files and generates a fresh
-		// CMakeLists.txt files based on that.
-		static bool GenerateCMakeFiles(const CommandHandlerProps& props);
+		// Generates a fresh CMakeLists.txt file inside of the Source folder based on the given
+		// .h / .cpp files, as returned by SourceScanner. Files keep their path relative to Source.
+		static bool GenerateCMakeFiles(const CommandHandlerProps& props, const std::vector<std::string>& scannedFiles);
+
+		// Emits a single target with the given source files into the Source CMakeLists.txt file.
+		// In a workspace, targets other than pchTarget reuse its precompiled header.
+		static void GenerateTarget(const CommandHandlerProps& props, CmakeEmitter& emitter, const Target& target,
+		                           const std::vector<std::string>& targetFiles, const std::string& pchTarget);
+
+		// Generates a CMakeLists.txt file inside of the given project folder (e.g. Tests), turning every .cpp file
+		// at its top level and every subfolder into an executable with the given role.
+		static bool GenerateFolderTargetsCMakeFile(const CommandHandlerProps& props, const std::string& folder,
+		                                           const std::vector<std::string>& scannedFiles, TargetRole role);
+
+		// Returns whether the project is simple enough to build without CMake, as the given feature (e.g. "The
+		// Ninja backend") does: a single target without dependencies, allocators, tests or benchmarks. Logs why
+		// not otherwise.
+		static bool IsSingleTargetProject(const CommandHandlerProps& props, const std::string& feature);
+
+		// Detects GCC or Clang from CXX and fills in the flags to build the project with when building without
+		// CMake, with paths relative to the build folder. Also writes the wrapper of PCH.h. Logs why not and
+		// returns false if the compiler isn't supported.
+		static bool GetToolchain(const CommandHandlerProps& props, const std::string& feature, Toolchain& toolchain);
+
+		// Writes a build.ninja file into the build folder instead of configuring with CMake. It compiles every .cpp
+		// file with GCC or Clang, tracks headers through depfiles, precompiles PCH.h and links the target.
+		static bool GenerateNinjaFile(const CommandHandlerProps& props, const std::vector<std::string>& scannedFiles);
+
+		// Returns whether the build folder was generated by the Ninja backend rather than by CMake.
+		static bool IsNinjaBackendBuild(const std::filesystem::path& buildPath);
+
+		// Groups the files of a folder such as Tests into targets: every top-level .cpp file is a target
+		// named after it, and every subfolder is a target made of all of its files.
+		static std::map<std::string, std::vector<std::string>> GetFolderTargets(
+				const std::vector<std::string>& scannedFiles);
+
+		// Returns the names of all executables with the given role, whether declared in config.yaml or found in
+		// a folder such as Tests.
+		static std::vector<std::string> GetTargetNames(const CommandHandlerProps& props, TargetRole role);
+
+		// Returns the CMake build folder of the project's configuration.
+		static std::filesystem::path GetBuildPath(const CommandHandlerProps& props);
+
+		// Returns the path of the given target's binary in the project's configuration, without an extension.
+		// The root is the folder containing .magnet, e.g. that of another revision.
+		static std::filesystem::path GetTargetBinaryPath(const CommandHandlerProps& props, const std::string& target,
+		                                                 const std::filesystem::path& root = "");
+
+		// Returns the quoted include directory of MagnetBench.h, or an empty string if it can't be found.
+		static std::string GetBenchmarkHarnessPath();
+
+		// Replaces every character that is not allowed in a CMake target name.
+		static std::string ToTargetName(const std::string& name);
+
+		// Replaces every character that is not allowed in a C++ identifier, like CMake does for <target>_EXPORTS.
+		static std::string ToIdentifier(const std::string& name);
+
+		// Returns the name of the OBJECT library generated for a top-level Source subfolder.
+		static std::string GetModuleTargetName(const std::string& targetName, const std::string& directory);
+
+		// Returns a hash of everything the generated project files depend on, so that generating can be
+		// skipped if nothing changed since the last successful run.
+		static std::string GetGenerateFingerprint(const CommandHandlerProps& props,
+		                                          const std::vector<std::string>& scannedFiles);
 
 		// Generates a CMakeLists.txt file inside of Dependencies folder
 		// based on installed packages.
 		static bool GenerateDependencyCMakeFiles(const CommandHandlerProps& props);
 
+		// Emits the allocators that are installed as dependencies, and the magnet-allocator interface library that
+		// links the one chosen for the configuration into executables.
+		static void GenerateAllocatorTargets(CmakeEmitter& emitter, const std::vector<const Allocator*>& allocators);
+
+		// Returns the allocators that are installed as dependencies.
+		static std::vector<const Allocator*> GetInstalledAllocators();
+
+		// Returns the installed dependencies, except allocators, which only executables link.
+		static std::vector<std::string> GetLibraryDependencies();
+
+		// Returns whether the given allocator can be linked, meaning it's the system's or installed.
+		static bool RequireAllocator(const std::string& name);
+
 		// Returns the name of the repository from the given URL.
 		static std::string ExtractRepositoryName(const std::string& url);
 
@@ -74,10 +215,127 @@ namespace MG
 		                                const std::filesystem::path& path = "");
 
 
+		// Returns the estimated peak memory of a single compile in megabytes. Prefers the value from
+		// config.yaml, then the estimate learned from previous builds, then a conservative default.
+		static int GetCompileMemoryEstimate();
+
+		// Returns how many compile jobs can run in parallel without exhausting the available memory.
+		static uint32_t GetCompileJobCount();
+
+		// Returns how many link jobs can run in parallel without exhausting the available memory.
+		static uint32_t GetLinkJobCount();
+
+		// Updates the learned compile memory estimate from the peak memory of the compiles that were appended to
+		// the resource log after the given offset.
+		static void LearnCompileMemory(const std::filesystem::path& buildPath, uint64_t resourceLogOffset);
+
 		// Returns whether the given project name is valid.
 		static bool RequireProjectName(const CommandHandlerProps& props);
 
-		// Executes the given command and returns whether it was successful.
-		static bool ExecuteCommand(const std::string& command, const std::string& errorMessage);
+		// Prints the compiles and links recorded by magnet-launcher, ranked by CPU time and peak memory.
+		static void PrintResourceReport(const CommandHandlerProps& props);
+
+		// Checks the build against the budgets in config.yaml, using the compiles recorded by magnet-launcher or
+		// ninja and the size of the binaries. Lists the files over budget. Returns false if a budget is exceeded
+		// and enforced.
+		static bool CheckBuildBudgets(const CommandHandlerProps& props, uint32_t jobs);
+
+		// Returns the outputs of the build graph in buildPath, relative to it, as listed by `ninja -t targets all`.
+		// Returns an empty set if there is no build.ninja, e.g. for Makefiles or `magnet build --native`.
+		static std::set<std::string> GetBuildGraphOutputs(const std::filesystem::path& buildPath);
+
+		// Preprocesses every file of the last build again with -E, as listed in compile_commands.json or as built
+		// without CMake, and returns the size of each in bytes, keyed by the source file. Runs jobs at a time.
+		static std::map<std::string, uint64_t> GetPreprocessedSizes(const CommandHandlerProps& props, uint32_t jobs);
+
+		// Writes <target>Export.h into Source for every shared library whose symbols sharedLibOptimizations hides,
+		// unless it exists already.
+		static void WriteExportHeaders(const CommandHandlerProps& props);
+
+		// Prints how many symbols every shared library exports and how many relocations it takes to load it,
+		// whenever that changed since the last build.
+		static void PrintLoadCosts(const CommandHandlerProps& props);
+
+		// Performance counters of every benchmark executable, keyed by its name.
+		using CounterResults = std::map<std::string, std::vector<CounterValue>>;
+
+		// Runs the given benchmark executables of every build, warmup times without recording and then
+		// repetitions times. Returns the time per iteration of every benchmark they contain, for each build.
+		// If counter groups are given, the median of every counter over the repetitions is stored in counters.
+		static std::vector<std::map<std::string, std::vector<double>>> RunBenchmarks(
+				const std::vector<BenchmarkBuild>& builds,
+				const std::vector<std::string>& benchmarks, uint32_t repetitions, uint32_t warmup,
+				const std::string& filter, const std::vector<std::vector<std::string>>& counterGroups = {},
+				std::vector<CounterResults>* counters = nullptr);
+
+		// Returns the counter groups from config.yaml, or a default set that fits most CPUs.
+		// Returns no groups if the platform has no performance counters.
+		static std::vector<std::vector<std::string>> GetCounterGroups();
+
+		// Prints the median of every benchmark of the run, and if the baseline has results, the difference to it
+		// with its confidence interval and whether it is statistically significant.
+		static void PrintBenchmarkComparison(const BenchmarkRun& baseline, const BenchmarkRun& run);
+
+		// Returns the abbreviated hash of the checked out commit, and whether the working tree has changes.
+		static std::string GetGitRevision(bool& isDirty);
+
+		// Checks out the given git reference into a worktree in the temp folder, including its dependencies.
+		// On failure, the returned revision has no commit.
+		static Revision PrepareRevision(const std::string& reference);
+
+		// Deletes the worktree of the given revision, if it has one.
+		static void RemoveRevision(const Revision& revision);
+
+		// Builds the benchmarks of the given revision with another instance of Magnet, writing its output to the
+		// revision's build log. Returns whether it was successful.
+		static bool BuildRevision(const Revision& revision, uint32_t jobs);
+
+		// Launches the executable repeatedly, then prints statistics of its wall time, CPU time and peak memory.
+		static void MeasureLaunches(const CommandHandlerProps& props, std::filesystem::path executable,
+		                            uint32_t repeat, uint32_t warmup);
+
+		// Records call stacks of the executable with `perf record` and adds them to the flame graph.
+		static bool ProfileWithPerf(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+		                            const std::filesystem::path& profilePath, FlameGraph& flameGraph);
+
+		// Samples call stacks of the executable with the built-in sampler and symbolizes them from the ELF
+		// files that were mapped into it. Used when perf isn't installed or can't record.
+		static bool ProfileWithSampler(const std::filesystem::path& executable,
+		                               const std::vector<std::string>& arguments, FlameGraph& flameGraph);
+
+		// Launches the executable once with its output, then prints its performance counters.
+		static void CountLaunch(const CommandHandlerProps& props, std::filesystem::path executable);
+
+		// Launches the executable once with MAGNET_TRACE set, so that MagnetTrace.h writes a Chrome trace into a
+		// new profile folder when it exits.
+		static void TraceLaunch(const CommandHandlerProps& props, std::filesystem::path executable);
+
+		// Launches the executable once with magnet-alloc-shim preloaded, then prints its top allocation sites and
+		// heap size over time.
+		static void ProfileAllocations(const CommandHandlerProps& props, std::filesystem::path executable);
+
+		// Prints the report that magnet-alloc-shim wrote for a single process.
+		static void PrintAllocationProfile(const AllocationProfile& profile);
+
+		// Returns the folder in which the worktrees of all revisions are created.
+		static std::filesystem::path GetWorktreesPath();
+
+		static void PrintRevisionBuildLog(const Revision& revision);
+		static std::filesystem::path GetRevisionBuildLogPath(const Revision& revision);
+
+		// Runs the given executable and arguments without a shell and returns whether it exited successfully.
+		// Logs the error message otherwise, along with the signal that terminated it, if any.
+		static bool ExecuteCommand(const std::vector<std::string>& arguments, const std::string& errorMessage);
+
+		// Runs the given executable and arguments without a shell and stores what it writes to stdout and stderr in
+		// output. Returns whether it exited successfully.
+		static bool CaptureCommand(const std::vector<std::string>& arguments, std::string& output);
+		static bool CaptureCommand(const std::vector<std::string>& arguments, std::string& output, ProcessOutput mode);
+
+		// Runs the command and records its time in the timings and a process event.
+		static ProcessResult RunTimedCommand(const ProcessCommand& command);
+
+		// Times the generator on synthetic projects.
+		friend class SelfBenchmark;
 	};
 }
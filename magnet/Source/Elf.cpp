@@ -0,0 +1,283 @@
+#include "Elf.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+namespace MG
+{
+	static constexpr uint32_t s_LoadSegment = 1;
+	static constexpr uint32_t s_SymbolTableSection = 2;
+	static constexpr uint32_t s_DynamicSymbolTableSection = 11;
+	static constexpr uint32_t s_RelocationSection = 4;
+	static constexpr uint32_t s_DynamicSection = 6;
+	static constexpr uint32_t s_ImplicitRelocationSection = 9;
+	static constexpr uint64_t s_AllocatedSectionFlag = 2;
+	static constexpr uint8_t s_ObjectSymbol = 1;
+	static constexpr uint8_t s_FunctionSymbol = 2;
+	static constexpr uint8_t s_GlobalBinding = 1;
+	static constexpr uint8_t s_WeakBinding = 2;
+	static constexpr uint8_t s_HiddenVisibility = 2;
+
+	// Entries of the dynamic section that mark a file as bound now, and the flags they carry for it.
+	static constexpr uint64_t s_BindNowTag = 24;
+	static constexpr uint64_t s_FlagsTag = 30;
+	static constexpr uint64_t s_Flags1Tag = 0x6ffffffb;
+	static constexpr uint64_t s_BindNowFlag = 8;
+	static constexpr uint64_t s_Now1Flag = 1;
+
+	// Reads a little-endian integer at the given offset, or returns 0 if it's out of bounds.
+	template<typename T>
+	static T Read(const std::vector<char>& data, uint64_t offset)
+	{
+		if (offset > data.size() || data.size() - offset < sizeof(T))
+			return 0;
+
+		T value = 0;
+		for (size_t i = 0; i < sizeof(T); i++)
+			value |= (T) ((T) (unsigned char) data[offset + i] << (8 * i));
+
+		return value;
+	}
+
+	static std::string ReadString(const std::vector<char>& data, uint64_t offset)
+	{
+		if (offset >= data.size())
+			return "";
+
+		const char* begin = data.data() + offset;
+		const char* end = static_cast<const char*>(std::memchr(begin, '\0', data.size() - offset));
+		return end ? std::string(begin, end) : std::string(begin, data.data() + data.size());
+	}
+
+	ElfFile ElfFile::Load(const std::filesystem::path& path)
+	{
+		ElfFile file;
+
+		std::ifstream stream(path, std::ios::binary);
+		std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+		// Magic number, 64-bit class and little-endian data.
+		if (data.size() < 64 || std::memcmp(data.data(), "\x7f" "ELF", 4) != 0 || data[4] != 2 || data[5] != 1)
+			return file;
+
+		auto programHeaderOffset = Read<uint64_t>(data, 32);
+		auto sectionHeaderOffset = Read<uint64_t>(data, 40);
+		auto programHeaderSize = Read<uint16_t>(data, 54);
+		auto programHeaderCount = Read<uint16_t>(data, 56);
+		auto sectionHeaderSize = Read<uint16_t>(data, 58);
+		auto sectionHeaderCount = Read<uint16_t>(data, 60);
+		auto sectionNamesIndex = Read<uint16_t>(data, 62);
+
+		for (uint16_t i = 0; i < programHeaderCount; i++)
+		{
+			uint64_t header = programHeaderOffset + (uint64_t) i * programHeaderSize;
+			if (Read<uint32_t>(data, header) != s_LoadSegment)
+				continue;
+
+			ElfSegment segment;
+			segment.offset = Read<uint64_t>(data, header + 8);
+			segment.address = Read<uint64_t>(data, header + 16);
+			segment.fileSize = Read<uint64_t>(data, header + 32);
+			segment.memorySize = Read<uint64_t>(data, header + 40);
+			file.m_Segments.push_back(segment);
+		}
+
+		struct SectionHeader
+		{
+			uint32_t nameOffset;
+			uint32_t link;
+			uint64_t entrySize;
+		};
+
+		std::vector<SectionHeader> headers;
+		for (uint16_t i = 0; i < sectionHeaderCount; i++)
+		{
+			uint64_t header = sectionHeaderOffset + (uint64_t) i * sectionHeaderSize;
+
+			ElfSection section;
+			section.type = Read<uint32_t>(data, header + 4);
+			section.flags = Read<uint64_t>(data, header + 8);
+			section.address = Read<uint64_t>(data, header + 16);
+			section.offset = Read<uint64_t>(data, header + 24);
+			section.size = Read<uint64_t>(data, header + 32);
+			file.m_Sections.push_back(section);
+
+			headers.push_back({Read<uint32_t>(data, header), Read<uint32_t>(data, header + 40),
+			                   Read<uint64_t>(data, header + 56)});
+		}
+
+		if (sectionNamesIndex < file.m_Sections.size())
+		{
+			uint64_t namesOffset = file.m_Sections[sectionNamesIndex].offset;
+			for (size_t i = 0; i < file.m_Sections.size(); i++)
+				file.m_Sections[i].name = ReadString(data, namesOffset + headers[i].nameOffset);
+		}
+
+		// Stripped binaries only keep the symbols needed for dynamic linking.
+		auto readSymbols = [&](uint32_t type)
+		{
+			for (size_t i = 0; i < file.m_Sections.size(); i++)
+			{
+				const auto& section = file.m_Sections[i];
+				if (section.type != type || headers[i].entrySize < 24 || headers[i].link >= file.m_Sections.size())
+					continue;
+
+				uint64_t namesOffset = file.m_Sections[headers[i].link].offset;
+				for (uint64_t entry = 0; entry + headers[i].entrySize <= section.size; entry += headers[i].entrySize)
+				{
+					uint64_t offset = section.offset + entry;
+					uint8_t symbolType = Read<uint8_t>(data, offset + 4) & 0xf;
+					uint16_t sectionIndex = Read<uint16_t>(data, offset + 6);
+					if ((symbolType != s_FunctionSymbol && symbolType != s_ObjectSymbol) || sectionIndex == 0)
+						continue;
+
+					ElfSymbol symbol;
+					symbol.name = ReadString(data, namesOffset + Read<uint32_t>(data, offset));
+					symbol.address = Read<uint64_t>(data, offset + 8);
+					symbol.size = Read<uint64_t>(data, offset + 16);
+					symbol.isFunction = symbolType == s_FunctionSymbol;
+					symbol.section = sectionIndex;
+
+					if (!symbol.name.empty())
+						file.m_Symbols.push_back(symbol);
+				}
+			}
+		};
+
+		for (size_t i = 0; i < file.m_Sections.size(); i++)
+		{
+			const auto& section = file.m_Sections[i];
+			uint64_t entrySize = headers[i].entrySize;
+			if (entrySize == 0)
+				continue;
+
+			// .rela.plt holds the relocations of the PLT, which are lazily bound.
+			std::string_view name = section.name;
+			bool isPlt = name.size() >= 4 && name.substr(name.size() - 4) == ".plt";
+
+			for (uint64_t entry = 0; entry + entrySize <= section.size; entry += entrySize)
+			{
+				uint64_t offset = section.offset + entry;
+				if (section.type == s_DynamicSymbolTableSection)
+				{
+					uint8_t binding = Read<uint8_t>(data, offset + 4) >> 4;
+					uint8_t visibility = Read<uint8_t>(data, offset + 5) & 0x3;
+					if ((binding == s_GlobalBinding || binding == s_WeakBinding) && visibility != s_HiddenVisibility &&
+					    Read<uint16_t>(data, offset + 6) != 0)
+						file.m_LoadCost.exportedSymbols++;
+				} else if ((section.type == s_RelocationSection || section.type == s_ImplicitRelocationSection) &&
+				           (section.flags & s_AllocatedSectionFlag))
+				{
+					// The symbol index is in the upper half of r_info. E.g. R_X86_64_RELATIVE has none.
+					bool hasSymbol = (Read<uint64_t>(data, offset + 8) >> 32) != 0;
+					if (isPlt)
+						file.m_LoadCost.lazyRelocations++;
+					else if (hasSymbol)
+						file.m_LoadCost.symbolRelocations++;
+					else
+						file.m_LoadCost.relativeRelocations++;
+				} else if (section.type == s_DynamicSection)
+				{
+					uint64_t tag = Read<uint64_t>(data, offset);
+					uint64_t value = Read<uint64_t>(data, offset + 8);
+					if (tag == s_BindNowTag || (tag == s_FlagsTag && (value & s_BindNowFlag)) ||
+					    (tag == s_Flags1Tag && (value & s_Now1Flag)))
+						file.m_LoadCost.isBoundNow = true;
+				}
+			}
+		}
+
+		readSymbols(s_SymbolTableSection);
+		if (file.m_Symbols.empty())
+			readSymbols(s_DynamicSymbolTableSection);
+
+		std::sort(file.m_Symbols.begin(), file.m_Symbols.end(), [](const ElfSymbol& a, const ElfSymbol& b)
+		{
+			return a.address < b.address;
+		});
+
+		for (size_t i = 0; i < file.m_Symbols.size(); i++)
+		{
+			if (file.m_Symbols[i].isFunction)
+				file.m_Functions.push_back(i);
+		}
+
+		file.m_IsValid = true;
+		return file;
+	}
+
+	bool ElfFile::IsValid() const
+	{
+		return m_IsValid;
+	}
+
+	const std::vector<ElfSection>& ElfFile::GetSections() const
+	{
+		return m_Sections;
+	}
+
+	const std::vector<ElfSegment>& ElfFile::GetSegments() const
+	{
+		return m_Segments;
+	}
+
+	const std::vector<ElfSymbol>& ElfFile::GetSymbols() const
+	{
+		return m_Symbols;
+	}
+
+	const ElfLoadCost& ElfFile::GetLoadCost() const
+	{
+		return m_LoadCost;
+	}
+
+	const ElfSymbol* ElfFile::FindFunction(uint64_t address) const
+	{
+		auto it = std::upper_bound(m_Functions.begin(), m_Functions.end(), address,
+		                           [this](uint64_t value, size_t index)
+		                           {
+			                           return value < m_Symbols[index].address;
+		                           });
+		if (it == m_Functions.begin())
+			return nullptr;
+
+		const ElfSymbol& symbol = m_Symbols[*std::prev(it)];
+
+		// Some hand-written assembly has no size, in which case the closest function is the best guess.
+		if (symbol.size > 0 && address >= symbol.address + symbol.size)
+			return nullptr;
+
+		return &symbol;
+	}
+
+	bool ElfFile::GetAddressOfOffset(uint64_t offset, uint64_t& address) const
+	{
+		for (const auto& segment : m_Segments)
+		{
+			if (offset >= segment.offset && offset < segment.offset + segment.fileSize)
+			{
+				address = segment.address + (offset - segment.offset);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::string ElfFile::Demangle(const std::string& name)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+		if (status == 0 && demangled)
+		{
+			std::string result = demangled;
+			std::free(demangled);
+			return result;
+		}
+#endif
+
+		return name;
+	}
+}
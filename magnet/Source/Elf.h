@@ -0,0 +1,94 @@
+#pragma once
+
+namespace MG
+{
+	struct ElfSection
+	{
+		std::string name;
+		uint32_t type = 0;
+		uint64_t flags = 0;
+		uint64_t address = 0;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	// A loadable segment, i.e. a part of the file that is mapped into memory at runtime.
+	struct ElfSegment
+	{
+		uint64_t offset = 0;
+		uint64_t address = 0;
+		uint64_t fileSize = 0;
+		uint64_t memorySize = 0;
+	};
+
+	struct ElfSymbol
+	{
+		// The mangled name, as stored in the file.
+		std::string name;
+		uint64_t address = 0;
+		uint64_t size = 0;
+		bool isFunction = false;
+
+		// Index of the section the symbol is defined in.
+		uint16_t section = 0;
+	};
+
+	// The work the dynamic linker does when it loads the file.
+	struct ElfLoadCost
+	{
+		// Functions and objects the file defines in .dynsym, i.e. those it exports.
+		uint64_t exportedSymbols = 0;
+
+		// Relocations that look up a symbol by name when the file is loaded.
+		uint64_t symbolRelocations = 0;
+
+		// Relocations that only add the load address, which need no lookup.
+		uint64_t relativeRelocations = 0;
+
+		// Calls through the PLT, which are looked up on their first call unless the file is bound now.
+		uint64_t lazyRelocations = 0;
+
+		// Whether the file is linked with -z now, so that the PLT is resolved when it's loaded as well.
+		bool isBoundNow = false;
+	};
+
+	// Reads the sections, segments and symbols of a 64-bit little-endian ELF file, which covers executables and
+	// shared libraries on x86-64 and AArch64 Linux.
+	class ElfFile
+	{
+	public:
+		// Returns an empty file if the path can't be read or isn't a supported ELF file.
+		static ElfFile Load(const std::filesystem::path& path);
+
+		[[nodiscard]] bool IsValid() const;
+
+		[[nodiscard]] const std::vector<ElfSection>& GetSections() const;
+		[[nodiscard]] const std::vector<ElfSegment>& GetSegments() const;
+
+		// Returns the functions and objects from .symtab, or from .dynsym if the file is stripped, sorted by address.
+		[[nodiscard]] const std::vector<ElfSymbol>& GetSymbols() const;
+
+		[[nodiscard]] const ElfLoadCost& GetLoadCost() const;
+
+		// Returns the function that contains the given address, or nullptr if there is none.
+		[[nodiscard]] const ElfSymbol* FindFunction(uint64_t address) const;
+
+		// Converts an offset into the file to the address it is loaded at, as seen in the symbols.
+		// Returns false if the offset isn't part of a loadable segment.
+		[[nodiscard]] bool GetAddressOfOffset(uint64_t offset, uint64_t& address) const;
+
+		// Returns the readable form of a mangled C++ name, or the name itself if it isn't mangled.
+		[[nodiscard]] static std::string Demangle(const std::string& name);
+
+	private:
+		std::vector<ElfSection> m_Sections;
+		std::vector<ElfSegment> m_Segments;
+		std::vector<ElfSymbol> m_Symbols;
+		ElfLoadCost m_LoadCost;
+
+		// Indices into m_Symbols of all functions, sorted by address.
+		std::vector<size_t> m_Functions;
+
+		bool m_IsValid = false;
+	};
+}
@@ -0,0 +1,126 @@
+#include "Event.h"
+
+#include "JsonWriter.h"
+#include "Timings.h"
+
+namespace MG
+{
+	static std::FILE* s_JsonStream = nullptr;
+
+	// Events can be emitted from several threads, e.g. by timing scopes, and every line has to stay whole.
+	static std::mutex s_JsonStreamMutex;
+
+	Event::Event(std::string type)
+			: m_Type(std::move(type))
+	{
+		if (s_JsonStream)
+			m_Time = Timings::GetTime() / 1000.0;
+	}
+
+	Event& Event::AddString(const std::string& key, const std::string& value)
+	{
+		if (s_JsonStream)
+		{
+			Field field;
+			field.key = key;
+			field.type = FieldType::String;
+			field.string = value;
+			m_Fields.push_back(std::move(field));
+		}
+
+		return *this;
+	}
+
+	Event& Event::AddNumber(const std::string& key, double value)
+	{
+		if (s_JsonStream)
+		{
+			Field field;
+			field.key = key;
+			field.type = FieldType::Number;
+			field.number = value;
+			m_Fields.push_back(std::move(field));
+		}
+
+		return *this;
+	}
+
+	Event& Event::AddBool(const std::string& key, bool value)
+	{
+		if (s_JsonStream)
+		{
+			Field field;
+			field.key = key;
+			field.type = FieldType::Bool;
+			field.boolean = value;
+			m_Fields.push_back(std::move(field));
+		}
+
+		return *this;
+	}
+
+	Event& Event::AddList(const std::string& key, const std::vector<std::string>& values)
+	{
+		if (s_JsonStream)
+		{
+			Field field;
+			field.key = key;
+			field.type = FieldType::List;
+			field.list = values;
+			m_Fields.push_back(std::move(field));
+		}
+
+		return *this;
+	}
+
+	void Event::Emit() const
+	{
+		if (!s_JsonStream)
+			return;
+
+		JsonWriter out;
+		out.BeginObject();
+		out.Key("event").String(m_Type);
+		out.Key("time_ms").Number(m_Time);
+
+		for (const auto& field : m_Fields)
+		{
+			out.Key(field.key);
+			switch (field.type)
+			{
+				case FieldType::String:
+					out.String(field.string);
+					break;
+				case FieldType::Number:
+					out.Number(field.number);
+					break;
+				case FieldType::Bool:
+					out.Bool(field.boolean);
+					break;
+				case FieldType::List:
+					out.BeginArray();
+					for (const auto& value : field.list)
+						out.String(value);
+					out.EndArray();
+					break;
+			}
+		}
+
+		out.EndObject();
+
+		std::lock_guard<std::mutex> lock(s_JsonStreamMutex);
+		std::fputs(out.GetString().c_str(), s_JsonStream);
+		std::fputc('\n', s_JsonStream);
+		std::fflush(s_JsonStream);
+	}
+
+	void Event::EnableJsonOutput(std::FILE* stream)
+	{
+		s_JsonStream = stream;
+	}
+
+	bool Event::IsJsonOutputEnabled()
+	{
+		return s_JsonStream != nullptr;
+	}
+}
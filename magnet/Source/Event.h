@@ -0,0 +1,49 @@
+#pragma once
+
+namespace MG
+{
+	// A single line of `--output json`, which CI dashboards and editor plugins read instead of the decorated text.
+	// Every event is a JSON object with its type under "event" and the time since Magnet started under "time_ms",
+	// followed by the fields that were added to it. Events are dropped unless EnableJsonOutput was called.
+	class Event
+	{
+	public:
+		explicit Event(std::string type);
+
+		Event& AddString(const std::string& key, const std::string& value);
+		Event& AddNumber(const std::string& key, double value);
+		Event& AddBool(const std::string& key, bool value);
+		Event& AddList(const std::string& key, const std::vector<std::string>& values);
+
+		// Writes the event as one line and flushes it, so that it can be read while Magnet is still running.
+		void Emit() const;
+
+		// Writes all further events to the given stream.
+		static void EnableJsonOutput(std::FILE* stream);
+		[[nodiscard]] static bool IsJsonOutputEnabled();
+
+	private:
+		enum class FieldType
+		{
+			String,
+			Number,
+			Bool,
+			List
+		};
+
+		struct Field
+		{
+			std::string key;
+			FieldType type = FieldType::String;
+
+			std::string string;
+			double number = 0.0;
+			bool boolean = false;
+			std::vector<std::string> list;
+		};
+
+		std::string m_Type;
+		double m_Time = 0.0;
+		std::vector<Field> m_Fields;
+	};
+}
@@ -0,0 +1,185 @@
+#include "FlameGraph.h"
+
+#include "Hash.h"
+
+namespace MG
+{
+	static constexpr double s_Width = 1200.0;
+	static constexpr double s_Padding = 10.0;
+	static constexpr double s_TitleHeight = 40.0;
+	static constexpr double s_FrameHeight = 16.0;
+
+	// Approximate width of a character of the 12px monospace font, used to shorten labels that don't fit.
+	static constexpr double s_CharacterWidth = 7.2;
+
+	struct FlameNode
+	{
+		std::string name;
+		uint64_t value = 0;
+		std::vector<FlameNode> children;
+	};
+
+	static std::string EscapeXml(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			switch (c)
+			{
+				case '&':
+					escaped += "&amp;";
+					break;
+				case '<':
+					escaped += "&lt;";
+					break;
+				case '>':
+					escaped += "&gt;";
+					break;
+				case '"':
+					escaped += "&quot;";
+					break;
+				default:
+					escaped += c;
+			}
+		}
+
+		return escaped;
+	}
+
+	// Picks a warm color from the name, so that a function has the same color everywhere in the graph.
+	static std::string GetColor(const std::string& name)
+	{
+		uint64_t hash = Hash::FromString(name);
+		return "rgb(" + std::to_string(205 + hash % 50) + "," + std::to_string((hash >> 8) % 230) + "," +
+		       std::to_string((hash >> 16) % 55) + ")";
+	}
+
+	static uint32_t GetDepth(const FlameNode& node)
+	{
+		uint32_t depth = 0;
+		for (const auto& child : node.children)
+			depth = std::max(depth, GetDepth(child));
+
+		return depth + 1;
+	}
+
+	void FlameGraph::AddStack(const std::vector<std::string>& frames, uint64_t count)
+	{
+		if (frames.empty() || count == 0)
+			return;
+
+		std::string stack;
+		for (const auto& frame : frames)
+		{
+			// Semicolons separate the frames in the folded format.
+			std::string name = frame;
+			std::replace(name.begin(), name.end(), ';', ':');
+
+			stack += stack.empty() ? name : ";" + name;
+		}
+
+		m_Stacks[stack] += count;
+		m_SampleCount += count;
+	}
+
+	uint64_t FlameGraph::GetSampleCount() const
+	{
+		return m_SampleCount;
+	}
+
+	bool FlameGraph::WriteFolded(const std::filesystem::path& path) const
+	{
+		std::ofstream file(path);
+		for (const auto& [stack, count] : m_Stacks)
+			file << stack << " " << count << "\n";
+
+		return file.good();
+	}
+
+	bool FlameGraph::WriteSvg(const std::filesystem::path& path, const std::string& title) const
+	{
+		FlameNode root;
+		root.name = "all";
+		root.value = m_SampleCount;
+
+		for (const auto& [stack, count] : m_Stacks)
+		{
+			FlameNode* node = &root;
+
+			std::istringstream frames(stack);
+			std::string frame;
+			while (std::getline(frames, frame, ';'))
+			{
+				auto child = std::find_if(node->children.begin(), node->children.end(),
+				                          [&frame](const FlameNode& candidate)
+				                          {
+					                          return candidate.name == frame;
+				                          });
+
+				if (child == node->children.end())
+				{
+					node->children.push_back({frame, 0, {}});
+					child = std::prev(node->children.end());
+				}
+
+				child->value += count;
+				node = &*child;
+			}
+		}
+
+		double height = s_TitleHeight + GetDepth(root) * s_FrameHeight + s_Padding;
+		double scale = m_SampleCount > 0 ? (s_Width - 2.0 * s_Padding) / (double) m_SampleCount : 0.0;
+
+		std::ofstream file(path);
+		file << std::fixed << std::setprecision(2);
+		file << "<?xml version=\"1.0\" standalone=\"no\"?>\n";
+		file << "<svg version=\"1.1\" width=\"" << s_Width << "\" height=\"" << height << "\" viewBox=\"0 0 "
+		     << s_Width << " " << height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+		file << "<style>text { font-family: monospace; font-size: 12px; } "
+		        "g:hover rect { stroke: #000; stroke-width: 0.5; }</style>\n";
+		file << "<rect x=\"0\" y=\"0\" width=\"100%\" height=\"100%\" fill=\"#f8f8f8\"/>\n";
+		file << "<text x=\"" << s_Width / 2.0 << "\" y=\"24\" text-anchor=\"middle\" style=\"font-size: 17px\">"
+		     << EscapeXml(title) << "</text>\n";
+
+		// The outermost frame is at the bottom, and every frame sits on top of its caller.
+		std::function<void(const FlameNode&, double, uint32_t)> writeNode;
+		writeNode = [&](const FlameNode& node, double x, uint32_t depth)
+		{
+			double width = (double) node.value * scale;
+			if (width < 0.1)
+				return;
+
+			double y = height - s_Padding - (depth + 1) * s_FrameHeight;
+			double share = 100.0 * (double) node.value / (double) m_SampleCount;
+
+			std::ostringstream percentage;
+			percentage << std::fixed << std::setprecision(2) << share;
+
+			file << "<g><title>" << EscapeXml(node.name) << " (" << node.value << " samples, " << percentage.str()
+			     << "%)</title>";
+			file << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << width << "\" height=\""
+			     << s_FrameHeight - 1.0 << "\" rx=\"2\" fill=\"" << GetColor(node.name) << "\"/>";
+
+			auto characters = (size_t) std::max(0.0, (width - 6.0) / s_CharacterWidth);
+			if (characters >= 3)
+			{
+				std::string label = node.name.size() <= characters ? node.name
+				                                                   : node.name.substr(0, characters - 2) + "..";
+				file << "<text x=\"" << x + 3.0 << "\" y=\"" << y + 11.5 << "\">" << EscapeXml(label) << "</text>";
+			}
+
+			file << "</g>\n";
+
+			for (const auto& child : node.children)
+			{
+				writeNode(child, x, depth + 1);
+				x += (double) child.value * scale;
+			}
+		};
+
+		writeNode(root, s_Padding, 0);
+
+		file << "</svg>\n";
+		return file.good();
+	}
+}
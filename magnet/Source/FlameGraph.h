@@ -0,0 +1,27 @@
+#pragma once
+
+namespace MG
+{
+	// Collects sampled call stacks and writes them as folded stacks and as a flame graph.
+	class FlameGraph
+	{
+	public:
+		// Adds a call stack, ordered from the outermost frame to the innermost one.
+		void AddStack(const std::vector<std::string>& frames, uint64_t count = 1);
+
+		[[nodiscard]] uint64_t GetSampleCount() const;
+
+		// Writes one line per distinct stack, with its frames separated by semicolons followed by its count.
+		// This is the collapsed format of flamegraph.pl, which speedscope and most other viewers open as well.
+		bool WriteFolded(const std::filesystem::path& path) const;
+
+		// Writes a self-contained SVG in which the width of every frame is proportional to its samples.
+		// Hovering a frame shows its full name and share of the samples.
+		bool WriteSvg(const std::filesystem::path& path, const std::string& title) const;
+
+	private:
+		// Samples per stack, keyed by the frames joined with semicolons.
+		std::map<std::string, uint64_t> m_Stacks;
+		uint64_t m_SampleCount = 0;
+	};
+}
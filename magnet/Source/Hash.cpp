@@ -0,0 +1,37 @@
+#include "Hash.h"
+
+namespace MG
+{
+	uint64_t Hash::FromString(std::string_view data, uint64_t seed)
+	{
+		uint64_t hash = seed;
+		for (char c : data)
+		{
+			hash ^= (uint8_t) c;
+			hash *= s_Prime;
+		}
+
+		return hash;
+	}
+
+	uint64_t Hash::FromFile(const std::filesystem::path& path, uint64_t seed)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return seed;
+
+		uint64_t hash = seed;
+		char buffer[64 * 1024];
+		while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+			hash = FromString(std::string_view(buffer, (size_t) file.gcount()), hash);
+
+		return hash;
+	}
+
+	std::string Hash::ToString(uint64_t hash)
+	{
+		std::ostringstream stream;
+		stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+		return stream.str();
+	}
+}
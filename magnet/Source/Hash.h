@@ -0,0 +1,22 @@
+#pragma once
+
+namespace MG
+{
+	// Fast, non-cryptographic hashing used for change detection.
+	class Hash
+	{
+	public:
+		// Returns the 64-bit FNV-1a hash of the given data. Pass a previous hash as seed to chain data.
+		[[nodiscard]] static uint64_t FromString(std::string_view data, uint64_t seed = s_OffsetBasis);
+
+		// Returns the hash of the file's content, or the seed if the file cannot be read.
+		[[nodiscard]] static uint64_t FromFile(const std::filesystem::path& path, uint64_t seed = s_OffsetBasis);
+
+		// Returns the hash as a 16 digit hexadecimal string.
+		[[nodiscard]] static std::string ToString(uint64_t hash);
+
+	private:
+		static inline constexpr uint64_t s_OffsetBasis = 14695981039346656037ull;
+		static inline constexpr uint64_t s_Prime = 1099511628211ull;
+	};
+}
@@ -0,0 +1,140 @@
+#include "JsonWriter.h"
+
+namespace MG
+{
+	JsonWriter& JsonWriter::BeginObject()
+	{
+		BeginValue();
+		m_Output += '{';
+		m_IsEmpty.push_back(true);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::EndObject()
+	{
+		m_Output += '}';
+		m_IsEmpty.pop_back();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::BeginArray()
+	{
+		BeginValue();
+		m_Output += '[';
+		m_IsEmpty.push_back(true);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::EndArray()
+	{
+		m_Output += ']';
+		m_IsEmpty.pop_back();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Key(const std::string& key)
+	{
+		String(key);
+		m_Output += ':';
+		m_IsAfterKey = true;
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::String(const std::string& value)
+	{
+		BeginValue();
+		m_Output += '"';
+
+		for (char character : value)
+		{
+			switch (character)
+			{
+				case '"':
+					m_Output += "\\\"";
+					break;
+				case '\\':
+					m_Output += "\\\\";
+					break;
+				case '\b':
+					m_Output += "\\b";
+					break;
+				case '\f':
+					m_Output += "\\f";
+					break;
+				case '\n':
+					m_Output += "\\n";
+					break;
+				case '\r':
+					m_Output += "\\r";
+					break;
+				case '\t':
+					m_Output += "\\t";
+					break;
+				default:
+					// Other control characters, such as the escape of ANSI colors in compiler output.
+					if ((unsigned char) character < 0x20)
+					{
+						char escaped[7];
+						std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) character);
+						m_Output += escaped;
+					}
+					else
+					{
+						m_Output += character;
+					}
+			}
+		}
+
+		m_Output += '"';
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Number(double value)
+	{
+		BeginValue();
+
+		if (!std::isfinite(value))
+		{
+			m_Output += "null";
+			return *this;
+		}
+
+		char written[32];
+		if (value == std::trunc(value) && std::abs(value) < 9.0e15)
+			std::snprintf(written, sizeof(written), "%lld", (long long) value);
+		else
+			std::snprintf(written, sizeof(written), "%.12g", value);
+
+		m_Output += written;
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Bool(bool value)
+	{
+		BeginValue();
+		m_Output += value ? "true" : "false";
+		return *this;
+	}
+
+	const std::string& JsonWriter::GetString() const
+	{
+		return m_Output;
+	}
+
+	void JsonWriter::BeginValue()
+	{
+		if (m_IsAfterKey)
+		{
+			m_IsAfterKey = false;
+			return;
+		}
+
+		if (m_IsEmpty.empty())
+			return;
+
+		if (!m_IsEmpty.back())
+			m_Output += ',';
+
+		m_IsEmpty.back() = false;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace MG
+{
+	// Writes compact JSON, all on one line, for `--output json`, traces and result files. Commas are placed
+	// automatically, so values are simply written in order, each object value after its Key.
+	class JsonWriter
+	{
+	public:
+		JsonWriter& BeginObject();
+		JsonWriter& EndObject();
+		JsonWriter& BeginArray();
+		JsonWriter& EndArray();
+
+		JsonWriter& Key(const std::string& key);
+
+		JsonWriter& String(const std::string& value);
+
+		// Whole numbers, such as counters and byte sizes, are written without a fraction or an exponent.
+		// Infinity and NaN, which JSON has no representation for, are written as null.
+		JsonWriter& Number(double value);
+
+		JsonWriter& Bool(bool value);
+
+		[[nodiscard]] const std::string& GetString() const;
+
+	private:
+		// Adds a comma unless the value is the first in its object or array, or follows a key.
+		void BeginValue();
+
+		std::string m_Output;
+
+		// Whether the innermost object or array is still empty.
+		std::vector<bool> m_IsEmpty;
+		bool m_IsAfterKey = false;
+	};
+}
@@ -0,0 +1,98 @@
+// Compiler launcher used by generated projects (see CMAKE_CXX_COMPILER_LAUNCHER).
+// Runs the given compiler or linker command and appends its resource usage to a log file:
+//
+//   magnet-launcher <log-file> <command> [arguments...]
+//
+// Every invocation appends exactly one tab separated line:
+//   <compile|link> <wall ms> <user ms> <sys ms> <peak rss kb> <exit code> <output file>
+//
+// The line is written with a single write() to a file opened with O_APPEND, so concurrent
+// invocations from a parallel build never interleave.
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static long ToMilliseconds(const timeval& time)
+{
+	return time.tv_sec * 1000 + time.tv_usec / 1000;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::fprintf(stderr, "Usage: magnet-launcher <log-file> <command> [arguments...]\n");
+		return 1;
+	}
+
+	const char* logPath = argv[1];
+	char** command = argv + 2;
+
+	auto start = std::chrono::steady_clock::now();
+
+	pid_t pid;
+	int error = posix_spawnp(&pid, command[0], nullptr, nullptr, command, environ);
+	if (error != 0)
+	{
+		std::fprintf(stderr, "magnet-launcher: failed to run %s: %s\n", command[0], std::strerror(error));
+		return 127;
+	}
+
+	int status = 0;
+	rusage usage {};
+	while (wait4(pid, &status, 0, &usage) == -1)
+	{
+		if (errno != EINTR)
+			return 127;
+	}
+
+	auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start).count();
+
+	int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+	bool isCompile = false;
+	std::string output;
+	for (int i = 3; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-c") == 0)
+			isCompile = true;
+		else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[i + 1];
+	}
+
+	// Linux reports ru_maxrss in kilobytes, macOS in bytes.
+#ifdef __APPLE__
+	long peakMemory = usage.ru_maxrss / 1024;
+#else
+	long peakMemory = usage.ru_maxrss;
+#endif
+
+	char line[4096];
+	int length = std::snprintf(line, sizeof(line), "%s\t%lld\t%ld\t%ld\t%ld\t%d\t%s\n",
+	                           isCompile ? "compile" : "link", (long long) wall, ToMilliseconds(usage.ru_utime),
+	                           ToMilliseconds(usage.ru_stime), peakMemory, exitCode, output.c_str());
+
+	if (length > 0 && length < (int) sizeof(line))
+	{
+		int file = open(logPath, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+		if (file != -1)
+		{
+			[[maybe_unused]] ssize_t written = write(file, line, (size_t) length);
+			close(file);
+		}
+	}
+
+	return exitCode;
+}
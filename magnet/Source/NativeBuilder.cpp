@@ -0,0 +1,431 @@
+#include "NativeBuilder.h"
+
+#include "Core.h"
+#include "Hash.h"
+#include "Platform/Platform.h"
+#include "RebuildExplanation.h"
+#include "ResourceLog.h"
+#include "Timings.h"
+
+namespace MG
+{
+	// Objects are kept apart from those of the Ninja backend, which shares the build folder.
+	static constexpr const char* s_ObjectFolder = "native";
+	static constexpr const char* s_DatabaseName = "native/inputs";
+
+	// The hash of every source and header as of the last build, which `--explain` compares against.
+	static constexpr const char* s_FileDatabaseName = "native/files";
+
+	static std::string JoinArguments(const std::vector<std::string>& arguments)
+	{
+		return std::accumulate(arguments.begin(), arguments.end(), std::string(),
+		                       [](const std::string& a, const std::string& b)
+		                       {
+			                       return a + b + "\n";
+		                       });
+	}
+
+	// Compiler output ends with a newline of its own.
+	static std::string TrimOutput(const std::string& output)
+	{
+		size_t end = output.find_last_not_of("\r\n");
+		return end == std::string::npos ? "" : output.substr(0, end + 1);
+	}
+
+	bool NativeBuilder::Build(const Toolchain& toolchain, const std::filesystem::path& buildPath,
+	                          const std::vector<std::string>& sourceFiles, uint32_t jobs,
+	                          RebuildExplanation* explanation)
+	{
+		std::filesystem::create_directories(buildPath / s_ObjectFolder);
+		std::filesystem::create_directories((buildPath / toolchain.output).parent_path());
+
+		std::filesystem::path databasePath = buildPath / s_DatabaseName;
+		std::map<std::string, std::string> database = ReadDatabase(databasePath);
+		std::map<std::string, std::string> recordedHashes = ReadDatabase(buildPath / s_FileDatabaseName);
+
+		// Headers are shared by many files, so every file is only read once per build.
+		std::unordered_map<std::string, uint64_t> fileHashes;
+
+		auto saveDatabases = [&]()
+		{
+			WriteDatabase(databasePath, database);
+
+			std::map<std::string, std::string> hashes;
+			for (const auto& [path, hash] : fileHashes)
+				hashes[path] = Hash::ToString(hash);
+
+			WriteDatabase(buildPath / s_FileDatabaseName, hashes);
+		};
+
+		std::string flagsHash = Hash::ToString(Hash::FromString(JoinArguments(toolchain.compiler) +
+		                                                        JoinArguments(toolchain.compileFlags)));
+
+		bool hasChangedFlags = database["flags"] != flagsHash;
+		database["flags"] = flagsHash;
+
+		// Returns why an output has to be built again, given that it does.
+		auto explain = [&](const std::string& output) -> std::vector<std::pair<RebuildReason, std::string>>
+		{
+			if (database[output].empty() || !std::filesystem::exists(buildPath / output))
+				return {{RebuildReason::MissingOutput, ""}};
+
+			if (hasChangedFlags)
+				return {{RebuildReason::ChangedFlags, ""}};
+
+			std::vector<std::pair<RebuildReason, std::string>> causes;
+			for (const auto& input : GetChangedInputs(buildPath, output, recordedHashes, fileHashes))
+				causes.emplace_back(RebuildReason::ChangedInput, input);
+
+			return causes;
+		};
+
+		std::vector<std::pair<RebuildReason, std::string>> pchCauses;
+
+		std::vector<std::string> pchFlags;
+		if (!toolchain.pchHeader.empty())
+		{
+			std::string pchHash = GetInputHash(buildPath, toolchain.pchOutput, flagsHash, fileHashes);
+			if (pchHash.empty() || database[toolchain.pchOutput] != pchHash)
+			{
+				if (explanation)
+				{
+					pchCauses = explain(toolchain.pchOutput);
+					for (const auto& [reason, subject] : pchCauses)
+						explanation->Add(reason, subject);
+				}
+
+				ProcessCommand command;
+				command.arguments = toolchain.compiler;
+				command.arguments.insert(command.arguments.end(), {"-MMD", "-MF", toolchain.pchOutput + ".d"});
+				command.arguments.insert(command.arguments.end(), toolchain.compileFlags.begin(),
+				                         toolchain.compileFlags.end());
+				command.arguments.insert(command.arguments.end(), {"-x", "c++-header", "-c", toolchain.pchHeader,
+				                                                   "-o", toolchain.pchOutput});
+				command.workingDirectory = buildPath;
+				command.output = ProcessOutput::Capture;
+
+				MG_LOG("Precompiling " + toolchain.pchHeader + "...");
+
+				Timings::Scope timing("Precompile header", "process", toolchain.pchOutput);
+				ProcessResult result = Platform::RunCommand(command);
+				timing.Stop();
+
+				MG_LOGNH(TrimOutput(result.output));
+				LogResources(buildPath, false, toolchain.pchOutput, result.stats);
+
+				if (!result.IsSuccessful())
+				{
+					database.erase(toolchain.pchOutput);
+					saveDatabases();
+					MG_LOG("Couldn't precompile " + toolchain.pchHeader + ".");
+					return false;
+				}
+
+				// Hashed again, since the depfile now lists the headers it actually included.
+				database[toolchain.pchOutput] = GetInputHash(buildPath, toolchain.pchOutput, flagsHash, fileHashes);
+			}
+
+			// Every file is compiled again when the precompiled header changes.
+			flagsHash = Hash::ToString(Hash::FromString(database[toolchain.pchOutput], Hash::FromString(flagsHash)));
+			pchFlags = {"-include", toolchain.pchHeader};
+			if (!toolchain.isClang)
+				pchFlags.push_back("-Winvalid-pch");
+		}
+
+		std::vector<std::string> objects;
+		std::vector<Compile> compiles;
+		for (const auto& file : sourceFiles)
+		{
+			if (std::filesystem::path(file).extension() != ".cpp")
+				continue;
+
+			std::string object = std::string(s_ObjectFolder) + "/" + file + ".o";
+			objects.push_back(object);
+
+			std::string hash = GetInputHash(buildPath, object, flagsHash, fileHashes);
+			if (!hash.empty() && database[object] == hash)
+				continue;
+
+			compiles.push_back({(toolchain.sourcePath / file).generic_string(), object, flagsHash});
+			if (!explanation)
+				continue;
+
+			// Files that only depend on a changed header through the precompiled header share its causes.
+			auto causes = explain(object);
+			if (causes.empty())
+				causes = pchCauses.empty() ? decltype(causes){{RebuildReason::MissingOutput, ""}} : pchCauses;
+
+			for (const auto& [reason, subject] : causes)
+				explanation->Add(reason, subject);
+		}
+
+		if (explanation)
+			explanation->Print();
+
+		std::vector<ProcessCommand> commands;
+		for (const auto& compile : compiles)
+		{
+			std::filesystem::create_directories((buildPath / compile.object).parent_path());
+
+			ProcessCommand command;
+			command.arguments = toolchain.compiler;
+			command.arguments.insert(command.arguments.end(), {"-MMD", "-MF", compile.object + ".d"});
+			command.arguments.insert(command.arguments.end(), toolchain.compileFlags.begin(),
+			                         toolchain.compileFlags.end());
+			command.arguments.insert(command.arguments.end(), pchFlags.begin(), pchFlags.end());
+			command.arguments.insert(command.arguments.end(), {"-c", compile.source, "-o", compile.object});
+			command.workingDirectory = buildPath;
+			command.output = ProcessOutput::Capture;
+			commands.push_back(command);
+		}
+
+		bool isSuccessful = true;
+		if (!commands.empty())
+		{
+			MG_LOG("Compiling " + std::to_string(commands.size()) + " of " + std::to_string(objects.size()) +
+			       " files...");
+
+			// The compiles are handed out to the job slots one by one as they become free, so that a few slow
+			// files don't leave the other slots idle.
+			Timings::Scope timing("Compile", "process", std::to_string(commands.size()) + " files");
+			std::vector<ProcessResult> results = Platform::RunCommands(commands, jobs);
+			timing.Stop();
+
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const Compile& compile = compiles[i];
+				MG_LOGNH(TrimOutput(results[i].output));
+				LogResources(buildPath, false, compile.object, results[i].stats);
+
+				if (!results[i].IsSuccessful())
+				{
+					database.erase(compile.object);
+					isSuccessful = false;
+					continue;
+				}
+
+				database[compile.object] = GetInputHash(buildPath, compile.object, compile.flagsHash, fileHashes);
+			}
+		}
+
+		// Objects of files that were removed are forgotten, so that the database doesn't grow forever.
+		for (auto it = database.begin(); it != database.end();)
+		{
+			bool isKnown = it->first == "link" || it->first == "flags" || it->first == toolchain.pchOutput ||
+			               std::find(objects.begin(), objects.end(), it->first) != objects.end();
+			it = isKnown ? std::next(it) : database.erase(it);
+		}
+
+		if (!isSuccessful)
+		{
+			saveDatabases();
+			MG_LOG("Some files couldn't be compiled. See messages above for more information.");
+			return false;
+		}
+
+		// The link only depends on which objects there are and what went into them.
+		uint64_t linkHash = Hash::FromString(JoinArguments(toolchain.compiler) + JoinArguments(toolchain.linkFlags));
+		for (const auto& object : objects)
+			linkHash = Hash::FromString(object + " " + database[object] + "\n", linkHash);
+
+		std::string output = toolchain.output.generic_string();
+		if (database["link"] == Hash::ToString(linkHash) && std::filesystem::exists(buildPath / toolchain.output))
+		{
+			saveDatabases();
+			if (commands.empty())
+				MG_LOG("Everything is up to date.");
+
+			return true;
+		}
+
+		ProcessCommand command;
+		if (toolchain.isArchive)
+		{
+			std::filesystem::remove(buildPath / toolchain.output);
+			command.arguments = {"ar", "rcs", output};
+		} else
+		{
+			command.arguments = toolchain.compiler;
+			if (toolchain.isShared)
+				command.arguments.push_back("-shared");
+		}
+
+		command.arguments.insert(command.arguments.end(), objects.begin(), objects.end());
+		if (!toolchain.isArchive)
+		{
+			command.arguments.insert(command.arguments.end(), {"-o", output});
+			command.arguments.insert(command.arguments.end(), toolchain.linkFlags.begin(), toolchain.linkFlags.end());
+		}
+
+		command.workingDirectory = buildPath;
+		command.output = ProcessOutput::Capture;
+
+		MG_LOG("Linking " + toolchain.output.filename().string() + "...");
+
+		Timings::Scope timing("Link", "process", output);
+		ProcessResult result = Platform::RunCommand(command);
+		timing.Stop();
+
+		MG_LOGNH(TrimOutput(result.output));
+		LogResources(buildPath, true, output, result.stats);
+
+		if (!result.IsSuccessful())
+		{
+			database.erase("link");
+			saveDatabases();
+			MG_LOG("Couldn't link " + toolchain.output.filename().string() + ".");
+			return false;
+		}
+
+		database["link"] = Hash::ToString(linkHash);
+		saveDatabases();
+		return true;
+	}
+
+	std::vector<std::string> NativeBuilder::ReadDepfile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return {};
+
+		std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// The first path is the target, followed by a colon. Spaces in paths are escaped with a backslash, and
+		// lines are continued with one.
+		std::vector<std::string> paths;
+		std::string input;
+		bool isTarget = true;
+		for (size_t i = 0; i < content.size(); i++)
+		{
+			char c = content[i];
+			if (c == '\\' && i + 1 < content.size() && (content[i + 1] == ' ' || content[i + 1] == '\n'))
+			{
+				if (content[i + 1] == ' ')
+					input += ' ';
+
+				i++;
+				continue;
+			}
+
+			bool isSeparator = c == ' ' || c == '\n' || c == '\r' || c == '\t';
+			if (isTarget && c == ':' && (i + 1 == content.size() || content[i + 1] == ' ' || content[i + 1] == '\n'))
+			{
+				isTarget = false;
+				input.clear();
+				continue;
+			}
+
+			if (!isSeparator)
+			{
+				input += c;
+				continue;
+			}
+
+			if (!isTarget && !input.empty())
+				paths.push_back(input);
+
+			input.clear();
+		}
+
+		if (!isTarget && !input.empty())
+			paths.push_back(input);
+
+		return paths;
+	}
+
+	std::string NativeBuilder::GetInputHash(const std::filesystem::path& buildPath, const std::string& object,
+	                                        const std::string& flagsHash,
+	                                        std::unordered_map<std::string, uint64_t>& fileHashes)
+	{
+		if (!std::filesystem::exists(buildPath / object))
+			return "";
+
+		std::vector<std::string> inputs = ReadDepfile(buildPath / (object + ".d"));
+		if (inputs.empty())
+			return "";
+
+		uint64_t hash = Hash::FromString(flagsHash);
+		for (const auto& input : inputs)
+		{
+			auto it = fileHashes.find(input);
+			if (it == fileHashes.end())
+			{
+				std::filesystem::path inputPath = buildPath / input;
+
+				// A header that is gone can't be hashed, but the file that included it has to be compiled again.
+				if (!std::filesystem::exists(inputPath))
+					return "";
+
+				it = fileHashes.emplace(input, Hash::FromFile(inputPath)).first;
+			}
+
+			hash = Hash::FromString(input + " " + Hash::ToString(it->second) + "\n", hash);
+		}
+
+		return Hash::ToString(hash);
+	}
+
+	std::vector<std::string> NativeBuilder::GetChangedInputs(const std::filesystem::path& buildPath,
+	                                                         const std::string& object,
+	                                                         const std::map<std::string, std::string>& recordedHashes,
+	                                                         std::unordered_map<std::string, uint64_t>& fileHashes)
+	{
+		std::vector<std::string> changedInputs;
+		for (const auto& input : ReadDepfile(buildPath / (object + ".d")))
+		{
+			auto recorded = recordedHashes.find(input);
+			if (recorded == recordedHashes.end() || !std::filesystem::exists(buildPath / input))
+			{
+				changedInputs.push_back(input);
+				continue;
+			}
+
+			auto it = fileHashes.find(input);
+			if (it == fileHashes.end())
+				it = fileHashes.emplace(input, Hash::FromFile(buildPath / input)).first;
+
+			if (Hash::ToString(it->second) != recorded->second)
+				changedInputs.push_back(input);
+		}
+
+		return changedInputs;
+	}
+
+	std::map<std::string, std::string> NativeBuilder::ReadDatabase(const std::filesystem::path& path)
+	{
+		std::map<std::string, std::string> database;
+
+		// Every line is the hash of the inputs, followed by the output it produced.
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t separator = line.find(' ');
+			if (separator != std::string::npos)
+				database[line.substr(separator + 1)] = line.substr(0, separator);
+		}
+
+		return database;
+	}
+
+	void NativeBuilder::WriteDatabase(const std::filesystem::path& path,
+	                                  const std::map<std::string, std::string>& database)
+	{
+		std::ofstream file(path);
+		for (const auto& [output, hash] : database)
+		{
+			if (!hash.empty())
+				file << hash << " " << output << "\n";
+		}
+	}
+
+	void NativeBuilder::LogResources(const std::filesystem::path& buildPath, bool isLink, const std::string& output,
+	                                 const ProcessStats& stats)
+	{
+		// The same line magnet-launcher appends, with times in milliseconds and memory in kilobytes.
+		std::ofstream log(ResourceLog::GetPath(buildPath), std::ios::app);
+		log << (isLink ? "link" : "compile") << "\t" << (uint64_t) (stats.wallTime / 1e6) << "\t"
+		    << (uint64_t) (stats.userTime / 1e6) << "\t" << (uint64_t) (stats.systemTime / 1e6) << "\t"
+		    << stats.peakMemory / 1024 << "\t" << stats.exitCode << "\t" << output << "\n";
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+namespace MG
+{
+	class RebuildExplanation;
+
+	// How the single target of a project is compiled and linked without CMake, by the Ninja backend and by
+	// `magnet build --native`. Paths are relative to the folder the compiler runs in.
+	struct Toolchain
+	{
+		// The compiler, possibly preceded by a launcher, e.g. "ccache g++".
+		std::vector<std::string> compiler;
+		bool isClang = false;
+
+		std::vector<std::string> compileFlags;
+		std::vector<std::string> linkFlags;
+
+		// The wrapper of PCH.h that every file includes with -include, and the precompiled header next to it,
+		// which GCC and Clang pick up instead. Both are empty if the project has no PCH.h.
+		std::string pchHeader;
+		std::string pchOutput;
+
+		// Static libraries are archived with ar instead of linked, shared libraries are linked with -shared.
+		bool isArchive = false;
+		bool isShared = false;
+
+		std::filesystem::path sourcePath;
+		std::filesystem::path output;
+	};
+
+	// Compiles and links a project by running the compiler directly, without CMake or Ninja. A file is only
+	// recompiled when the content of its source, of a header it included last time or its flags change, so
+	// switching branches back and forth or touching files doesn't cause a rebuild.
+	class NativeBuilder
+	{
+	public:
+		// Builds the given source files, relative to the toolchain's source path, in the build folder, running at
+		// most jobs compilers at the same time. Compile and link times are appended to the resource log, like
+		// magnet-launcher does. If an explanation is given, the cause of every compile is added to it and printed
+		// before the compiles start. Returns false if a step failed.
+		static bool Build(const Toolchain& toolchain, const std::filesystem::path& buildPath,
+		                  const std::vector<std::string>& sourceFiles, uint32_t jobs,
+		                  RebuildExplanation* explanation = nullptr);
+
+	private:
+		// A compile that has to run, along with the hash of its inputs before it ran.
+		struct Compile
+		{
+			std::string source;
+			std::string object;
+			std::string flagsHash;
+		};
+
+		// Returns the files listed in a make-style depfile as written by -MMD, except for the target itself.
+		static std::vector<std::string> ReadDepfile(const std::filesystem::path& path);
+
+		// Returns the hash of the flags, the source and every header the depfile lists, or an empty string if
+		// the object has to be compiled regardless, e.g. because it or its depfile is missing.
+		static std::string GetInputHash(const std::filesystem::path& buildPath, const std::string& object,
+		                                const std::string& flagsHash,
+		                                std::unordered_map<std::string, uint64_t>& fileHashes);
+
+		// Returns the inputs in the depfile of an object whose content differs from the last build, as recorded in
+		// the given hashes.
+		static std::vector<std::string> GetChangedInputs(const std::filesystem::path& buildPath,
+		                                                 const std::string& object,
+		                                                 const std::map<std::string, std::string>& recordedHashes,
+		                                                 std::unordered_map<std::string, uint64_t>& fileHashes);
+
+		static std::map<std::string, std::string> ReadDatabase(const std::filesystem::path& path);
+		static void WriteDatabase(const std::filesystem::path& path,
+		                          const std::map<std::string, std::string>& database);
+
+		// Appends the resource usage of a compile or link to the resource log of the build folder.
+		static void LogResources(const std::filesystem::path& buildPath, bool isLink, const std::string& output,
+		                         const struct ProcessStats& stats);
+	};
+}
@@ -0,0 +1,127 @@
+#include "NinjaEmitter.h"
+
+#include "Core.h"
+#include "Timings.h"
+
+namespace MG
+{
+	NinjaEmitter::NinjaEmitter(const std::filesystem::path& path)
+			: m_Path(path), m_StartTime(Timings::GetTime())
+	{
+		m_Stream.open(path);
+	}
+
+	NinjaEmitter::~NinjaEmitter()
+	{
+		m_Stream.close();
+		Timings::Record("Write Ninja file", "file", m_Path.generic_string(), m_StartTime);
+	}
+
+	void NinjaEmitter::Add_Header()
+	{
+		m_Stream << "# Generated by Magnet v" << MG_VERSION;
+		Add_Newline(1);
+		m_Stream
+				<< "# Do not edit this file since any changes will be overwritten next time the project files are regenerated.";
+		Add_Newline(2);
+	}
+
+	void NinjaEmitter::Add_Newline(int amount)
+	{
+		for (int i = 0; i < amount; i++)
+		{
+			m_Stream << End();
+		}
+	}
+
+	void NinjaEmitter::Add_Comment(const std::string& comment)
+	{
+		m_Stream << "# " << comment << End();
+	}
+
+	void NinjaEmitter::Add_RequiredVersion(const std::string& version)
+	{
+		m_Stream << "ninja_required_version = " << version << End();
+	}
+
+	void NinjaEmitter::Add_Variable(const std::string& name, const std::string& value)
+	{
+		m_Stream << name << " = " << value << End();
+	}
+
+	void NinjaEmitter::Add_Pool(const std::string& name, uint32_t depth)
+	{
+		m_Stream << "pool " << name << End();
+		m_Stream << "  depth = " << depth << End();
+	}
+
+	void NinjaEmitter::Add_Rule(const std::string& name,
+	                            const std::vector<std::pair<std::string, std::string>>& variables)
+	{
+		// Ninja only accepts spaces as indentation.
+		m_Stream << "rule " << name << End();
+		for (const auto& [key, value] : variables)
+			m_Stream << "  " << key << " = " << value << End();
+	}
+
+	void NinjaEmitter::Add_Build(const std::vector<std::string>& outputs, const std::string& rule,
+	                             const std::vector<std::string>& inputs,
+	                             const std::vector<std::string>& implicitInputs,
+	                             const std::vector<std::string>& orderOnlyInputs,
+	                             const std::vector<std::pair<std::string, std::string>>& variables)
+	{
+		m_Stream << "build";
+		Add_Paths(outputs);
+		m_Stream << ": " << rule;
+		Add_Paths(inputs);
+
+		if (!implicitInputs.empty())
+		{
+			m_Stream << " |";
+			Add_Paths(implicitInputs);
+		}
+
+		if (!orderOnlyInputs.empty())
+		{
+			m_Stream << " ||";
+			Add_Paths(orderOnlyInputs);
+		}
+
+		m_Stream << End();
+
+		for (const auto& [key, value] : variables)
+			m_Stream << "  " << key << " = " << value << End();
+	}
+
+	void NinjaEmitter::Add_Default(const std::vector<std::string>& targets)
+	{
+		m_Stream << "default";
+		Add_Paths(targets);
+		m_Stream << End();
+	}
+
+	std::string NinjaEmitter::EscapePath(const std::string& path)
+	{
+		std::string escaped;
+		for (char c : path)
+		{
+			if (c == '$' || c == ' ' || c == ':')
+				escaped += '$';
+
+			escaped += c;
+		}
+
+		return escaped;
+	}
+
+	char NinjaEmitter::End()
+	{
+		return '\n';
+	}
+
+	void NinjaEmitter::Add_Paths(const std::vector<std::string>& paths)
+	{
+		for (const auto& path : paths)
+			m_Stream << " " << EscapePath(path);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+namespace MG
+{
+	// Writes a build.ninja file for the fast backend, which skips the CMake configure step entirely.
+	// https://ninja-build.org/manual.html#_writing_your_own_ninja_files
+	class NinjaEmitter
+	{
+	public:
+		explicit NinjaEmitter(const std::filesystem::path& path);
+
+		// Records how long the file took to generate, for `--timings`.
+		~NinjaEmitter();
+
+		// Adds the default "Generated by Magnet" text.
+		void Add_Header();
+
+		// Adds a newline character to the current stream.
+		void Add_Newline(int amount = 1);
+
+		void Add_Comment(const std::string& comment);
+
+		// https://ninja-build.org/manual.html#ref_ninja_file
+		void Add_RequiredVersion(const std::string& version);
+
+		// Adds a top-level variable. The value is written as it is, so paths in it have to be escaped.
+		// https://ninja-build.org/manual.html#_variables
+		void Add_Variable(const std::string& name, const std::string& value);
+
+		// https://ninja-build.org/manual.html#ref_pool
+		void Add_Pool(const std::string& name, uint32_t depth);
+
+		// Adds a rule with the given variables, such as command, depfile or pool.
+		// https://ninja-build.org/manual.html#_rules
+		void Add_Rule(const std::string& name, const std::vector<std::pair<std::string, std::string>>& variables);
+
+		// Adds a build statement. Outputs and inputs are escaped, variables are written as they are.
+		// Implicit inputs cause a rebuild like inputs, but don't appear in $in. Order-only inputs only have to
+		// exist before the outputs are built.
+		// https://ninja-build.org/manual.html#_build_statements
+		void Add_Build(const std::vector<std::string>& outputs, const std::string& rule,
+		               const std::vector<std::string>& inputs, const std::vector<std::string>& implicitInputs = {},
+		               const std::vector<std::string>& orderOnlyInputs = {},
+		               const std::vector<std::pair<std::string, std::string>>& variables = {});
+
+		// https://ninja-build.org/manual.html#_default_target_statements
+		void Add_Default(const std::vector<std::string>& targets);
+
+		// Escapes the characters that ninja treats specially in paths: spaces, colons and dollar signs.
+		// https://ninja-build.org/manual.html#ref_lexer
+		[[nodiscard]] static std::string EscapePath(const std::string& path);
+
+	private:
+		// Returns a newline character.
+		static char End();
+
+		// Adds the escaped paths, each preceded by a space.
+		void Add_Paths(const std::vector<std::string>& paths);
+
+		std::ofstream m_Stream;
+
+		std::filesystem::path m_Path;
+		double m_StartTime;
+	};
+}
@@ -2,12 +2,25 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <set>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <cstdio>
 #include <cstring>
 #include <functional>
 #include <regex>
 #include <numeric>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <ctime>
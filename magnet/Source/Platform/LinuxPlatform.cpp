@@ -2,11 +2,279 @@
 
 #include "Platform.h"
 
+#include <fcntl.h>
 #include <limits.h>
+#include <linux/perf_event.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 namespace MG
 {
+	struct CounterEvent
+	{
+		uint32_t type;
+		uint64_t config;
+	};
+
+	static constexpr uint64_t GetCacheEvent(uint64_t cache, uint64_t operation, uint64_t result)
+	{
+		return cache | (operation << 8) | (result << 16);
+	}
+
+	// The generic events of perf_event_open, named like `perf stat` names them.
+	static const std::map<std::string, CounterEvent> s_CounterEvents = {
+			{"cycles",                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+			{"instructions",          {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+			{"branches",              {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}},
+			{"branch-misses",         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+			{"cache-references",      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+			{"cache-misses",          {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+			{"L1-dcache-loads",       {PERF_TYPE_HW_CACHE, GetCacheEvent(PERF_COUNT_HW_CACHE_L1D,
+			                                                             PERF_COUNT_HW_CACHE_OP_READ,
+			                                                             PERF_COUNT_HW_CACHE_RESULT_ACCESS)}},
+			{"L1-dcache-load-misses", {PERF_TYPE_HW_CACHE, GetCacheEvent(PERF_COUNT_HW_CACHE_L1D,
+			                                                             PERF_COUNT_HW_CACHE_OP_READ,
+			                                                             PERF_COUNT_HW_CACHE_RESULT_MISS)}},
+			{"LLC-loads",             {PERF_TYPE_HW_CACHE, GetCacheEvent(PERF_COUNT_HW_CACHE_LL,
+			                                                             PERF_COUNT_HW_CACHE_OP_READ,
+			                                                             PERF_COUNT_HW_CACHE_RESULT_ACCESS)}},
+			{"LLC-load-misses",       {PERF_TYPE_HW_CACHE, GetCacheEvent(PERF_COUNT_HW_CACHE_LL,
+			                                                             PERF_COUNT_HW_CACHE_OP_READ,
+			                                                             PERF_COUNT_HW_CACHE_RESULT_MISS)}},
+			{"task-clock",            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+			{"page-faults",           {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+			{"major-faults",          {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ}},
+			{"minor-faults",          {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN}},
+			{"context-switches",      {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}},
+			{"cpu-migrations",        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}},
+	};
+
+	// Size of the ring buffer per CPU that samples are written to, in pages. Must be a power of two.
+	static constexpr uint64_t s_SampleBufferPages = 32;
+
+	// Counted instead when no hardware counter can be opened.
+	static const CounterGroup s_SoftwareCounterGroup = {"task-clock", "page-faults", "context-switches",
+	                                                    "cpu-migrations"};
+
+	struct CounterHandle
+	{
+		std::string event;
+		int fd;
+	};
+
+	// Opens a counter for the process that is about to exec. Only the group leader starts disabled, since the
+	// whole group is enabled together on exec.
+	static int OpenCounter(const CounterEvent& event, pid_t pid, int groupFd)
+	{
+		perf_event_attr attributes {};
+		attributes.size = sizeof(attributes);
+		attributes.type = event.type;
+		attributes.config = event.config;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attributes.disabled = groupFd == -1;
+		attributes.enable_on_exec = groupFd == -1;
+		attributes.inherit = 1;
+		attributes.exclude_hv = 1;
+
+		int fd = (int) syscall(SYS_perf_event_open, &attributes, pid, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+		if (fd >= 0 || (errno != EACCES && errno != EPERM))
+			return fd;
+
+		// With kernel.perf_event_paranoid >= 2, unprivileged users may only count in user space.
+		attributes.exclude_kernel = 1;
+		return (int) syscall(SYS_perf_event_open, &attributes, pid, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+	}
+
+	static std::vector<CounterHandle> OpenCounters(const std::vector<CounterGroup>& groups, pid_t pid)
+	{
+		std::vector<CounterHandle> counters;
+		bool isHardwareRequested = false;
+		bool isHardwareOpen = false;
+
+		auto openGroup = [&](const CounterGroup& group)
+		{
+			int groupFd = -1;
+			for (const auto& name : group)
+			{
+				auto event = s_CounterEvents.find(name);
+				if (event == s_CounterEvents.end())
+					continue;
+
+				bool isHardware = event->second.type != PERF_TYPE_SOFTWARE;
+				isHardwareRequested |= isHardware;
+
+				// Events that are unavailable on this machine are left out, and the next one leads the group.
+				int fd = OpenCounter(event->second, pid, groupFd);
+				if (fd < 0)
+					continue;
+
+				isHardwareOpen |= isHardware;
+				if (groupFd == -1)
+					groupFd = fd;
+
+				counters.push_back({name, fd});
+			}
+		};
+
+		for (const auto& group : groups)
+			openGroup(group);
+
+		if (isHardwareRequested && !isHardwareOpen)
+		{
+			CounterGroup fallback;
+			for (const auto& name : s_SoftwareCounterGroup)
+			{
+				auto isOpen = [&name](const CounterHandle& counter) { return counter.event == name; };
+				if (std::none_of(counters.begin(), counters.end(), isOpen))
+					fallback.push_back(name);
+			}
+
+			openGroup(fallback);
+		}
+
+		return counters;
+	}
+
+	static std::vector<CounterValue> ReadCounters(const std::vector<CounterHandle>& counters)
+	{
+		std::vector<CounterValue> values;
+		for (const auto& counter : counters)
+		{
+			// The value, followed by the time the counter was enabled and the time it was actually counting.
+			uint64_t data[3] = {};
+			bool isRead = read(counter.fd, data, sizeof(data)) == (ssize_t) sizeof(data);
+			close(counter.fd);
+
+			if (!isRead || data[2] == 0)
+				continue;
+
+			CounterValue value;
+			value.event = counter.event;
+			value.value = (double) data[0];
+			if (data[2] < data[1])
+			{
+				value.value *= (double) data[1] / (double) data[2];
+				value.isScaled = true;
+			}
+
+			values.push_back(value);
+		}
+
+		return values;
+	}
+
+	// Forks a child that waits until the gate is closed before it execs the executable, so that perf events can be
+	// attached to it first. Returns the pid of the child, or -1.
+	static pid_t ForkSuspended(const std::string& path, const std::vector<std::string>& arguments, bool discardOutput,
+	                           int& gate)
+	{
+		// Everything the child needs is prepared before forking, since it must not allocate memory afterwards.
+		std::vector<char*> argv;
+		argv.push_back(const_cast<char*>(path.c_str()));
+		for (const auto& argument : arguments)
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		argv.push_back(nullptr);
+
+		int fds[2];
+		if (pipe2(fds, O_CLOEXEC) != 0)
+			return -1;
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			if (discardOutput)
+			{
+				int null = open("/dev/null", O_WRONLY);
+				dup2(null, STDOUT_FILENO);
+				dup2(null, STDERR_FILENO);
+			}
+
+			// Blocks until the parent closes its end of the pipe.
+			char byte;
+			close(fds[1]);
+			while (read(fds[0], &byte, 1) < 0 && errno == EINTR)
+				;
+
+			execv(path.c_str(), argv.data());
+			_exit(127);
+		}
+
+		close(fds[0]);
+		if (pid < 0)
+		{
+			close(fds[1]);
+			return -1;
+		}
+
+		gate = fds[1];
+		return pid;
+	}
+
+	// Copies size bytes from the ring buffer of a sampling event, starting at the given position.
+	static void ReadRingBuffer(const char* data, uint64_t dataSize, uint64_t position, void* destination,
+	                           size_t size)
+	{
+		auto* bytes = static_cast<char*>(destination);
+		for (size_t i = 0; i < size; i++)
+			bytes[i] = data[(position + i) % dataSize];
+	}
+
+	static void ParseSampleRecord(const std::vector<char>& record, uint32_t type, ProcessSamples& samples)
+	{
+		auto readValue = [&record](size_t offset)
+		{
+			uint64_t value = 0;
+			if (offset + sizeof(value) <= record.size())
+				std::memcpy(&value, record.data() + offset, sizeof(value));
+			return value;
+		};
+
+		// The layouts follow the perf_event_header of 8 bytes, see `man perf_event_open`.
+		switch (type)
+		{
+			case PERF_RECORD_MMAP:
+			{
+				MappedFile mapping;
+				mapping.start = readValue(16);
+				mapping.end = mapping.start + readValue(24);
+				mapping.offset = readValue(32);
+				if (record.size() > 40)
+					mapping.path = std::string(record.data() + 40, strnlen(record.data() + 40, record.size() - 40));
+
+				samples.mappings.push_back(mapping);
+				break;
+			}
+			case PERF_RECORD_SAMPLE:
+			{
+				// The instruction pointer and the pid and tid come first, followed by the call chain.
+				uint64_t count = readValue(24);
+				std::vector<uint64_t> stack;
+				for (uint64_t i = 0; i < count && 32 + (i + 1) * 8 <= record.size(); i++)
+				{
+					// Markers such as PERF_CONTEXT_USER separate kernel and user frames.
+					uint64_t address = readValue(32 + i * 8);
+					if (address < (uint64_t) PERF_CONTEXT_MAX)
+						stack.push_back(address);
+				}
+
+				if (stack.empty())
+					stack.push_back(readValue(8));
+
+				samples.stacks.push_back(std::move(stack));
+				break;
+			}
+			case PERF_RECORD_LOST:
+				samples.lostCount += readValue(16);
+				break;
+			default:
+				break;
+		}
+	}
+
 	void Platform::Initialize()
 	{
 	}
@@ -34,14 +302,247 @@ namespace MG
 		return p;
 	}
 
-	std::string Platform::GetGenerateCommand([[maybe_unused]] const std::string& configuration)
+	std::vector<std::string> Platform::GetGenerateArguments(const std::string& configuration)
+	{
+		return {"-G", "Ninja", "-DCMAKE_BUILD_TYPE=" + configuration};
+	}
+
+	std::filesystem::path Platform::GetAllocationShimPath()
 	{
-		return "-G \"Ninja\" -DCMAKE_BUILD_TYPE=" + configuration;
+		return GetExecutablePath() / "libmagnet-alloc-shim.so";
 	}
 
-	std::string Platform::GetGoCommand(const std::string& appPath)
+	void Platform::SetEnvironment(const std::string& name, const std::string& value)
 	{
-		return "./ " + appPath;
+		setenv(name.c_str(), value.c_str(), 1);
+	}
+
+	uint64_t Platform::GetAvailableMemory()
+	{
+		// MemAvailable accounts for reclaimable page cache, unlike _SC_AVPHYS_PAGES.
+		std::ifstream meminfo("/proc/meminfo");
+		std::string key;
+		uint64_t value = 0;
+		std::string unit;
+		while (meminfo >> key >> value >> unit)
+		{
+			if (key == "MemAvailable:")
+				return value * 1024;
+		}
+
+		long pages = sysconf(_SC_AVPHYS_PAGES);
+		long pageSize = sysconf(_SC_PAGESIZE);
+		if (pages <= 0 || pageSize <= 0)
+			return 0;
+
+		return (uint64_t) pages * (uint64_t) pageSize;
+	}
+
+	bool Platform::RunProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+	                          bool discardOutput, ProcessStats& stats, const std::vector<CounterGroup>& counterGroups)
+	{
+		std::string path = executable.string();
+		auto start = std::chrono::steady_clock::now();
+
+		int gate = -1;
+		pid_t pid = ForkSuspended(path, arguments, discardOutput, gate);
+		if (pid < 0)
+			return false;
+
+		std::vector<CounterHandle> counters = OpenCounters(counterGroups, pid);
+		close(gate);
+
+		// wait4 reports the usage of exactly this child, unlike getrusage, which accumulates all of them.
+		int status = 0;
+		rusage usage {};
+		if (wait4(pid, &status, 0, &usage) != pid)
+			return false;
+
+		stats.wallTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		stats.userTime = (double) usage.ru_utime.tv_sec * 1e9 + (double) usage.ru_utime.tv_usec * 1e3;
+		stats.systemTime = (double) usage.ru_stime.tv_sec * 1e9 + (double) usage.ru_stime.tv_usec * 1e3;
+		stats.peakMemory = (uint64_t) usage.ru_maxrss * 1024;
+		stats.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+		stats.counters = ReadCounters(counters);
+
+		// exec failing is indistinguishable from a program that exits with 127, so check for the usual reason.
+		return stats.exitCode != 127 || access(path.c_str(), X_OK) == 0;
+	}
+
+	bool Platform::SampleProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+	                             uint32_t frequency, ProcessSamples& samples)
+	{
+		std::string path = executable.string();
+
+		int gate = -1;
+		pid_t pid = ForkSuspended(path, arguments, false, gate);
+		if (pid < 0)
+			return false;
+
+		// The CPU clock is a software event, so sampling works in virtual machines without hardware counters.
+		perf_event_attr attributes {};
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_SOFTWARE;
+		attributes.config = PERF_COUNT_SW_CPU_CLOCK;
+		attributes.sample_freq = frequency;
+		attributes.freq = 1;
+		attributes.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+		attributes.disabled = 1;
+		attributes.enable_on_exec = 1;
+		attributes.inherit = 1;
+		attributes.mmap = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.exclude_callchain_kernel = 1;
+
+		long pageSize = sysconf(_SC_PAGESIZE);
+		uint64_t dataSize = (uint64_t) pageSize * s_SampleBufferPages;
+		size_t bufferSize = (size_t) (pageSize + dataSize);
+
+		struct RingBuffer
+		{
+			int fd;
+			void* memory;
+		};
+
+		// Inherited events can only be read through a buffer if there is one per CPU, which is what perf does too.
+		std::vector<RingBuffer> buffers;
+		long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+		for (int cpu = 0; cpu < cpuCount; cpu++)
+		{
+			int fd = (int) syscall(SYS_perf_event_open, &attributes, pid, cpu, -1, PERF_FLAG_FD_CLOEXEC);
+			if (fd < 0)
+				continue;
+
+			void* memory = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (memory == MAP_FAILED)
+			{
+				close(fd);
+				continue;
+			}
+
+			buffers.push_back({fd, memory});
+		}
+
+		if (buffers.empty())
+		{
+			kill(pid, SIGKILL);
+			close(gate);
+			waitpid(pid, nullptr, 0);
+			return false;
+		}
+
+		close(gate);
+
+		std::vector<char> record;
+		auto drain = [&](const RingBuffer& buffer)
+		{
+			// The first page holds the positions in the ring buffer, the data follows.
+			auto* header = static_cast<perf_event_mmap_page*>(buffer.memory);
+			const char* data = static_cast<const char*>(buffer.memory) + pageSize;
+
+			uint64_t head = __atomic_load_n(&header->data_head, __ATOMIC_ACQUIRE);
+			uint64_t tail = header->data_tail;
+
+			while (tail + sizeof(perf_event_header) <= head)
+			{
+				perf_event_header recordHeader {};
+				ReadRingBuffer(data, dataSize, tail, &recordHeader, sizeof(recordHeader));
+				if (recordHeader.size < sizeof(recordHeader) || tail + recordHeader.size > head)
+					break;
+
+				record.resize(recordHeader.size);
+				ReadRingBuffer(data, dataSize, tail, record.data(), record.size());
+				ParseSampleRecord(record, recordHeader.type, samples);
+
+				tail += recordHeader.size;
+			}
+
+			__atomic_store_n(&header->data_tail, tail, __ATOMIC_RELEASE);
+		};
+
+		// The buffers are emptied regularly while the process runs, so that they don't overflow.
+		int status = 0;
+		while (true)
+		{
+			for (const auto& buffer : buffers)
+				drain(buffer);
+
+			pid_t result = waitpid(pid, &status, WNOHANG);
+			if (result == pid || result < 0)
+				break;
+
+			usleep(10000);
+		}
+
+		for (const auto& buffer : buffers)
+		{
+			drain(buffer);
+			munmap(buffer.memory, bufferSize);
+			close(buffer.fd);
+		}
+
+		samples.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+		return samples.exitCode != 127 || access(path.c_str(), X_OK) == 0;
+	}
+
+	std::vector<std::string> Platform::GetCounterEvents()
+	{
+		std::vector<std::string> events;
+		for (const auto& [name, event] : s_CounterEvents)
+			events.push_back(name);
+
+		return events;
+	}
+
+	std::vector<std::string> Platform::GetBenchmarkWarnings()
+	{
+		std::vector<std::string> warnings;
+
+		auto readLine = [](const std::filesystem::path& path)
+		{
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		};
+
+		std::string governor;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/cpu", error))
+		{
+			std::string cpu = entry.path().filename().string();
+			if (cpu.rfind("cpu", 0) != 0 || cpu.size() == 3 || !std::isdigit((unsigned char) cpu[3]))
+				continue;
+
+			std::string value = readLine(entry.path() / "cpufreq" / "scaling_governor");
+			if (!value.empty() && value != "performance")
+			{
+				governor = value;
+				break;
+			}
+		}
+
+		if (!governor.empty())
+			warnings.push_back("CPU frequency scaling is enabled (governor `" + governor + "`). Consider "
+			                   "`sudo cpupower frequency-set --governor performance` while benchmarking.");
+
+		if (readLine("/sys/devices/system/cpu/intel_pstate/no_turbo") == "0" ||
+		    readLine("/sys/devices/system/cpu/cpufreq/boost") == "1")
+			warnings.push_back("Turbo boost is enabled, so clock speeds depend on temperature and load.");
+
+		// Anything else running competes for cores, caches and memory bandwidth.
+		double load = 0.0;
+		uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+		if (getloadavg(&load, 1) == 1 && load > std::max(1.0, (double) cores / 2.0))
+		{
+			std::ostringstream warning;
+			warning << std::fixed << std::setprecision(1) << "The system is busy (load average " << load << " on "
+			        << cores << " cores).";
+			warnings.push_back(warning.str());
+		}
+
+		return warnings;
 	}
 }
 
@@ -2,6 +2,115 @@
 
 namespace MG
 {
+	// A performance counter such as "instructions", counted over the lifetime of a process and its children.
+	struct CounterValue
+	{
+		std::string event;
+		double value = 0.0;
+
+		// Whether the kernel had to share the hardware with other counters, so the value is extrapolated from the
+		// fraction of the time it was counting.
+		bool isScaled = false;
+	};
+
+	// Performance counters that are opened together, so that ratios between them are measured over the same time.
+	using CounterGroup = std::vector<std::string>;
+
+	// A file mapped into the memory of a sampled process, used to symbolize the sampled addresses.
+	struct MappedFile
+	{
+		uint64_t start = 0;
+		uint64_t end = 0;
+
+		// Offset into the file at which the mapping starts.
+		uint64_t offset = 0;
+		std::string path;
+	};
+
+	// Call stacks sampled from a process while it was running on a CPU.
+	struct ProcessSamples
+	{
+		std::vector<MappedFile> mappings;
+
+		// Return addresses of every sample, innermost frame first.
+		std::vector<std::vector<uint64_t>> stacks;
+
+		// Samples that were dropped since they couldn't be read fast enough.
+		uint64_t lostCount = 0;
+		int exitCode = -1;
+	};
+
+	// Time and memory used by a single run of a process.
+	struct ProcessStats
+	{
+		int exitCode = -1;
+
+		// In nanoseconds.
+		double wallTime = 0.0;
+		double userTime = 0.0;
+		double systemTime = 0.0;
+
+		// Peak resident set size in bytes.
+		uint64_t peakMemory = 0;
+
+		// Only the counters that could be opened, in the order they were requested.
+		std::vector<CounterValue> counters;
+	};
+
+	// What happens to the output of a process started by Platform::RunCommands.
+	enum class ProcessOutput
+	{
+		// Written to the terminal, like Magnet's own output.
+		Stream,
+
+		// Stored in ProcessResult::output, with stderr merged into stdout.
+		Capture,
+
+		// Only stdout is stored in ProcessResult::output, and stderr is discarded.
+		CaptureStdout,
+
+		Discard
+	};
+
+	// A process that is started directly instead of through the shell, so that arguments are passed exactly as
+	// they are, including spaces and quotes.
+	struct ProcessCommand
+	{
+		// The executable, which is looked up in PATH unless it's a path, followed by its arguments.
+		std::vector<std::string> arguments;
+
+		// Where the process starts. Empty to use Magnet's working directory.
+		std::filesystem::path workingDirectory;
+
+		// Variables that are set for the process only, on top of Magnet's own environment.
+		std::map<std::string, std::string> environment;
+
+		ProcessOutput output = ProcessOutput::Stream;
+
+		// In seconds. The process and everything it started are killed once it runs longer. 0 waits indefinitely.
+		double timeout = 0.0;
+	};
+
+	struct ProcessResult
+	{
+		// Time and memory of the process. The exit code is -1 if it didn't exit by itself.
+		ProcessStats stats;
+
+		// The signal that terminated the process, or 0 if it exited by itself. Always 0 on Windows.
+		int signal = 0;
+
+		bool isStarted = false;
+		bool isTimedOut = false;
+
+		// Everything the process wrote, if its output was captured.
+		std::string output;
+
+		[[nodiscard]] bool IsSuccessful() const
+		{
+			return isStarted && stats.exitCode == 0;
+		}
+	};
+
 	class Platform
 	{
 	public:
@@ -10,9 +119,51 @@ namespace MG
 		// Returns the real path to the executable. Does not include the executable name.
 		static std::filesystem::path GetExecutablePath();
 
-		// Returns the CMake generator command for the current platform.
-		static std::string GetGenerateCommand(const std::string& configuration);
+		// Returns the arguments that select the CMake generator for the current platform.
+		static std::vector<std::string> GetGenerateArguments(const std::string& configuration);
+
+		// Sets an environment variable of Magnet, which is inherited by every command it runs afterwards.
+		static void SetEnvironment(const std::string& name, const std::string& value);
+
+		// Points stdout at stderr, so that Magnet's text and the output of every process it starts go there, and
+		// returns a stream to the original stdout, which is then only written by `--output json`.
+		// Returns nullptr if stdout couldn't be moved.
+		static std::FILE* SeparateStandardOutput();
+
+		// Returns the library that `magnet go --alloc-profile` preloads into projects, or an empty path if
+		// allocation profiling isn't supported on this platform.
+		static std::filesystem::path GetAllocationShimPath();
+
+		// Returns the amount of physical memory in bytes that can be used without swapping.
+		// Returns 0 if it cannot be determined.
+		static uint64_t GetAvailableMemory();
+
+		// Starts the commands, at most jobs of them at the same time or all at once if it's 0, and waits until
+		// all of them exited. Returns their results in the same order.
+		static std::vector<ProcessResult> RunCommands(const std::vector<ProcessCommand>& commands, uint32_t jobs = 0);
+
+		// Starts a single command and waits until it exited.
+		static ProcessResult RunCommand(const ProcessCommand& command);
+
+		// Runs the executable directly instead of through the shell, so that only the process itself is measured,
+		// and waits for it to exit. Output is sent to the null device if discardOutput is set.
+		// The given counter groups are counted from the moment the executable starts. If no hardware counter is
+		// available, e.g. in a container, software counters such as page faults are counted instead.
+		// Returns false if the process couldn't be started.
+		static bool RunProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+		                       bool discardOutput, ProcessStats& stats,
+		                       const std::vector<CounterGroup>& counterGroups = {});
+
+		// Runs the executable and samples its call stacks at the given frequency in Hz, by walking frame pointers.
+		// Returns false if the process couldn't be started or sampled, e.g. because the platform doesn't support it.
+		static bool SampleProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+		                          uint32_t frequency, ProcessSamples& samples);
+
+		// Returns the names of all counters that RunProcess supports. Empty if the platform has none.
+		static std::vector<std::string> GetCounterEvents();
 
-		static std::string GetGoCommand(const std::string& appPath);
+		// Returns a warning for every setting of the machine that makes benchmark results unreliable,
+		// such as CPU frequency scaling or a busy system.
+		static std::vector<std::string> GetBenchmarkWarnings();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,376 @@
+#if defined(__linux__) || defined(__APPLE__)
+
+#include "Platform.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// posix_spawn can only change the working directory of the child since glibc 2.29 and macOS 10.15.
+#if defined(__APPLE__) || (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)))
+#define MG_HAS_SPAWN_CHDIR 1
+#else
+#define MG_HAS_SPAWN_CHDIR 0
+#endif
+
+namespace MG
+{
+	// How often processes are checked for having exited while others are still writing output or have a timeout.
+	static constexpr int s_ProcessPollInterval = 5;
+
+	// A process started by RunCommands that hasn't been waited for yet.
+	struct RunningProcess
+	{
+		size_t index = 0;
+		pid_t pid = -1;
+
+		// The read end of the pipe its output is captured through, or -1.
+		int outputFd = -1;
+
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point deadline;
+		bool hasDeadline = false;
+	};
+
+	static bool OpenPipe(int fds[2])
+	{
+#ifdef __linux__
+		return pipe2(fds, O_CLOEXEC) == 0;
+#else
+		if (pipe(fds) != 0)
+			return false;
+
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+		return true;
+#endif
+	}
+
+	// Returns Magnet's environment with the variables of the command replaced or added, as NAME=value strings.
+	static std::vector<std::string> GetEnvironment(const ProcessCommand& command)
+	{
+		std::vector<std::string> variables;
+		for (char** variable = environ; *variable; variable++)
+		{
+			std::string_view entry(*variable);
+			if (!command.environment.count(std::string(entry.substr(0, entry.find('=')))))
+				variables.emplace_back(entry);
+		}
+
+		for (const auto& [name, value] : command.environment)
+			variables.push_back(name + "=" + value);
+
+		return variables;
+	}
+
+	// Starts the process without going through the shell. Returns the pid of the child, or -1.
+	static pid_t SpawnProcess(const ProcessCommand& command, int outputFd)
+	{
+		std::vector<char*> argv;
+		for (const auto& argument : command.arguments)
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		argv.push_back(nullptr);
+
+		std::vector<std::string> variables;
+		std::vector<char*> envp;
+		if (!command.environment.empty())
+		{
+			variables = GetEnvironment(command);
+			for (auto& variable : variables)
+				envp.push_back(variable.data());
+			envp.push_back(nullptr);
+		}
+
+		char** environment = envp.empty() ? environ : envp.data();
+
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+
+		// dup2 clears close-on-exec on the duplicate, so only the child's stdout and stderr stay open.
+		if (outputFd >= 0)
+		{
+			posix_spawn_file_actions_adddup2(&actions, outputFd, STDOUT_FILENO);
+			if (command.output == ProcessOutput::CaptureStdout)
+				posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+			else
+				posix_spawn_file_actions_adddup2(&actions, outputFd, STDERR_FILENO);
+		} else if (command.output == ProcessOutput::Discard)
+		{
+			posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+			posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+		}
+
+		std::string workingDirectory = command.workingDirectory.string();
+#if MG_HAS_SPAWN_CHDIR
+		if (!workingDirectory.empty())
+			posix_spawn_file_actions_addchdir_np(&actions, workingDirectory.c_str());
+#endif
+
+		// With a timeout, the process leads a group of its own, so that whatever it started is killed with it.
+		// Otherwise it stays in the foreground group, so that Ctrl+C reaches it.
+		posix_spawnattr_t attributes;
+		posix_spawnattr_init(&attributes);
+		if (command.timeout > 0.0)
+		{
+			posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+			posix_spawnattr_setpgroup(&attributes, 0);
+		}
+
+		pid_t pid = -1;
+#if MG_HAS_SPAWN_CHDIR
+		if (posix_spawnp(&pid, argv[0], &actions, &attributes, argv.data(), environment) != 0)
+			pid = -1;
+#else
+		if (workingDirectory.empty())
+		{
+			if (posix_spawnp(&pid, argv[0], &actions, &attributes, argv.data(), environment) != 0)
+				pid = -1;
+		} else
+		{
+			// Older C libraries can't change the directory of a spawned child, so fork instead.
+			pid = fork();
+			if (pid == 0)
+			{
+				if (command.timeout > 0.0)
+					setpgid(0, 0);
+
+				if (outputFd >= 0)
+				{
+					dup2(outputFd, STDOUT_FILENO);
+					if (command.output == ProcessOutput::CaptureStdout)
+						dup2(open("/dev/null", O_WRONLY), STDERR_FILENO);
+					else
+						dup2(outputFd, STDERR_FILENO);
+				} else if (command.output == ProcessOutput::Discard)
+				{
+					int null = open("/dev/null", O_WRONLY);
+					dup2(null, STDOUT_FILENO);
+					dup2(null, STDERR_FILENO);
+				}
+
+				// execvp passes on the environment of the calling process.
+				environ = environment;
+				if (chdir(workingDirectory.c_str()) == 0)
+					execvp(argv[0], argv.data());
+
+				_exit(127);
+			}
+		}
+#endif
+
+		posix_spawnattr_destroy(&attributes);
+		posix_spawn_file_actions_destroy(&actions);
+		return pid;
+	}
+
+	static bool StartProcess(const ProcessCommand& command, size_t index, RunningProcess& process)
+	{
+		if (command.arguments.empty())
+			return false;
+
+		int fds[2] = {-1, -1};
+		bool isCaptured = command.output == ProcessOutput::Capture || command.output == ProcessOutput::CaptureStdout;
+		if (isCaptured && !OpenPipe(fds))
+			return false;
+
+		process.index = index;
+		process.start = std::chrono::steady_clock::now();
+		process.pid = SpawnProcess(command, fds[1]);
+
+		if (fds[1] >= 0)
+			close(fds[1]);
+
+		if (process.pid < 0)
+		{
+			if (fds[0] >= 0)
+				close(fds[0]);
+
+			return false;
+		}
+
+		process.outputFd = fds[0];
+		process.hasDeadline = command.timeout > 0.0;
+		if (process.hasDeadline)
+			process.deadline = process.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(command.timeout));
+
+		return true;
+	}
+
+	// Appends whatever the process has written so far. Returns false once there's nothing left to read, and closes
+	// the pipe when it was closed on the other end.
+	static bool ReadOutput(RunningProcess& process, std::string& output)
+	{
+		char buffer[4096];
+		ssize_t size = read(process.outputFd, buffer, sizeof(buffer));
+		if (size > 0)
+		{
+			output.append(buffer, (size_t) size);
+			return true;
+		}
+
+		if (size < 0 && errno == EINTR)
+			return true;
+
+		if (size < 0 && errno == EAGAIN)
+			return false;
+
+		close(process.outputFd);
+		process.outputFd = -1;
+		return false;
+	}
+
+	static void FinishProcess(const RunningProcess& process, int status, const rusage& usage, ProcessResult& result)
+	{
+		ProcessStats& stats = result.stats;
+		stats.wallTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+		                                                          process.start).count();
+		stats.userTime = (double) usage.ru_utime.tv_sec * 1e9 + (double) usage.ru_utime.tv_usec * 1e3;
+		stats.systemTime = (double) usage.ru_stime.tv_sec * 1e9 + (double) usage.ru_stime.tv_usec * 1e3;
+#ifdef __APPLE__
+		// macOS reports ru_maxrss in bytes, Linux in kilobytes.
+		stats.peakMemory = (uint64_t) usage.ru_maxrss;
+#else
+		stats.peakMemory = (uint64_t) usage.ru_maxrss * 1024;
+#endif
+		stats.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+		result.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+	}
+
+	std::vector<ProcessResult> Platform::RunCommands(const std::vector<ProcessCommand>& commands, uint32_t jobs)
+	{
+		std::vector<ProcessResult> results(commands.size());
+		std::vector<RunningProcess> running;
+
+		size_t jobCount = jobs > 0 ? jobs : std::max<size_t>(commands.size(), 1);
+		size_t next = 0;
+
+		while (next < commands.size() || !running.empty())
+		{
+			while (next < commands.size() && running.size() < jobCount)
+			{
+				RunningProcess process;
+				results[next].isStarted = StartProcess(commands[next], next, process);
+				if (results[next].isStarted)
+					running.push_back(process);
+
+				next++;
+			}
+
+			if (running.empty())
+				continue;
+
+			// A single process without captured output or a timeout is simply waited for, which wakes up exactly
+			// when it exits.
+			const RunningProcess& first = running.front();
+			bool isBlocking = running.size() == 1 && first.outputFd < 0 && !first.hasDeadline;
+
+			std::vector<pollfd> fds;
+			for (const auto& process : running)
+			{
+				if (process.outputFd >= 0)
+					fds.push_back({process.outputFd, POLLIN, 0});
+			}
+
+			bool isWaitingForExit = std::any_of(running.begin(), running.end(), [](const RunningProcess& process)
+			{
+				return process.outputFd < 0 || process.hasDeadline;
+			});
+
+			if (!isBlocking)
+			{
+				// Output is read as it arrives, so that a process never blocks on a full pipe.
+				int timeout = isWaitingForExit ? s_ProcessPollInterval : -1;
+				if (poll(fds.data(), (nfds_t) fds.size(), timeout) > 0)
+				{
+					for (auto& process : running)
+					{
+						auto fd = std::find_if(fds.begin(), fds.end(), [&process](const pollfd& entry)
+						{
+							return entry.fd == process.outputFd;
+						});
+
+						if (fd != fds.end() && fd->revents != 0)
+							ReadOutput(process, results[process.index].output);
+					}
+				}
+			}
+
+			auto now = std::chrono::steady_clock::now();
+			for (auto it = running.begin(); it != running.end();)
+			{
+				RunningProcess& process = *it;
+				ProcessResult& result = results[process.index];
+
+				if (process.hasDeadline && now >= process.deadline && !result.isTimedOut)
+				{
+					kill(-process.pid, SIGKILL);
+					result.isTimedOut = true;
+				}
+
+				// Once a captured process closed its output, it's about to exit, so waiting for it is short.
+				ProcessOutput output = commands[process.index].output;
+				bool isClosed = process.outputFd < 0 &&
+				                (output == ProcessOutput::Capture || output == ProcessOutput::CaptureStdout);
+
+				int status = 0;
+				rusage usage {};
+				pid_t pid = wait4(process.pid, &status, isBlocking || isClosed ? 0 : WNOHANG, &usage);
+				if (pid == 0 || (pid < 0 && errno == EINTR))
+				{
+					++it;
+					continue;
+				}
+
+				// Whatever is left in the pipe is read to the end, unless a process it started keeps it open.
+				if (process.outputFd >= 0)
+				{
+					fcntl(process.outputFd, F_SETFL, fcntl(process.outputFd, F_GETFL) | O_NONBLOCK);
+					while (ReadOutput(process, result.output))
+						;
+
+					if (process.outputFd >= 0)
+						close(process.outputFd);
+				}
+
+				if (pid == process.pid)
+					FinishProcess(process, status, usage, result);
+
+				it = running.erase(it);
+			}
+		}
+
+		return results;
+	}
+
+	ProcessResult Platform::RunCommand(const ProcessCommand& command)
+	{
+		return RunCommands({command}, 1)[0];
+	}
+
+	std::FILE* Platform::SeparateStandardOutput()
+	{
+		std::cout.flush();
+
+		// The copy is close-on-exec, so that the processes Magnet starts can't write into the JSON stream.
+		int fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+		if (fd < 0)
+			return nullptr;
+
+		if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		return fdopen(fd, "w");
+	}
+}
+
+#endif
@@ -3,9 +3,203 @@
 #include "Platform.h"
 
 #include <Windows.h>
+#include <io.h>
+#include <psapi.h>
 
 namespace MG
 {
+	// A process started by RunCommands that hasn't been waited for yet.
+	struct RunningProcess
+	{
+		size_t index = 0;
+		PROCESS_INFORMATION info {};
+
+		// Reads the captured output until the process and everything it started closed the pipe.
+		std::thread reader;
+
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point deadline;
+		bool hasDeadline = false;
+	};
+
+	// Quotes an argument so that CommandLineToArgvW and the C runtime read it back unchanged.
+	static std::string QuoteArgument(const std::string& argument)
+	{
+		if (!argument.empty() && argument.find_first_of(" \t\n\v\"") == std::string::npos)
+			return argument;
+
+		std::string quoted = "\"";
+		size_t backslashes = 0;
+		for (char c : argument)
+		{
+			if (c == '\\')
+			{
+				backslashes++;
+				continue;
+			}
+
+			// Backslashes are only special in front of a quote.
+			quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+			quoted += c;
+			backslashes = 0;
+		}
+
+		quoted.append(backslashes * 2, '\\');
+		return quoted + "\"";
+	}
+
+	// Returns Magnet's environment with the variables of the command replaced or added, as a block for
+	// CreateProcess, in which every NAME=value is followed by a null character and the block by another one.
+	static std::string GetEnvironmentBlock(const ProcessCommand& command)
+	{
+		std::string block;
+
+		char* strings = GetEnvironmentStringsA();
+		for (const char* variable = strings; variable && *variable; variable += std::strlen(variable) + 1)
+		{
+			// Names are case-insensitive on Windows. Those of the hidden per-drive directories start with '='.
+			std::string_view entry(variable);
+			std::string name(entry.substr(0, entry.find('=', 1)));
+			bool isReplaced = std::any_of(command.environment.begin(), command.environment.end(),
+			                              [&name](const auto& replacement)
+			                              {
+				                              return _stricmp(replacement.first.c_str(), name.c_str()) == 0;
+			                              });
+
+			if (!isReplaced)
+				block.append(entry).push_back('\0');
+		}
+
+		if (strings)
+			FreeEnvironmentStringsA(strings);
+
+		for (const auto& [name, value] : command.environment)
+			block.append(name + "=" + value).push_back('\0');
+
+		block.push_back('\0');
+		return block;
+	}
+
+	static bool StartProcess(const ProcessCommand& command, size_t index, RunningProcess& process,
+	                         std::string& output)
+	{
+		if (command.arguments.empty())
+			return false;
+
+		std::string commandLine;
+		for (const auto& argument : command.arguments)
+			commandLine += (commandLine.empty() ? "" : " ") + QuoteArgument(argument);
+
+		STARTUPINFOA startupInfo {};
+		startupInfo.cb = sizeof(startupInfo);
+
+		SECURITY_ATTRIBUTES attributes {sizeof(attributes), NULL, TRUE};
+		HANDLE readPipe = NULL;
+		HANDLE writeHandle = NULL;
+		HANDLE errorHandle = NULL;
+		if (command.output == ProcessOutput::Capture || command.output == ProcessOutput::CaptureStdout)
+		{
+			if (!CreatePipe(&readPipe, &writeHandle, &attributes, 0))
+				return false;
+
+			SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+			if (command.output == ProcessOutput::CaptureStdout)
+				errorHandle = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_WRITE, &attributes, OPEN_EXISTING, 0, NULL);
+		} else if (command.output == ProcessOutput::Discard)
+		{
+			writeHandle = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_WRITE, &attributes, OPEN_EXISTING, 0, NULL);
+		}
+
+		bool isRedirected = writeHandle != NULL && writeHandle != INVALID_HANDLE_VALUE;
+		bool hasErrorHandle = errorHandle != NULL && errorHandle != INVALID_HANDLE_VALUE;
+		if (isRedirected)
+		{
+			startupInfo.dwFlags = STARTF_USESTDHANDLES;
+			startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			startupInfo.hStdOutput = writeHandle;
+			startupInfo.hStdError = hasErrorHandle ? errorHandle : writeHandle;
+		}
+
+		std::string workingDirectory = command.workingDirectory.string();
+		std::string environment = command.environment.empty() ? "" : GetEnvironmentBlock(command);
+
+		process.index = index;
+		process.start = std::chrono::steady_clock::now();
+		BOOL isCreated = CreateProcessA(NULL, commandLine.data(), NULL, NULL, isRedirected, 0,
+		                                environment.empty() ? NULL : environment.data(),
+		                                workingDirectory.empty() ? NULL : workingDirectory.c_str(), &startupInfo,
+		                                &process.info);
+
+		if (isRedirected)
+			CloseHandle(writeHandle);
+
+		if (hasErrorHandle)
+			CloseHandle(errorHandle);
+
+		if (!isCreated)
+		{
+			if (readPipe)
+				CloseHandle(readPipe);
+
+			return false;
+		}
+
+		if (readPipe)
+		{
+			process.reader = std::thread([readPipe, &output]()
+			                             {
+				                             char buffer[4096];
+				                             DWORD size = 0;
+				                             while (ReadFile(readPipe, buffer, sizeof(buffer), &size, NULL) &&
+				                                    size > 0)
+					                             output.append(buffer, size);
+
+				                             CloseHandle(readPipe);
+			                             });
+		}
+
+		process.hasDeadline = command.timeout > 0.0;
+		if (process.hasDeadline)
+			process.deadline = process.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(command.timeout));
+
+		return true;
+	}
+
+	static void FinishProcess(RunningProcess& process, ProcessResult& result)
+	{
+		ProcessStats& stats = result.stats;
+		stats.wallTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+		                                                          process.start).count();
+
+		DWORD exitCode = 0;
+		GetExitCodeProcess(process.info.hProcess, &exitCode);
+		stats.exitCode = result.isTimedOut ? -1 : (int) exitCode;
+
+		// FILETIME counts in units of 100 nanoseconds.
+		auto toNanoseconds = [](const FILETIME& time)
+		{
+			return (double) (((uint64_t) time.dwHighDateTime << 32) | time.dwLowDateTime) * 100.0;
+		};
+
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (GetProcessTimes(process.info.hProcess, &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			stats.userTime = toNanoseconds(userTime);
+			stats.systemTime = toNanoseconds(kernelTime);
+		}
+
+		PROCESS_MEMORY_COUNTERS counters {};
+		if (GetProcessMemoryInfo(process.info.hProcess, &counters, sizeof(counters)))
+			stats.peakMemory = counters.PeakWorkingSetSize;
+
+		CloseHandle(process.info.hThread);
+		CloseHandle(process.info.hProcess);
+
+		if (process.reader.joinable())
+			process.reader.join();
+	}
+
 	void Platform::Initialize()
 	{
 		SetConsoleOutputCP(CP_UTF8);
@@ -21,14 +215,209 @@ namespace MG
 		return p;
 	}
 
-	std::string Platform::GetGenerateCommand([[maybe_unused]] const std::string& configuration)
+	std::vector<std::string> Platform::GetGenerateArguments([[maybe_unused]] const std::string& configuration)
 	{
-		return "-G \"Visual Studio 17 2022\" -A x64";
+		return {"-G", "Visual Studio 17 2022", "-A", "x64"};
 	}
 
-	std::string Platform::GetGoCommand(const std::string& appPath)
+	std::filesystem::path Platform::GetAllocationShimPath()
 	{
-		return "start " + appPath;
+		return {};
+	}
+
+	void Platform::SetEnvironment(const std::string& name, const std::string& value)
+	{
+		_putenv_s(name.c_str(), value.c_str());
+	}
+
+	uint64_t Platform::GetAvailableMemory()
+	{
+		MEMORYSTATUSEX status;
+		status.dwLength = sizeof(status);
+		if (!GlobalMemoryStatusEx(&status))
+			return 0;
+
+		return status.ullAvailPhys;
+	}
+
+	std::FILE* Platform::SeparateStandardOutput()
+	{
+		std::cout.flush();
+
+		int fd = _dup(_fileno(stdout));
+		if (fd < 0)
+			return nullptr;
+
+		if (_dup2(_fileno(stderr), _fileno(stdout)) != 0)
+		{
+			_close(fd);
+			return nullptr;
+		}
+
+		// Processes started without redirected handles inherit the standard handles instead of the C runtime's.
+		SetStdHandle(STD_OUTPUT_HANDLE, GetStdHandle(STD_ERROR_HANDLE));
+		return _fdopen(fd, "w");
+	}
+
+	std::vector<ProcessResult> Platform::RunCommands(const std::vector<ProcessCommand>& commands, uint32_t jobs)
+	{
+		std::vector<ProcessResult> results(commands.size());
+
+		// WaitForMultipleObjects can't wait for more handles at once.
+		size_t jobCount = std::min<size_t>(jobs > 0 ? jobs : commands.size(), MAXIMUM_WAIT_OBJECTS);
+		jobCount = std::max<size_t>(jobCount, 1);
+
+		std::vector<RunningProcess> running;
+		size_t next = 0;
+
+		while (next < commands.size() || !running.empty())
+		{
+			while (next < commands.size() && running.size() < jobCount)
+			{
+				RunningProcess& process = running.emplace_back();
+				results[next].isStarted = StartProcess(commands[next], next, process, results[next].output);
+				if (!results[next].isStarted)
+					running.pop_back();
+
+				next++;
+			}
+
+			if (running.empty())
+				continue;
+
+			auto now = std::chrono::steady_clock::now();
+			DWORD timeout = INFINITE;
+			std::vector<HANDLE> handles;
+			for (auto& process : running)
+			{
+				handles.push_back(process.info.hProcess);
+				if (!process.hasDeadline || results[process.index].isTimedOut)
+					continue;
+
+				if (now >= process.deadline)
+				{
+					// Child processes aren't killed along with it, since that requires a job object.
+					TerminateProcess(process.info.hProcess, 1);
+					results[process.index].isTimedOut = true;
+					continue;
+				}
+
+				auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(process.deadline - now);
+				timeout = std::min(timeout, (DWORD) remaining.count() + 1);
+			}
+
+			DWORD signaled = WaitForMultipleObjects((DWORD) handles.size(), handles.data(), FALSE, timeout);
+			if (signaled == WAIT_TIMEOUT || signaled == WAIT_FAILED)
+				continue;
+
+			for (auto it = running.begin(); it != running.end();)
+			{
+				if (WaitForSingleObject(it->info.hProcess, 0) != WAIT_OBJECT_0)
+				{
+					++it;
+					continue;
+				}
+
+				FinishProcess(*it, results[it->index]);
+				it = running.erase(it);
+			}
+		}
+
+		return results;
+	}
+
+	ProcessResult Platform::RunCommand(const ProcessCommand& command)
+	{
+		return RunCommands({command}, 1)[0];
+	}
+
+	bool Platform::RunProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+	                          bool discardOutput, ProcessStats& stats,
+	                          [[maybe_unused]] const std::vector<CounterGroup>& counterGroups)
+	{
+		std::string commandLine = QuoteArgument(executable.string());
+		for (const auto& argument : arguments)
+			commandLine += " " + QuoteArgument(argument);
+
+		STARTUPINFOA startupInfo {};
+		startupInfo.cb = sizeof(startupInfo);
+
+		HANDLE null = INVALID_HANDLE_VALUE;
+		if (discardOutput)
+		{
+			SECURITY_ATTRIBUTES attributes {sizeof(attributes), NULL, TRUE};
+			null = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_WRITE, &attributes, OPEN_EXISTING, 0, NULL);
+
+			startupInfo.dwFlags = STARTF_USESTDHANDLES;
+			startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			startupInfo.hStdOutput = null;
+			startupInfo.hStdError = null;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		PROCESS_INFORMATION processInfo {};
+		BOOL isCreated = CreateProcessA(NULL, commandLine.data(), NULL, NULL, discardOutput, 0, NULL, NULL,
+		                                &startupInfo, &processInfo);
+
+		if (null != INVALID_HANDLE_VALUE)
+			CloseHandle(null);
+
+		if (!isCreated)
+			return false;
+
+		WaitForSingleObject(processInfo.hProcess, INFINITE);
+		stats.wallTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		DWORD exitCode = 0;
+		GetExitCodeProcess(processInfo.hProcess, &exitCode);
+		stats.exitCode = (int) exitCode;
+
+		// FILETIME counts in units of 100 nanoseconds.
+		auto toNanoseconds = [](const FILETIME& time)
+		{
+			return (double) (((uint64_t) time.dwHighDateTime << 32) | time.dwLowDateTime) * 100.0;
+		};
+
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (GetProcessTimes(processInfo.hProcess, &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			stats.userTime = toNanoseconds(userTime);
+			stats.systemTime = toNanoseconds(kernelTime);
+		}
+
+		PROCESS_MEMORY_COUNTERS counters {};
+		if (GetProcessMemoryInfo(processInfo.hProcess, &counters, sizeof(counters)))
+			stats.peakMemory = counters.PeakWorkingSetSize;
+
+		CloseHandle(processInfo.hThread);
+		CloseHandle(processInfo.hProcess);
+		return true;
+	}
+
+	bool Platform::SampleProcess([[maybe_unused]] const std::filesystem::path& executable,
+	                             [[maybe_unused]] const std::vector<std::string>& arguments,
+	                             [[maybe_unused]] uint32_t frequency, [[maybe_unused]] ProcessSamples& samples)
+	{
+		return false;
+	}
+
+	std::vector<std::string> Platform::GetCounterEvents()
+	{
+		// Windows only exposes performance counters to privileged tools.
+		return {};
+	}
+
+	std::vector<std::string> Platform::GetBenchmarkWarnings()
+	{
+		std::vector<std::string> warnings;
+
+		// Most power plans lower clock speeds on battery.
+		SYSTEM_POWER_STATUS status {};
+		if (GetSystemPowerStatus(&status) && status.ACLineStatus == 0)
+			warnings.push_back("The system is running on battery, which usually lowers clock speeds.");
+
+		return warnings;
 	}
 }
 
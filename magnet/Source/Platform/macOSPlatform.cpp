@@ -2,7 +2,12 @@
 
 #include "Platform.h"
 
+#include <fcntl.h>
 #include <mach-o/dyld.h>
+#include <mach/mach.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace MG
 {
@@ -31,14 +36,113 @@ namespace MG
 		return p;
 	}
 
-	std::string Platform::GetGenerateCommand([[maybe_unused]] const std::string& configuration)
+	std::vector<std::string> Platform::GetGenerateArguments([[maybe_unused]] const std::string& configuration)
 	{
-		return "-G Xcode";
+		return {"-G", "Xcode"};
 	}
 
-	std::string Platform::GetGoCommand(const std::string& appPath)
+	std::filesystem::path Platform::GetAllocationShimPath()
 	{
-		return "./" + appPath;
+		return {};
+	}
+
+	void Platform::SetEnvironment(const std::string& name, const std::string& value)
+	{
+		setenv(name.c_str(), value.c_str(), 1);
+	}
+
+	uint64_t Platform::GetAvailableMemory()
+	{
+		vm_statistics64_data_t stats;
+		mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+		if (host_statistics64(mach_host_self(), HOST_VM_INFO64, (host_info64_t) &stats, &count) != KERN_SUCCESS)
+			return 0;
+
+		vm_size_t pageSize = 0;
+		host_page_size(mach_host_self(), &pageSize);
+
+		// Inactive and purgeable pages can be reclaimed without swapping.
+		uint64_t pages = (uint64_t) stats.free_count + stats.inactive_count + stats.purgeable_count;
+		return pages * pageSize;
+	}
+
+	bool Platform::RunProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments,
+	                          bool discardOutput, ProcessStats& stats,
+	                          [[maybe_unused]] const std::vector<CounterGroup>& counterGroups)
+	{
+		std::string path = executable.string();
+
+		std::vector<char*> argv;
+		argv.push_back(path.data());
+		for (const auto& argument : arguments)
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		argv.push_back(nullptr);
+
+		auto start = std::chrono::steady_clock::now();
+
+		pid_t pid = fork();
+		if (pid < 0)
+			return false;
+
+		if (pid == 0)
+		{
+			if (discardOutput)
+			{
+				int null = open("/dev/null", O_WRONLY);
+				dup2(null, STDOUT_FILENO);
+				dup2(null, STDERR_FILENO);
+			}
+
+			execv(path.c_str(), argv.data());
+			_exit(127);
+		}
+
+		// wait4 reports the usage of exactly this child, unlike getrusage, which accumulates all of them.
+		int status = 0;
+		rusage usage {};
+		if (wait4(pid, &status, 0, &usage) != pid)
+			return false;
+
+		stats.wallTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		stats.userTime = (double) usage.ru_utime.tv_sec * 1e9 + (double) usage.ru_utime.tv_usec * 1e3;
+		stats.systemTime = (double) usage.ru_stime.tv_sec * 1e9 + (double) usage.ru_stime.tv_usec * 1e3;
+		stats.peakMemory = (uint64_t) usage.ru_maxrss;
+		stats.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+		// exec failing is indistinguishable from a program that exits with 127, so check for the usual reason.
+		return stats.exitCode != 127 || access(path.c_str(), X_OK) == 0;
+	}
+
+	bool Platform::SampleProcess([[maybe_unused]] const std::filesystem::path& executable,
+	                             [[maybe_unused]] const std::vector<std::string>& arguments,
+	                             [[maybe_unused]] uint32_t frequency, [[maybe_unused]] ProcessSamples& samples)
+	{
+		return false;
+	}
+
+	std::vector<std::string> Platform::GetCounterEvents()
+	{
+		// macOS only exposes performance counters to privileged tools.
+		return {};
+	}
+
+	std::vector<std::string> Platform::GetBenchmarkWarnings()
+	{
+		// macOS manages CPU frequency itself and doesn't expose a way to pin it.
+		std::vector<std::string> warnings;
+
+		// Anything else running competes for cores, caches and memory bandwidth.
+		double load = 0.0;
+		uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+		if (getloadavg(&load, 1) == 1 && load > std::max(1.0, (double) cores / 2.0))
+		{
+			std::ostringstream warning;
+			warning << std::fixed << std::setprecision(1) << "The system is busy (load average " << load << " on "
+			        << cores << " cores).";
+			warnings.push_back(warning.str());
+		}
+
+		return warnings;
 	}
 }
 
@@ -2,6 +2,106 @@
 
 namespace MG
 {
+	static std::string ToLowerCase(const std::string& string)
+	{
+		std::string lowerCaseString = string;
+		std::transform(lowerCaseString.begin(), lowerCaseString.end(), lowerCaseString.begin(),
+		               [](unsigned char c) -> unsigned char
+		               {
+			               return static_cast<unsigned char>(std::tolower(c));
+		               });
+
+		return lowerCaseString;
+	}
+
+	static ProjectType ProjectTypeFromString(const std::string& type)
+	{
+		std::string lowerCaseType = ToLowerCase(type);
+
+		if (lowerCaseType == "executable")
+			return ProjectType::Executable;
+		else if (lowerCaseType == "staticlibrary")
+			return ProjectType::StaticLibrary;
+		else if (lowerCaseType == "dynamiclibrary")
+			return ProjectType::DynamicLibrary;
+
+		return ProjectType::Unknown;
+	}
+
+	static std::string ProjectTypeToCmakeString(ProjectType type)
+	{
+		switch (type)
+		{
+			case ProjectType::StaticLibrary:
+				return "STATIC";
+			case ProjectType::DynamicLibrary:
+				return "SHARED";
+			default:
+				return "";
+		}
+	}
+
+	void Target::SetType(const std::string& string)
+	{
+		std::string lowerCaseType = ToLowerCase(string);
+
+		if (lowerCaseType == "test")
+		{
+			type = ProjectType::Executable;
+			role = TargetRole::Test;
+			return;
+		}
+
+		if (lowerCaseType == "benchmark")
+		{
+			type = ProjectType::Executable;
+			role = TargetRole::Benchmark;
+			return;
+		}
+
+		ProjectType projectType = ProjectTypeFromString(string);
+		if (projectType != ProjectType::Unknown)
+			type = projectType;
+	}
+
+	std::string Target::GetCmakeTypeString() const
+	{
+		return ProjectTypeToCmakeString(type);
+	}
+
+	bool BuildBudgets::IsEmpty() const
+	{
+		return compileSeconds <= 0.0 && preprocessedMegabytes <= 0.0 && totalCompileSeconds <= 0.0 &&
+		       binaryMegabytes <= 0.0;
+	}
+
+	std::vector<std::string> SharedLibraryOptimizations::GetCompileFlags() const
+	{
+		if (!isEnabled || !hideSymbols)
+			return {};
+
+		return {"-fvisibility=hidden", "-fvisibility-inlines-hidden"};
+	}
+
+	std::vector<std::string> SharedLibraryOptimizations::GetLinkFlags() const
+	{
+		if (!isEnabled)
+			return {};
+
+		std::vector<std::string> flags;
+		if (linkAsNeeded)
+			flags.emplace_back("-Wl,--as-needed");
+
+		if (bindFunctionsLocally)
+			flags.emplace_back("-Wl,-Bsymbolic-functions");
+
+		if (useGnuHash)
+			flags.emplace_back("-Wl,--hash-style=gnu");
+
+		flags.emplace_back(bindNow ? "-Wl,-z,relro,-z,now" : "-Wl,-z,relro");
+		return flags;
+	}
+
 	std::string Configuration::ToString() const
 	{
 		switch (m_Mode)
@@ -10,6 +110,8 @@ namespace MG
 				return "Debug";
 			case ConfigurationMode::Release:
 				return "Release";
+			case ConfigurationMode::Profile:
+				return "Profile";
 			default:
 				return "";
 		}
@@ -17,17 +119,14 @@ namespace MG
 
 	void Configuration::SetMode(const std::string& mode)
 	{
-		std::string lowerCaseMode = mode;
-		std::transform(lowerCaseMode.begin(), lowerCaseMode.end(), lowerCaseMode.begin(),
-		               [](unsigned char c) -> unsigned char
-		               {
-			               return static_cast<unsigned char>(std::tolower(c));
-		               });
+		std::string lowerCaseMode = ToLowerCase(mode);
 
 		if (lowerCaseMode == "debug")
 			m_Mode = ConfigurationMode::Debug;
 		else if (lowerCaseMode == "release")
 			m_Mode = ConfigurationMode::Release;
+		else if (lowerCaseMode == "profile")
+			m_Mode = ConfigurationMode::Profile;
 	}
 
 	bool Configuration::IsValid() const
@@ -90,15 +189,7 @@ namespace MG
 
 	std::string Project::GetCmakeTypeString() const
 	{
-		switch (m_Type)
-		{
-			case ProjectType::StaticLibrary:
-				return "STATIC";
-			case ProjectType::DynamicLibrary:
-				return "SHARED";
-			default:
-				return "";
-		}
+		return ProjectTypeToCmakeString(m_Type);
 	}
 
 	void Project::SetType(const ProjectType& type)
@@ -111,19 +202,9 @@ namespace MG
 
 	void Project::SetType(const std::string& type)
 	{
-		std::string lowerCaseType = type;
-		std::transform(lowerCaseType.begin(), lowerCaseType.end(), lowerCaseType.begin(),
-		               [](unsigned char c) -> unsigned char
-		               {
-			               return static_cast<unsigned char>(std::tolower(c));
-		               });
-
-		if (lowerCaseType == "executable")
-			m_Type = ProjectType::Executable;
-		else if (lowerCaseType == "staticlibrary")
-			m_Type = ProjectType::StaticLibrary;
-		else if (lowerCaseType == "dynamiclibrary")
-			m_Type = ProjectType::DynamicLibrary;
+		ProjectType projectType = ProjectTypeFromString(type);
+		if (projectType != ProjectType::Unknown)
+			m_Type = projectType;
 	}
 
 	int Project::GetCppVersion() const
@@ -190,6 +271,59 @@ namespace MG
 		m_Configuration = configuration;
 	}
 
+	const std::string& Project::GetAllocator() const
+	{
+		return m_Allocator;
+	}
+
+	void Project::SetAllocator(const std::string& allocator)
+	{
+		m_Allocator = allocator;
+	}
+
+	std::vector<Target> Project::GetTargets() const
+	{
+		if (IsWorkspace())
+			return m_Targets;
+
+		Target target;
+		target.name = m_Name;
+		target.type = m_Type;
+		target.sources = {"**"};
+
+		return {target};
+	}
+
+	void Project::SetTargets(const std::vector<Target>& targets)
+	{
+		m_Targets = targets;
+	}
+
+	bool Project::IsWorkspace() const
+	{
+		return !m_Targets.empty();
+	}
+
+	std::string Project::GetLaunchTargetName() const
+	{
+		auto targets = GetTargets();
+
+		// Prefer the target named after the project, then the first regular executable.
+		for (const auto& target : targets)
+		{
+			if (target.name == m_Name && target.type == ProjectType::Executable)
+				return target.name;
+		}
+
+		for (const auto& target : targets)
+		{
+			if (target.type == ProjectType::Executable && target.role == TargetRole::Default)
+				return target.name;
+		}
+
+		return "";
+	}
+
 	bool Project::IsValid() const
 	{
 		return !m_Name.empty() && GetType() != ProjectType::Unknown && GetCppVersion() != -1 &&
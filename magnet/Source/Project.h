@@ -20,12 +20,96 @@ namespace MG
 		Cpp20
 	};
 
+	// Represents what a target is used for, in addition to its type.
+	enum class TargetRole
+	{
+		Default,
+		Test,
+		Benchmark
+	};
+
+	// Represents a single CMake target of a project.
+	struct Target
+	{
+		std::string name;
+		ProjectType type = ProjectType::Executable;
+		TargetRole role = TargetRole::Default;
+
+		// Glob patterns relative to the Source folder, e.g. "main.cpp" or "net/**".
+		std::vector<std::string> sources;
+
+		// Other targets of the project, dependencies or system libraries this target links against.
+		std::vector<std::string> links;
+
+		// Sets the type from a string. Besides the project types, "Test" and "Benchmark" are accepted,
+		// which are executables with the corresponding role.
+		void SetType(const std::string& string);
+
+		// Returns the type as a string that can be used in CMake, or an empty string for executables.
+		[[nodiscard]] std::string GetCmakeTypeString() const;
+	};
+
+	// Limits on the cost of a build, declared under `budgets` in config.yaml and checked after every build.
+	// A limit of 0 is not checked.
+	struct BuildBudgets
+	{
+		// CPU time of a single compile, in seconds.
+		double compileSeconds = 0.0;
+
+		// Size of a single translation unit after preprocessing, in megabytes.
+		double preprocessedMegabytes = 0.0;
+
+		// CPU time of all compiles and links of a clean build, in seconds.
+		double totalCompileSeconds = 0.0;
+
+		// Size of every executable and library, in megabytes.
+		double binaryMegabytes = 0.0;
+
+		// Whether a build that exceeds a budget fails, rather than only warning.
+		bool isEnforced = true;
+
+		// Returns whether no limit is set.
+		[[nodiscard]] bool IsEmpty() const;
+	};
+
+	// Visibility and linker settings that make shared libraries load faster, declared under
+	// `sharedLibOptimizations` in config.yaml. `sharedLibOptimizations: true` turns on all of them but bindNow.
+	struct SharedLibraryOptimizations
+	{
+		bool isEnabled = false;
+
+		// Only exports what is marked with the macro of the generated export header.
+		bool hideSymbols = true;
+
+		// Leaves out libraries that no symbol is used from, so that they aren't loaded.
+		bool linkAsNeeded = true;
+
+		// Binds calls within the library to its own functions, so that they need neither a lookup nor the PLT.
+		bool bindFunctionsLocally = true;
+
+		// Only writes the GNU hash table, whose lookups skip most symbols that don't match.
+		bool useGnuHash = true;
+
+		// Resolves every symbol when the library is loaded instead of on first call. This makes the GOT read-only
+		// (full RELRO) at the cost of a slower load.
+		bool bindNow = false;
+
+		// Returns the compile flags on GCC and Clang.
+		[[nodiscard]] std::vector<std::string> GetCompileFlags() const;
+
+		// Returns the link flags for GNU ld, gold and lld.
+		[[nodiscard]] std::vector<std::string> GetLinkFlags() const;
+	};
+
 	// Represents the configuration mode.
 	enum class ConfigurationMode
 	{
 		Unknown,
 		Debug,
-		Release
+		Release,
+
+		// Optimized, with debug info and frame pointers. Used by `magnet bench`.
+		Profile
 	};
 
 	// Represents the configuration mode.
@@ -74,6 +158,22 @@ namespace MG
 		[[nodiscard]] const Configuration& GetConfiguration() const;
 		void SetConfiguration(const Configuration& configuration);
 
+		// Returns the allocator that replaces those from config.yaml in every configuration, e.g. for
+		// `magnet bench --allocators`, or an empty string if config.yaml decides.
+		[[nodiscard]] const std::string& GetAllocator() const;
+		void SetAllocator(const std::string& allocator);
+
+		// Returns the targets declared in config.yaml. If there are none, returns a single target named
+		// after the project, with the project's type and every source file.
+		[[nodiscard]] std::vector<Target> GetTargets() const;
+		void SetTargets(const std::vector<Target>& targets);
+
+		// Returns whether config.yaml declares its own targets, turning the project into a workspace.
+		[[nodiscard]] bool IsWorkspace() const;
+
+		// Returns the name of the executable `magnet go` launches, or an empty string if there is none.
+		[[nodiscard]] std::string GetLaunchTargetName() const;
+
 		// Returns whether the project is valid, meaning it has a name, type and C++ version.
 		[[nodiscard]] bool IsValid() const;
 
@@ -83,5 +183,7 @@ namespace MG
 		CppVersion m_CppVersion;
 		std::string m_CmakeVersion;
 		Configuration m_Configuration;
+		std::string m_Allocator;
+		std::vector<Target> m_Targets;
 	};
 }
\ No newline at end of file
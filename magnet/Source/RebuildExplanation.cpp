@@ -0,0 +1,228 @@
+#include "RebuildExplanation.h"
+
+#include "Core.h"
+#include "Event.h"
+
+namespace MG
+{
+	static constexpr std::string_view s_NinjaPrefix = "ninja explain: ";
+
+	// Parts of the explanations of `ninja -d explain`, which the targets and inputs are cut out of.
+	static constexpr std::string_view s_OutputPrefix = "output ";
+	static constexpr std::string_view s_RecordedTimePrefix = "recorded mtime of ";
+	static constexpr std::string_view s_RestatPrefix = "restat of output ";
+	static constexpr std::string_view s_OlderThanInput = " older than most recent input ";
+	static constexpr std::string_view s_ChangedCommandPrefix = "command line changed for ";
+	static constexpr std::string_view s_MissingCommandPrefix = "command line not found in log for ";
+	static constexpr std::string_view s_MissingSuffix = " doesn't exist";
+	static constexpr std::string_view s_DirtySuffix = " is dirty";
+
+	// Causes beyond this are only counted, since a full rebuild would otherwise list every file.
+	static constexpr size_t s_MaxPrintedCauses = 20;
+
+	static bool StartsWith(std::string_view string, std::string_view prefix)
+	{
+		return string.substr(0, prefix.size()) == prefix;
+	}
+
+	static bool EndsWith(std::string_view string, std::string_view suffix)
+	{
+		return string.size() >= suffix.size() && string.substr(string.size() - suffix.size()) == suffix;
+	}
+
+	static const char* GetReasonName(RebuildReason reason, const std::string& subject)
+	{
+		switch (reason)
+		{
+			case RebuildReason::ChangedInput:
+			{
+				std::string extension = std::filesystem::path(subject).extension().string();
+				if (extension == ".h" || extension == ".hpp" || extension == ".hxx" || extension == ".inl")
+					return "Changed header";
+
+				if (extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".c")
+					return "Changed source";
+
+				return "Changed file";
+			}
+			case RebuildReason::ChangedFlags:
+				return "Changed flags";
+			default:
+				return "Not built yet";
+		}
+	}
+
+	RebuildExplanation::RebuildExplanation(std::filesystem::path buildPath)
+			: m_BuildPath(std::move(buildPath))
+	{
+	}
+
+	void RebuildExplanation::Add(RebuildReason reason, const std::string& subject)
+	{
+		m_Counts[{reason, subject}]++;
+	}
+
+	void RebuildExplanation::AddNinjaExplanations(const std::string& output)
+	{
+		// Ninja checks the inputs of an edge before its outputs, so an output is always explained before the
+		// edges that depend on it report it as dirty.
+		std::unordered_map<std::string, std::pair<RebuildReason, std::string>> causes;
+
+		std::istringstream stream(output);
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			if (!StartsWith(line, s_NinjaPrefix))
+				continue;
+
+			std::string explanation = line.substr(s_NinjaPrefix.size());
+
+			std::string target;
+			std::pair<RebuildReason, std::string> cause;
+
+			// E.g. "output obj/main.cpp.o older than most recent input ../Source/Core.h (123 vs 456)".
+			size_t olderThan = explanation.find(s_OlderThanInput);
+			if (olderThan != std::string::npos)
+			{
+				size_t start = StartsWith(explanation, s_OutputPrefix) ? s_OutputPrefix.size() :
+				               StartsWith(explanation, s_RecordedTimePrefix) ? s_RecordedTimePrefix.size() :
+				               StartsWith(explanation, s_RestatPrefix) ? s_RestatPrefix.size() : 0;
+				std::string input = explanation.substr(olderThan + s_OlderThanInput.size());
+				input = input.substr(0, input.rfind(" ("));
+
+				target = explanation.substr(start, olderThan - start);
+				cause = {RebuildReason::ChangedInput, input};
+			} else if (StartsWith(explanation, s_ChangedCommandPrefix))
+			{
+				target = explanation.substr(s_ChangedCommandPrefix.size());
+				cause = {RebuildReason::ChangedFlags, GetTargetName(target)};
+			} else if (StartsWith(explanation, s_OutputPrefix) && EndsWith(explanation, s_MissingSuffix) &&
+			           explanation.find(" of phony edge") == std::string::npos)
+			{
+				target = explanation.substr(s_OutputPrefix.size(),
+				                            explanation.size() - s_OutputPrefix.size() - s_MissingSuffix.size());
+				cause = {RebuildReason::MissingOutput, ""};
+			} else if (StartsWith(explanation, s_MissingCommandPrefix))
+			{
+				target = explanation.substr(s_MissingCommandPrefix.size());
+				cause = {RebuildReason::MissingOutput, ""};
+			} else if (EndsWith(explanation, s_DirtySuffix))
+			{
+				std::string input = explanation.substr(0, explanation.size() - s_DirtySuffix.size());
+				std::string extension = std::filesystem::path(input).extension().string();
+
+				auto it = causes.find(input);
+				if (it != causes.end() && extension != ".o" && extension != ".obj")
+					Add(it->second.first, it->second.second);
+
+				continue;
+			} else
+			{
+				continue;
+			}
+
+			causes[target] = cause;
+			Add(cause.first, cause.second);
+		}
+	}
+
+	void RebuildExplanation::AddRewrittenFile(const std::string& path)
+	{
+		m_RewrittenFiles.push_back(path);
+	}
+
+	void RebuildExplanation::Print() const
+	{
+		PrintRewrittenFiles();
+
+		if (m_Counts.empty())
+		{
+			MG_LOG("Nothing has to be compiled again.");
+			return;
+		}
+
+		std::vector<std::pair<std::pair<RebuildReason, std::string>, uint32_t>> causes(m_Counts.begin(),
+		                                                                              m_Counts.end());
+		std::stable_sort(causes.begin(), causes.end(), [](const auto& a, const auto& b)
+		{
+			return a.second > b.second;
+		});
+
+		MG_LOG("Steps that run again, by cause:");
+
+		std::ostringstream header;
+		header << std::left << std::setw(18) << "Cause" << std::right << std::setw(8) << "Steps" << "  "
+		       << "Subject";
+		MG_LOGNH(header.str());
+
+		uint32_t otherSteps = 0;
+		for (size_t i = 0; i < causes.size(); i++)
+		{
+			const auto& [cause, count] = causes[i];
+			const auto& [reason, subject] = cause;
+
+			std::string path = reason == RebuildReason::ChangedInput ? ToProjectPath(subject) : subject;
+			const char* reasonString = GetReasonName(reason, subject);
+
+			Event("rebuild_cause").AddString("reason", reasonString).AddString("subject", path)
+			                      .AddNumber("steps", count).Emit();
+
+			if (i >= s_MaxPrintedCauses)
+			{
+				otherSteps += count;
+				continue;
+			}
+
+			std::ostringstream line;
+			line << std::left << std::setw(18) << reasonString << std::right << std::setw(8) << count << "  "
+			     << path;
+			MG_LOGNH(line.str());
+		}
+
+		if (otherSteps > 0)
+		{
+			MG_LOGNH("...and " + std::to_string(causes.size() - s_MaxPrintedCauses) + " more causes of " +
+			         std::to_string(otherSteps) + " steps.");
+		}
+	}
+
+	void RebuildExplanation::PrintRewrittenFiles() const
+	{
+		if (m_RewrittenFiles.empty())
+			return;
+
+		// Ninja stops at the configure step in a dry run, so the compiles are only known once CMake ran.
+		MG_LOG("CMake configures the project again, since these files changed after it last did. The files that "
+		       "are compiled again because of it are only known afterwards:");
+		for (const auto& path : m_RewrittenFiles)
+		{
+			MG_LOGNH("  " + path);
+			Event("rebuild_cause").AddString("reason", "rewritten").AddString("subject", path).Emit();
+		}
+	}
+
+	std::string RebuildExplanation::GetTargetName(const std::string& object)
+	{
+		size_t start = object.rfind("CMakeFiles/");
+		if (start == std::string::npos)
+			return "";
+
+		start += 11;
+		size_t end = object.find(".dir/", start);
+		return end == std::string::npos ? "" : object.substr(start, end - start);
+	}
+
+	std::string RebuildExplanation::ToProjectPath(const std::string& path) const
+	{
+		std::filesystem::path absolutePath = path;
+		if (absolutePath.is_relative())
+			absolutePath = m_BuildPath / path;
+
+		std::error_code error;
+		std::filesystem::path relativePath = std::filesystem::relative(absolutePath, error);
+		return error || relativePath.empty() ? path : relativePath.generic_string();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace MG
+{
+	// Why a build step runs again.
+	enum class RebuildReason
+	{
+		// A source or header it depends on changed.
+		ChangedInput,
+
+		// Its command line changed, e.g. because of a new define or configuration.
+		ChangedFlags,
+
+		// There is no output or no record of the previous build.
+		MissingOutput
+	};
+
+	// Collects why the steps of a build run again, from ninja's explain mode or from native builds, and summarizes
+	// the causes for `magnet build --explain`.
+	class RebuildExplanation
+	{
+	public:
+		// Paths of the causes are relative to the build folder, like ninja reports them.
+		explicit RebuildExplanation(std::filesystem::path buildPath);
+
+		// Records that a step runs again. The subject is the input that changed, the target whose flags changed or
+		// empty if there is none.
+		void Add(RebuildReason reason, const std::string& subject);
+
+		// Adds the lines ninja prints with `-d explain`. Compiles that only run because an output they depend on
+		// is rebuilt, such as the precompiled header, count towards the cause of that output. Links are left out,
+		// since they run whenever any object is compiled.
+		void AddNinjaExplanations(const std::string& output);
+
+		// Records a generated file that changed since the build folder was last configured.
+		void AddRewrittenFile(const std::string& path);
+
+		// Prints the causes grouped by reason and subject, the one that affects the most steps first, and emits
+		// them as events for `--output json`.
+		void Print() const;
+
+		// Prints only the rewritten files, for builds that can't explain their steps.
+		void PrintRewrittenFiles() const;
+
+	private:
+		// Returns the name of the CMake target an object belongs to, e.g. "app" for
+		// app/Source/CMakeFiles/app.dir/main.cpp.o, or an empty string.
+		static std::string GetTargetName(const std::string& object);
+
+		// Returns a path relative to the build folder relative to the project root instead.
+		[[nodiscard]] std::string ToProjectPath(const std::string& path) const;
+
+		std::filesystem::path m_BuildPath;
+
+		std::map<std::pair<RebuildReason, std::string>, uint32_t> m_Counts;
+		std::vector<std::string> m_RewrittenFiles;
+	};
+}
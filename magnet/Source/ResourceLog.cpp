@@ -0,0 +1,100 @@
+#include "ResourceLog.h"
+
+namespace MG
+{
+	// Objects and precompiled headers, which are compiled.
+	static const std::set<std::string> s_CompileExtensions = {".o", ".obj", ".gch", ".pch"};
+
+	// Executables and libraries, which are linked. Executables have no extension outside of Windows.
+	static const std::set<std::string> s_LinkExtensions = {"", ".exe", ".so", ".dylib", ".dll", ".a", ".lib"};
+
+	uint64_t ResourceRecord::GetCpuTime() const
+	{
+		return userTime + systemTime;
+	}
+
+	std::filesystem::path ResourceLog::GetPath(const std::filesystem::path& buildPath)
+	{
+		return buildPath / "magnet_resources.log";
+	}
+
+	std::vector<ResourceRecord> ResourceLog::Load(const std::filesystem::path& path, uint64_t offset)
+	{
+		std::ifstream file(path);
+		if (!file || !file.seekg((std::streamoff) offset))
+			return {};
+
+		// Later lines win, since an output that was rebuilt is appended again.
+		std::unordered_map<std::string, ResourceRecord> latest;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string kind;
+			ResourceRecord record;
+
+			if (!(stream >> kind >> record.wallTime >> record.userTime >> record.systemTime >>
+			             record.peakMemory >> record.exitCode))
+				continue;
+
+			stream >> std::ws;
+			std::getline(stream, record.output);
+			if (record.output.empty())
+				continue;
+
+			record.isLink = kind == "link";
+			latest[record.output] = record;
+		}
+
+		std::vector<ResourceRecord> records;
+		records.reserve(latest.size());
+		for (auto& [output, record] : latest)
+			records.push_back(std::move(record));
+
+		return records;
+	}
+
+	std::vector<ResourceRecord> ResourceLog::LoadNinjaLog(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return {};
+
+		std::unordered_map<std::string, ResourceRecord> latest;
+
+		// Every line of format v5 and later is: start in ms, end in ms, mtime, output, command hash.
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream stream(line);
+			uint64_t start = 0;
+			uint64_t end = 0;
+			std::string mtime;
+			ResourceRecord record;
+			if (!(stream >> start) || stream.get() != '\t' || !(stream >> end) || stream.get() != '\t' ||
+			    !std::getline(stream, mtime, '\t') || !std::getline(stream, record.output, '\t') || end < start)
+				continue;
+
+			// Other steps, such as CMake regenerating build.ninja, are neither compiles nor links.
+			std::string extension = std::filesystem::path(record.output).extension().string();
+			bool isVersionedLibrary = record.output.find(".so.") != std::string::npos;
+			if (!s_CompileExtensions.count(extension) && !s_LinkExtensions.count(extension) && !isVersionedLibrary)
+				continue;
+
+			record.isLink = !s_CompileExtensions.count(extension);
+			record.wallTime = end - start;
+			latest[record.output] = record;
+		}
+
+		std::vector<ResourceRecord> records;
+		records.reserve(latest.size());
+		for (auto& [output, record] : latest)
+			records.push_back(std::move(record));
+
+		return records;
+	}
+}
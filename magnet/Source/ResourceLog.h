@@ -0,0 +1,41 @@
+#pragma once
+
+namespace MG
+{
+	// A single compile or link as recorded by magnet-launcher.
+	struct ResourceRecord
+	{
+		bool isLink = false;
+
+		// Times are in milliseconds.
+		uint64_t wallTime = 0;
+		uint64_t userTime = 0;
+		uint64_t systemTime = 0;
+
+		// Peak resident set size in kilobytes.
+		uint64_t peakMemory = 0;
+
+		int exitCode = 0;
+		std::string output;
+
+		// Returns user + system time in milliseconds.
+		[[nodiscard]] uint64_t GetCpuTime() const;
+	};
+
+	// Reads the append-only log written by magnet-launcher.
+	class ResourceLog
+	{
+	public:
+		// Returns the path of the log inside the given build folder.
+		static std::filesystem::path GetPath(const std::filesystem::path& buildPath);
+
+		// Returns the most recent record of every output file, in no particular order. Starts reading at the given
+		// offset, e.g. the size of the log before a build to only get the steps of that build.
+		static std::vector<ResourceRecord> Load(const std::filesystem::path& path, uint64_t offset = 0);
+
+		// Returns the most recent record of every compile and link in a .ninja_log, for builds without
+		// magnet-launcher. Ninja only logs when a step started and ended, so only the wall time is set and CPU time
+		// is 0.
+		static std::vector<ResourceRecord> LoadNinjaLog(const std::filesystem::path& path);
+	};
+}
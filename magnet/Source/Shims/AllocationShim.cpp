@@ -0,0 +1,579 @@
+// Allocation profiler preloaded into projects by `magnet go --alloc-profile` (see LD_PRELOAD).
+// Interposes malloc, free and the replaceable operator new and delete, and counts every call.
+// Call stacks are only recorded for sampled allocations, roughly one per MAGNET_ALLOC_SAMPLE_BYTES
+// allocated bytes, so that the overhead stays low on allocation heavy workloads.
+//
+// At exit, the process writes a report to MAGNET_ALLOC_PROFILE/<pid>.txt, with one record per line:
+//   totals <allocations> <frees> <allocated bytes> <peak live bytes> <live bytes> <sample bytes>
+//   dropped <samples that didn't fit into the stack table>
+//   timeline <ms since start> <live bytes> <peak live bytes since the previous point>
+//   stack <estimated allocations> <estimated bytes> <return addresses, innermost first, in hex>...
+//   exe <path>
+// followed by a line `maps` and a copy of /proc/self/maps, so that magnet can symbolize the addresses.
+//
+// Nothing in here may allocate with malloc, since it runs inside of malloc.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C"
+{
+	// The allocator of glibc, which doesn't have to be looked up with dlsym, since that allocates.
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* pointer, size_t size);
+	void* __libc_memalign(size_t alignment, size_t size);
+	void __libc_free(void* pointer);
+}
+
+#define MG_SHIM_EXPORT extern "C" __attribute__((visibility("default")))
+#define MG_SHIM_THREAD_LOCAL static thread_local __attribute__((tls_model("initial-exec")))
+
+static constexpr uint64_t s_DefaultSampleBytes = 64 * 1024;
+static constexpr uint32_t s_MaxFrames = 32;
+static constexpr uint32_t s_StackCapacity = 16384;
+static constexpr uint32_t s_TimelineCapacity = 1024;
+static constexpr uint64_t s_InitialTimelineInterval = 10;
+
+// Frames further apart than this are assumed to be garbage, e.g. from code built without frame pointers.
+static constexpr uintptr_t s_MaxFrameSize = 1024 * 1024;
+
+struct Stack
+{
+	uint64_t hash;
+	uint64_t count;
+	uint64_t bytes;
+	uint32_t depth;
+	uintptr_t frames[s_MaxFrames];
+};
+
+struct TimelinePoint
+{
+	uint64_t milliseconds;
+	int64_t liveBytes;
+	int64_t peakBytes;
+};
+
+static std::atomic<uint64_t> s_Allocations {0};
+static std::atomic<uint64_t> s_Frees {0};
+static std::atomic<uint64_t> s_AllocatedBytes {0};
+static std::atomic<int64_t> s_LiveBytes {0};
+static std::atomic<int64_t> s_PeakBytes {0};
+
+// Guards the stacks and the timeline, which are only touched by sampled allocations.
+static std::atomic_flag s_Lock = ATOMIC_FLAG_INIT;
+static Stack* s_Stacks = nullptr;
+static uint32_t s_StackCount = 0;
+static uint64_t s_DroppedSamples = 0;
+
+static TimelinePoint s_Timeline[s_TimelineCapacity];
+static uint32_t s_TimelineCount = 0;
+static uint64_t s_TimelineInterval = s_InitialTimelineInterval;
+static int64_t s_TimelinePeak = 0;
+
+static uint64_t s_SampleBytes = s_DefaultSampleBytes;
+static uint64_t s_StartTime = 0;
+static bool s_IsEnabled = false;
+
+MG_SHIM_THREAD_LOCAL bool t_IsInside = false;
+MG_SHIM_THREAD_LOCAL int64_t t_BytesUntilSample = 0;
+MG_SHIM_THREAD_LOCAL uint64_t t_Random = 0;
+
+static uint64_t GetMilliseconds()
+{
+	timespec time {};
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+	return (uint64_t) time.tv_sec * 1000 + (uint64_t) time.tv_nsec / 1000000;
+}
+
+// Picks the distance to the next sample uniformly between 0 and twice the sampling interval, so that allocation
+// patterns that repeat every interval aren't always or never sampled.
+static int64_t GetSampleDistance()
+{
+	if (t_Random == 0)
+		t_Random = (uint64_t) (uintptr_t) &t_Random ^ GetMilliseconds() ^ 0x9e3779b97f4a7c15ull;
+
+	t_Random ^= t_Random << 13;
+	t_Random ^= t_Random >> 7;
+	t_Random ^= t_Random << 17;
+	return (int64_t) (t_Random % (2 * s_SampleBytes) + 1);
+}
+
+__attribute__((constructor)) static void Initialize()
+{
+	const char* output = std::getenv("MAGNET_ALLOC_PROFILE");
+	if (!output || output[0] == '\0')
+		return;
+
+	if (const char* sampleBytes = std::getenv("MAGNET_ALLOC_SAMPLE_BYTES"))
+	{
+		uint64_t value = std::strtoull(sampleBytes, nullptr, 10);
+		if (value > 0)
+			s_SampleBytes = value;
+	}
+
+	void* memory = mmap(nullptr, sizeof(Stack) * s_StackCapacity, PROT_READ | PROT_WRITE,
+	                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return;
+
+	s_Stacks = static_cast<Stack*>(memory);
+	s_StartTime = GetMilliseconds();
+	s_IsEnabled = true;
+}
+
+static void Lock()
+{
+	while (s_Lock.test_and_set(std::memory_order_acquire))
+	{
+	}
+}
+
+static void Unlock()
+{
+	s_Lock.clear(std::memory_order_release);
+}
+
+// Adds a point whenever an interval has passed. Once the timeline is full, every other point is dropped and the
+// interval doubles, so that it always covers the whole run.
+static void UpdateTimeline(uint64_t now)
+{
+	int64_t live = s_LiveBytes.load(std::memory_order_relaxed);
+	if (live > s_TimelinePeak)
+		s_TimelinePeak = live;
+
+	uint64_t milliseconds = now - s_StartTime;
+	if (s_TimelineCount > 0 && milliseconds < s_Timeline[s_TimelineCount - 1].milliseconds + s_TimelineInterval)
+		return;
+
+	if (s_TimelineCount == s_TimelineCapacity)
+	{
+		for (uint32_t i = 0; i < s_TimelineCapacity / 2; i++)
+		{
+			TimelinePoint merged = s_Timeline[2 * i + 1];
+			if (s_Timeline[2 * i].peakBytes > merged.peakBytes)
+				merged.peakBytes = s_Timeline[2 * i].peakBytes;
+
+			s_Timeline[i] = merged;
+		}
+
+		s_TimelineCount = s_TimelineCapacity / 2;
+		s_TimelineInterval *= 2;
+	}
+
+	s_Timeline[s_TimelineCount++] = {milliseconds, live, s_TimelinePeak};
+	s_TimelinePeak = live;
+}
+
+// Walks the frame pointer chain, which is a few loads per frame instead of a full unwind.
+__attribute__((noinline)) static uint32_t CaptureStack(uintptr_t* frames)
+{
+	uint32_t depth = 0;
+	auto* frame = static_cast<uintptr_t*>(__builtin_frame_address(0));
+	while (frame && depth < s_MaxFrames)
+	{
+		uintptr_t returnAddress = frame[1];
+		if (returnAddress < 4096)
+			break;
+
+		frames[depth++] = returnAddress;
+
+		auto* next = reinterpret_cast<uintptr_t*>(frame[0]);
+		if (next <= frame || (uintptr_t) next - (uintptr_t) frame > s_MaxFrameSize ||
+		    (uintptr_t) next % sizeof(uintptr_t) != 0)
+			break;
+
+		frame = next;
+	}
+
+	return depth;
+}
+
+static void RecordSample(size_t size)
+{
+	uintptr_t frames[s_MaxFrames];
+	uint32_t depth = CaptureStack(frames);
+
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t i = 0; i < depth; i++)
+		hash = (hash ^ frames[i]) * 1099511628211ull;
+
+	// An allocation smaller than the interval stands for all allocations in the interval, like in tcmalloc.
+	uint64_t bytes = size < s_SampleBytes ? s_SampleBytes : size;
+	uint64_t count = size == 0 ? 1 : (bytes + size / 2) / size;
+
+	Lock();
+
+	uint32_t index = (uint32_t) (hash % s_StackCapacity);
+	for (uint32_t probe = 0; probe < s_StackCapacity; probe++)
+	{
+		Stack& stack = s_Stacks[index];
+		if (stack.depth == 0)
+		{
+			if (s_StackCount >= s_StackCapacity * 3 / 4)
+			{
+				s_DroppedSamples++;
+				break;
+			}
+
+			stack.hash = hash;
+			stack.depth = depth == 0 ? 1 : depth;
+			std::memcpy(stack.frames, frames, sizeof(uintptr_t) * depth);
+			s_StackCount++;
+		}
+
+		if (stack.hash == hash)
+		{
+			stack.count += count;
+			stack.bytes += bytes;
+			break;
+		}
+
+		index = (index + 1) % s_StackCapacity;
+	}
+
+	UpdateTimeline(GetMilliseconds());
+
+	Unlock();
+}
+
+static void UpdatePeak(int64_t live)
+{
+	int64_t peak = s_PeakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !s_PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+static void OnAllocation(void* pointer, size_t size)
+{
+	if (!pointer || !s_IsEnabled || t_IsInside)
+		return;
+
+	uint64_t allocations = s_Allocations.fetch_add(1, std::memory_order_relaxed);
+	s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	auto usable = (int64_t) malloc_usable_size(pointer);
+	int64_t live = s_LiveBytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+	UpdatePeak(live);
+
+	t_BytesUntilSample -= (int64_t) size;
+	bool isSampled = t_BytesUntilSample <= 0;
+	if (!isSampled && allocations % 1024 != 0)
+		return;
+
+	t_IsInside = true;
+	if (isSampled)
+	{
+		t_BytesUntilSample = GetSampleDistance();
+		RecordSample(size);
+	} else
+	{
+		// Keeps the timeline going in phases with few sampled allocations.
+		Lock();
+		UpdateTimeline(GetMilliseconds());
+		Unlock();
+	}
+
+	t_IsInside = false;
+}
+
+static void OnFree(void* pointer)
+{
+	if (!pointer || !s_IsEnabled || t_IsInside)
+		return;
+
+	s_Frees.fetch_add(1, std::memory_order_relaxed);
+	s_LiveBytes.fetch_sub((int64_t) malloc_usable_size(pointer), std::memory_order_relaxed);
+}
+
+static void* AllocateOrThrow(size_t size, size_t alignment)
+{
+	while (true)
+	{
+		void* pointer = alignment > alignof(std::max_align_t) ? __libc_memalign(alignment, size)
+		                                                      : __libc_malloc(size);
+		if (pointer)
+		{
+			OnAllocation(pointer, size);
+			return pointer;
+		}
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+static void* AllocateOrNull(size_t size, size_t alignment) noexcept
+{
+	try
+	{
+		return AllocateOrThrow(size, alignment);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+static void Deallocate(void* pointer) noexcept
+{
+	OnFree(pointer);
+	__libc_free(pointer);
+}
+
+static void WriteAll(int file, const char* data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(file, data, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return;
+
+		data += written;
+		size -= (size_t) written;
+	}
+}
+
+__attribute__((destructor)) static void WriteReport()
+{
+	if (!s_IsEnabled)
+		return;
+
+	t_IsInside = true;
+
+	char path[4096];
+	std::snprintf(path, sizeof(path), "%s/%d.txt", std::getenv("MAGNET_ALLOC_PROFILE"), (int) getpid());
+
+	int file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (file == -1)
+		return;
+
+	Lock();
+	UpdateTimeline(GetMilliseconds() + s_TimelineInterval);
+
+	char line[1024];
+	int length = std::snprintf(line, sizeof(line), "totals %llu %llu %llu %lld %lld %llu\n",
+	                           (unsigned long long) s_Allocations.load(), (unsigned long long) s_Frees.load(),
+	                           (unsigned long long) s_AllocatedBytes.load(), (long long) s_PeakBytes.load(),
+	                           (long long) s_LiveBytes.load(), (unsigned long long) s_SampleBytes);
+	WriteAll(file, line, (size_t) length);
+
+	length = std::snprintf(line, sizeof(line), "dropped %llu\n", (unsigned long long) s_DroppedSamples);
+	WriteAll(file, line, (size_t) length);
+
+	for (uint32_t i = 0; i < s_TimelineCount; i++)
+	{
+		length = std::snprintf(line, sizeof(line), "timeline %llu %lld %lld\n",
+		                       (unsigned long long) s_Timeline[i].milliseconds, (long long) s_Timeline[i].liveBytes,
+		                       (long long) s_Timeline[i].peakBytes);
+		WriteAll(file, line, (size_t) length);
+	}
+
+	for (uint32_t i = 0; i < s_StackCapacity; i++)
+	{
+		const Stack& stack = s_Stacks[i];
+		if (stack.depth == 0)
+			continue;
+
+		length = std::snprintf(line, sizeof(line), "stack %llu %llu", (unsigned long long) stack.count,
+		                       (unsigned long long) stack.bytes);
+		for (uint32_t frame = 0; frame < stack.depth && length < (int) sizeof(line) - 20; frame++)
+			length += std::snprintf(line + length, sizeof(line) - (size_t) length, " %llx",
+			                        (unsigned long long) stack.frames[frame]);
+
+		line[length++] = '\n';
+		WriteAll(file, line, (size_t) length);
+	}
+
+	Unlock();
+
+	ssize_t exeLength = readlink("/proc/self/exe", path, sizeof(path) - 1);
+	if (exeLength > 0)
+	{
+		WriteAll(file, "exe ", 4);
+		WriteAll(file, path, (size_t) exeLength);
+		WriteAll(file, "\n", 1);
+	}
+
+	WriteAll(file, "maps\n", 5);
+
+	int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+	if (maps != -1)
+	{
+		char buffer[4096];
+		ssize_t bytesRead;
+		while ((bytesRead = read(maps, buffer, sizeof(buffer))) > 0)
+			WriteAll(file, buffer, (size_t) bytesRead);
+
+		close(maps);
+	}
+
+	close(file);
+}
+
+MG_SHIM_EXPORT void* malloc(size_t size)
+{
+	void* pointer = __libc_malloc(size);
+	OnAllocation(pointer, size);
+	return pointer;
+}
+
+MG_SHIM_EXPORT void* calloc(size_t count, size_t size)
+{
+	void* pointer = __libc_calloc(count, size);
+	OnAllocation(pointer, count * size);
+	return pointer;
+}
+
+MG_SHIM_EXPORT void* realloc(void* pointer, size_t size)
+{
+	// The old block is gone if the call succeeds, or if it frees it by asking for 0 bytes.
+	size_t oldSize = pointer ? malloc_usable_size(pointer) : 0;
+	void* result = __libc_realloc(pointer, size);
+	if (pointer && (result || size == 0) && s_IsEnabled && !t_IsInside)
+	{
+		s_Frees.fetch_add(1, std::memory_order_relaxed);
+		s_LiveBytes.fetch_sub((int64_t) oldSize, std::memory_order_relaxed);
+	}
+
+	OnAllocation(result, size);
+	return result;
+}
+
+MG_SHIM_EXPORT void* memalign(size_t alignment, size_t size)
+{
+	void* pointer = __libc_memalign(alignment, size);
+	OnAllocation(pointer, size);
+	return pointer;
+}
+
+MG_SHIM_EXPORT void* aligned_alloc(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+MG_SHIM_EXPORT int posix_memalign(void** result, size_t alignment, size_t size)
+{
+	if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+		return EINVAL;
+
+	void* pointer = memalign(alignment, size);
+	if (!pointer)
+		return ENOMEM;
+
+	*result = pointer;
+	return 0;
+}
+
+MG_SHIM_EXPORT void free(void* pointer)
+{
+	Deallocate(pointer);
+}
+
+void* operator new(size_t size)
+{
+	return AllocateOrThrow(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+	return AllocateOrThrow(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocateOrNull(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocateOrNull(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return AllocateOrThrow(size, (size_t) alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return AllocateOrThrow(size, (size_t) alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateOrNull(size, (size_t) alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateOrNull(size, (size_t) alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+	Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+	Deallocate(pointer);
+}
@@ -0,0 +1,453 @@
+#include "SizeReport.h"
+
+#include "Core.h"
+#include "Elf.h"
+#include "Event.h"
+
+namespace MG
+{
+	static constexpr uint32_t s_NoBitsSection = 8;
+	static constexpr uint64_t s_AllocatedSectionFlag = 2;
+
+	// Symbols and templates beyond this are left out, since a binary easily has tens of thousands of them.
+	static constexpr size_t s_MaxPrintedEntries = 20;
+
+	// Long template names are cut off, so that the columns stay readable.
+	static constexpr size_t s_MaxNameLength = 100;
+
+	// Special symbols that the demangler names in words, e.g. "vtable for Widget".
+	static const std::array<std::string_view, 10> s_SpecialNamePrefixes = {
+			"vtable for ", "VTT for ", "construction vtable for ", "typeinfo for ", "typeinfo name for ",
+			"guard variable for ", "TLS init function for ", "TLS wrapper function for ", "non-virtual thunk to ",
+			"virtual thunk to "
+	};
+
+	// Removes the return type that the names of function templates start with, e.g. "int " from "int foo<>", which is
+	// everything up to the last space outside of lambdas, "(anonymous namespace)" and the name of an operator.
+	static std::string StripReturnType(const std::string& name)
+	{
+		static constexpr std::string_view s_Operator = "operator";
+		static constexpr std::string_view s_AnonymousNamespace = "(anonymous namespace)";
+
+		for (std::string_view prefix : s_SpecialNamePrefixes)
+		{
+			if (name.compare(0, prefix.size(), prefix) == 0)
+				return std::string(prefix) + StripReturnType(name.substr(prefix.size()));
+		}
+
+		size_t nameStart = 0;
+		uint32_t lambdaDepth = 0;
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			bool isWordStart = i == 0 || (!std::isalnum((unsigned char) name[i - 1]) && name[i - 1] != '_');
+			if (lambdaDepth == 0 && isWordStart && name.compare(i, s_Operator.size(), s_Operator) == 0)
+				break;
+
+			if (name.compare(i, s_AnonymousNamespace.size(), s_AnonymousNamespace) == 0)
+				i += s_AnonymousNamespace.size() - 1;
+			else if (name[i] == '{')
+				lambdaDepth++;
+			else if (name[i] == '}' && lambdaDepth > 0)
+				lambdaDepth--;
+			else if (name[i] == ' ' && lambdaDepth == 0 && i + 1 < name.size())
+				nameStart = i + 1;
+		}
+
+		return name.substr(nameStart);
+	}
+
+	static std::string FormatBytes(double bytes)
+	{
+		static const std::array<std::pair<double, const char*>, 2> s_Units = {{
+				{1024.0 * 1024.0, "MB"},
+				{1024.0,          "KB"},
+		}};
+
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1);
+
+		for (const auto& [factor, unit] : s_Units)
+		{
+			if (std::abs(bytes) >= factor)
+			{
+				stream << bytes / factor << " " << unit;
+				return stream.str();
+			}
+		}
+
+		stream << std::setprecision(0) << bytes << " B";
+		return stream.str();
+	}
+
+	static std::string FormatChange(int64_t bytes)
+	{
+		return (bytes > 0 ? "+" : "") + FormatBytes((double) bytes);
+	}
+
+	static std::string ShortenName(const std::string& name)
+	{
+		return name.size() > s_MaxNameLength ? name.substr(0, s_MaxNameLength - 3) + "..." : name;
+	}
+
+	// Returns the entries of both maps whose size differs, the biggest change first.
+	template<typename T, typename GetSize>
+	static std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> GetChanges(
+			const std::map<std::string, T>& before, const std::map<std::string, T>& after, GetSize getSize)
+	{
+		std::map<std::string, std::pair<uint64_t, uint64_t>> sizes;
+		for (const auto& [name, value] : before)
+			sizes[name].first = getSize(value);
+		for (const auto& [name, value] : after)
+			sizes[name].second = getSize(value);
+
+		std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> changes;
+		for (const auto& [name, size] : sizes)
+		{
+			if (size.first != size.second)
+				changes.emplace_back(name, size);
+		}
+
+		std::stable_sort(changes.begin(), changes.end(), [](const auto& a, const auto& b)
+		{
+			auto change = [](const auto& size)
+			{
+				return size.first > size.second ? size.first - size.second : size.second - size.first;
+			};
+
+			return change(a.second) > change(b.second);
+		});
+
+		return changes;
+	}
+
+	static void PrintChanges(const std::string& title, const std::string& kind,
+	                         const std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>>& changes,
+	                         size_t maxPrinted)
+	{
+		if (changes.empty())
+			return;
+
+		MG_LOGNH("");
+		MG_LOG(title + ":");
+
+		std::ostringstream header;
+		header << std::right << std::setw(12) << "Before" << std::setw(12) << "After" << std::setw(12) << "Change"
+		       << "  " << "Name";
+		MG_LOGNH(header.str());
+
+		int64_t otherChange = 0;
+		for (size_t i = 0; i < changes.size(); i++)
+		{
+			const auto& [name, size] = changes[i];
+			int64_t change = (int64_t) size.second - (int64_t) size.first;
+
+			if (i >= maxPrinted)
+			{
+				otherChange += change;
+				continue;
+			}
+
+			Event("size_change").AddString("kind", kind).AddString("name", name)
+			                    .AddNumber("before", (double) size.first).AddNumber("after", (double) size.second)
+			                    .Emit();
+
+			std::string note = size.first == 0 ? " (new)" : size.second == 0 ? " (removed)" : "";
+
+			std::ostringstream line;
+			line << std::right << std::setw(12) << FormatBytes((double) size.first) << std::setw(12)
+			     << FormatBytes((double) size.second) << std::setw(12) << FormatChange(change) << "  "
+			     << ShortenName(name) << note;
+			MG_LOGNH(line.str());
+		}
+
+		if (changes.size() > maxPrinted)
+		{
+			MG_LOGNH("...and " + std::to_string(changes.size() - maxPrinted) + " more, which changed by " +
+			         FormatChange(otherChange) + " in total.");
+		}
+	}
+
+	SizeReport SizeReport::FromFile(const std::filesystem::path& path)
+	{
+		SizeReport report;
+
+		ElfFile file = ElfFile::Load(path);
+		if (!file.IsValid())
+			return report;
+
+		report.m_Path = path;
+		report.m_IsValid = true;
+
+		std::error_code error;
+		report.m_FileSize = std::filesystem::file_size(path, error);
+
+		const auto& sections = file.GetSections();
+		for (const auto& section : sections)
+		{
+			if (section.size == 0 || section.name.empty())
+				continue;
+
+			report.m_Sections[section.name] += section.size;
+
+			if (section.flags & s_AllocatedSectionFlag)
+			{
+				report.m_LoadedSize += section.size;
+			} else
+			{
+				report.m_UnloadedSize += section.size;
+				report.m_UnloadedSections.insert(section.name);
+			}
+
+			// E.g. .bss takes up memory at runtime, but no space in the file.
+			if (section.type == s_NoBitsSection)
+				report.m_EmptySections.insert(section.name);
+		}
+
+		for (const auto& symbol : file.GetSymbols())
+		{
+			if (symbol.size == 0)
+				continue;
+
+			// Symbols from shared libraries carry their version, as in _ZSt4cout@GLIBCXX_3.4.
+			std::string name = ElfFile::Demangle(symbol.name.substr(0, symbol.name.find('@')));
+
+			Symbol& entry = report.m_Symbols[name];
+			entry.size += symbol.size;
+			if (symbol.section < sections.size())
+				entry.section = sections[symbol.section].name;
+
+			std::string templateName = StripTemplateArguments(name);
+			if (templateName.find("<>") != std::string::npos)
+			{
+				auto& [size, count] = report.m_Templates[templateName];
+				size += symbol.size;
+				count++;
+			}
+		}
+
+		return report;
+	}
+
+	bool SizeReport::IsValid() const
+	{
+		return m_IsValid;
+	}
+
+	void SizeReport::Print() const
+	{
+		MG_LOG(m_Path.string() + " is " + FormatBytes((double) m_FileSize) + ", of which " +
+		       FormatBytes((double) m_LoadedSize) + " is loaded into memory.");
+
+		Event("size").AddString("path", m_Path.string()).AddNumber("file", (double) m_FileSize)
+		             .AddNumber("loaded", (double) m_LoadedSize).AddNumber("unloaded", (double) m_UnloadedSize)
+		             .Emit();
+
+		std::vector<std::pair<std::string, uint64_t>> sections(m_Sections.begin(), m_Sections.end());
+		std::stable_sort(sections.begin(), sections.end(), [](const auto& a, const auto& b)
+		{
+			return a.second > b.second;
+		});
+
+		MG_LOGNH("");
+		MG_LOG("Sections:");
+
+		std::ostringstream header;
+		header << std::left << std::setw(24) << "Section" << std::right << std::setw(12) << "Size" << std::setw(8)
+		       << "Share";
+		MG_LOGNH(header.str());
+
+		for (const auto& [name, size] : sections)
+		{
+			bool isLoaded = !m_UnloadedSections.count(name);
+			Event("size_section").AddString("name", name).AddNumber("size", (double) size)
+			                     .AddBool("loaded", isLoaded).Emit();
+
+			std::ostringstream share;
+			share << std::fixed << std::setprecision(1) << 100.0 * (double) size / (double) std::max<uint64_t>(
+					m_LoadedSize + m_UnloadedSize, 1) << "%";
+
+			std::ostringstream line;
+			line << std::left << std::setw(24) << name << std::right << std::setw(12) << FormatBytes((double) size)
+			     << std::setw(8) << share.str() << (!isLoaded ? "  (not loaded)" :
+			                                        m_EmptySections.count(name) ? "  (not in the file)" : "");
+			MG_LOGNH(line.str());
+		}
+
+		if (m_Symbols.empty())
+		{
+			MG_LOGNH("");
+			MG_LOG("The binary has no symbols, e.g. because it's stripped, so only its sections are known.");
+			return;
+		}
+
+		std::vector<std::pair<std::string, Symbol>> symbols(m_Symbols.begin(), m_Symbols.end());
+		std::stable_sort(symbols.begin(), symbols.end(), [](const auto& a, const auto& b)
+		{
+			return a.second.size > b.second.size;
+		});
+
+		MG_LOGNH("");
+		MG_LOG("Largest symbols:");
+
+		std::ostringstream symbolHeader;
+		symbolHeader << std::right << std::setw(12) << "Size" << "  " << std::left << std::setw(16) << "Section"
+		             << "Name";
+		MG_LOGNH(symbolHeader.str());
+
+		for (size_t i = 0; i < std::min(symbols.size(), s_MaxPrintedEntries); i++)
+		{
+			const auto& [name, symbol] = symbols[i];
+			Event("size_symbol").AddString("name", name).AddString("section", symbol.section)
+			                    .AddNumber("size", (double) symbol.size).Emit();
+
+			std::ostringstream line;
+			line << std::right << std::setw(12) << FormatBytes((double) symbol.size) << "  " << std::left
+			     << std::setw(16) << symbol.section << ShortenName(name);
+			MG_LOGNH(line.str());
+		}
+
+		if (m_Templates.empty())
+			return;
+
+		std::vector<std::pair<std::string, std::pair<uint64_t, uint32_t>>> templates(m_Templates.begin(),
+		                                                                             m_Templates.end());
+		std::stable_sort(templates.begin(), templates.end(), [](const auto& a, const auto& b)
+		{
+			return a.second.first > b.second.first;
+		});
+
+		MG_LOGNH("");
+		MG_LOG("Largest templates, over all of their instantiations:");
+
+		std::ostringstream templateHeader;
+		templateHeader << std::right << std::setw(12) << "Size" << std::setw(10) << "Symbols" << "  " << "Name";
+		MG_LOGNH(templateHeader.str());
+
+		for (size_t i = 0; i < std::min(templates.size(), s_MaxPrintedEntries); i++)
+		{
+			const auto& [name, sizeAndCount] = templates[i];
+			const auto& [size, count] = sizeAndCount;
+			Event("size_template").AddString("name", name).AddNumber("size", (double) size)
+			                      .AddNumber("symbols", count).Emit();
+
+			std::ostringstream line;
+			line << std::right << std::setw(12) << FormatBytes((double) size) << std::setw(10) << count << "  "
+			     << ShortenName(name);
+			MG_LOGNH(line.str());
+		}
+	}
+
+	void SizeReport::PrintDifference(const SizeReport& baseline) const
+	{
+		int64_t fileChange = (int64_t) m_FileSize - (int64_t) baseline.m_FileSize;
+		int64_t loadedChange = (int64_t) m_LoadedSize - (int64_t) baseline.m_LoadedSize;
+
+		MG_LOG(m_Path.string() + " is " + FormatBytes((double) m_FileSize) + " (" + FormatChange(fileChange) +
+		       "), of which " + FormatBytes((double) m_LoadedSize) + " (" + FormatChange(loadedChange) +
+		       ") is loaded into memory, compared to " + baseline.m_Path.string() + ".");
+
+		Event("size").AddString("path", m_Path.string()).AddString("baseline", baseline.m_Path.string())
+		             .AddNumber("file", (double) m_FileSize).AddNumber("baselineFile", (double) baseline.m_FileSize)
+		             .AddNumber("loaded", (double) m_LoadedSize)
+		             .AddNumber("baselineLoaded", (double) baseline.m_LoadedSize).Emit();
+
+		auto getSize = [](uint64_t size)
+		{
+			return size;
+		};
+
+		auto sections = GetChanges(baseline.m_Sections, m_Sections, getSize);
+		auto symbols = GetChanges(baseline.m_Symbols, m_Symbols, [](const Symbol& symbol)
+		{
+			return symbol.size;
+		});
+		auto templates = GetChanges(baseline.m_Templates, m_Templates, [](const auto& sizeAndCount)
+		{
+			return sizeAndCount.first;
+		});
+
+		if (sections.empty() && symbols.empty())
+		{
+			MG_LOG("The sections and symbols of both are the same size.");
+			return;
+		}
+
+		PrintChanges("Changed sections", "section", sections, sections.size());
+		PrintChanges("Changed symbols", "symbol", symbols, s_MaxPrintedEntries);
+		PrintChanges("Changed templates, over all of their instantiations", "template", templates,
+		             s_MaxPrintedEntries);
+	}
+
+	std::string SizeReport::StripTemplateArguments(const std::string& name)
+	{
+		static constexpr std::string_view s_Operator = "operator";
+		static constexpr std::string_view s_AnonymousNamespace = "(anonymous namespace)";
+		static constexpr std::string_view s_OperatorCharacters = "<>=!+-*/%^&|~,[]";
+
+		std::string result;
+		uint32_t templateDepth = 0;
+		uint32_t lambdaDepth = 0;
+
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			char character = name[i];
+
+			// The name of an operator, such as operator<< or operator(), isn't a template argument list.
+			bool isWordStart = i == 0 || (!std::isalnum((unsigned char) name[i - 1]) && name[i - 1] != '_');
+			if (isWordStart && name.compare(i, s_Operator.size(), s_Operator) == 0)
+			{
+				size_t end = i + s_Operator.size();
+				if (name.compare(end, 2, "()") == 0)
+					end += 2;
+
+				// The template arguments of operator+<int> start right after it, unlike those of operator<< <int>.
+				size_t symbolStart = end;
+				while (end < name.size() && s_OperatorCharacters.find(name[end]) != std::string_view::npos)
+				{
+					char previous = end > symbolStart ? name[end - 1] : '\0';
+					if (name[end] == '<' && previous != '\0' && previous != '<')
+						break;
+
+					end++;
+				}
+
+				if (templateDepth == 0)
+					result += name.substr(i, end - i);
+
+				i = end - 1;
+				continue;
+			}
+
+			if (character == '<')
+			{
+				if (templateDepth++ == 0)
+					result += character;
+			} else if (character == '>' && templateDepth > 0)
+			{
+				if (--templateDepth == 0)
+					result += character;
+			} else if (templateDepth > 0)
+			{
+				continue;
+			} else if (character == '(' && lambdaDepth == 0)
+			{
+				if (name.compare(i, s_AnonymousNamespace.size(), s_AnonymousNamespace) != 0)
+					break;
+
+				result += s_AnonymousNamespace;
+				i += s_AnonymousNamespace.size() - 1;
+			} else
+			{
+				// Lambdas are named like {lambda(int)#1}, with their arguments in the braces.
+				if (character == '{')
+					lambdaDepth++;
+				else if (character == '}' && lambdaDepth > 0)
+					lambdaDepth--;
+
+				result += character;
+			}
+		}
+
+		return StripReturnType(result);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+namespace MG
+{
+	// What an executable or shared library is made of, read from its ELF sections and symbols, for `magnet size`.
+	class SizeReport
+	{
+	public:
+		// Returns an invalid report if the path isn't a supported ELF file.
+		static SizeReport FromFile(const std::filesystem::path& path);
+
+		[[nodiscard]] bool IsValid() const;
+
+		// Prints the sections, the largest symbols and the largest templates, and emits them as events for
+		// `--output json`.
+		void Print() const;
+
+		// Prints what grew or shrank compared to the baseline, the biggest change first.
+		void PrintDifference(const SizeReport& baseline) const;
+
+		// Returns the name without template and function arguments and without the return type of a function
+		// template, e.g. "std::vector<>::push_back" for
+		// "std::vector<int, std::allocator<int> >::push_back(int const&)", so that all instantiations of a template
+		// are counted together.
+		static std::string StripTemplateArguments(const std::string& name);
+
+	private:
+		struct Symbol
+		{
+			uint64_t size = 0;
+			std::string section;
+		};
+
+		std::filesystem::path m_Path;
+		uint64_t m_FileSize = 0;
+
+		// Sizes of the sections that are loaded into memory and of those that aren't, such as debug information.
+		uint64_t m_LoadedSize = 0;
+		uint64_t m_UnloadedSize = 0;
+
+		std::map<std::string, uint64_t> m_Sections;
+		std::set<std::string> m_UnloadedSections;
+
+		// Sections that only take up memory, such as .bss.
+		std::set<std::string> m_EmptySections;
+
+		// By demangled name. Symbols of the same name, such as static functions in different files, add up.
+		std::map<std::string, Symbol> m_Symbols;
+		std::map<std::string, std::pair<uint64_t, uint32_t>> m_Templates;
+
+		bool m_IsValid = false;
+	};
+}
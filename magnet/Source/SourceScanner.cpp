@@ -0,0 +1,309 @@
+#include "SourceScanner.h"
+
+namespace MG
+{
+	// Bump whenever the index format changes.
+	static constexpr const char* s_IndexVersion = "magnet-source-index 1";
+
+	static int64_t GetModificationTime(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(path, error);
+		if (error)
+			return 0;
+
+		return (int64_t) time.time_since_epoch().count();
+	}
+
+	// Returns false and leaves time unchanged unless the whole text is a number.
+	static bool ParseTime(std::string_view text, int64_t& time)
+	{
+		int64_t value = 0;
+		auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc() || end != text.data() + text.size())
+			return false;
+
+		time = value;
+		return true;
+	}
+
+	SourceScanResult SourceScanner::Scan(const std::filesystem::path& root, const std::filesystem::path& indexPath,
+	                                     const std::vector<std::string>& extensions)
+	{
+		std::string joinedExtensions = std::accumulate(extensions.begin(), extensions.end(), std::string(),
+		                                               [](const std::string& a, const std::string& b)
+		                                               {
+			                                               return a + b + ";";
+		                                               });
+
+		int64_t previousScanTime = 0;
+		DirectoryIndex previous = ReadIndex(indexPath, joinedExtensions, previousScanTime);
+
+		// Directories modified at or after this point may still change within the same timestamp tick,
+		// so the next scan must not trust them.
+		int64_t scanTime = (int64_t) std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+
+		DirectoryIndex index;
+		SourceScanResult result;
+
+		if (!std::filesystem::is_directory(root))
+		{
+			result.hasChanged = !previous.empty();
+			result.removedFiles = CollectFiles(previous);
+			WriteIndex(indexPath, joinedExtensions, scanTime, index);
+			return result;
+		}
+
+		// The root is scanned without recursion, then every top-level subdirectory is handed to a pool
+		// of workers, each building its own partial index.
+		DirectoryIndex rootIndex;
+		ScanDirectory(root, "", previous, previousScanTime, extensions, rootIndex);
+
+		const auto& subdirectories = rootIndex[""].subdirectories;
+		uint32_t workerCount = std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1,
+		                                           (uint32_t) std::max<size_t>(subdirectories.size(), 1));
+
+		std::atomic<size_t> next = 0;
+		std::vector<DirectoryIndex> partialIndices(workerCount);
+		std::vector<std::thread> workers;
+
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			workers.emplace_back([&, i]()
+			                     {
+				                     for (size_t j = next++; j < subdirectories.size(); j = next++)
+				                     {
+					                     ScanDirectory(root, subdirectories[j], previous, previousScanTime,
+					                                   extensions, partialIndices[i]);
+				                     }
+			                     });
+		}
+
+		for (auto& worker : workers)
+			worker.join();
+
+		index[""] = rootIndex[""];
+		for (auto& partialIndex : partialIndices)
+			index.merge(partialIndex);
+
+		result.files = CollectFiles(index);
+
+		std::vector<std::string> previousFiles = CollectFiles(previous);
+		std::set_difference(result.files.begin(), result.files.end(), previousFiles.begin(), previousFiles.end(),
+		                    std::back_inserter(result.addedFiles));
+		std::set_difference(previousFiles.begin(), previousFiles.end(), result.files.begin(), result.files.end(),
+		                    std::back_inserter(result.removedFiles));
+
+		result.hasChanged = previous.empty() || !result.addedFiles.empty() || !result.removedFiles.empty();
+
+		WriteIndex(indexPath, joinedExtensions, scanTime, index);
+
+		return result;
+	}
+
+	bool SourceScanner::MatchesGlob(std::string_view pattern, std::string_view path)
+	{
+		while (!pattern.empty())
+		{
+			if (pattern.substr(0, 2) == "**")
+			{
+				pattern.remove_prefix(2);
+				if (!pattern.empty() && pattern[0] == '/')
+					pattern.remove_prefix(1);
+
+				// Try every possible split, including matching nothing at all.
+				for (size_t i = 0; i <= path.size(); i++)
+				{
+					if ((i == 0 || path[i - 1] == '/' || pattern.empty()) && MatchesGlob(pattern, path.substr(i)))
+						return true;
+				}
+
+				return false;
+			}
+
+			if (pattern[0] == '*')
+			{
+				pattern.remove_prefix(1);
+				for (size_t i = 0; i <= path.size(); i++)
+				{
+					if (MatchesGlob(pattern, path.substr(i)))
+						return true;
+
+					if (i < path.size() && path[i] == '/')
+						break;
+				}
+
+				return false;
+			}
+
+			if (path.empty() || (pattern[0] != '?' && pattern[0] != path[0]) || (pattern[0] == '?' && path[0] == '/'))
+				return false;
+
+			pattern.remove_prefix(1);
+			path.remove_prefix(1);
+		}
+
+		return path.empty();
+	}
+
+	std::vector<std::string> SourceScanner::Filter(const std::vector<std::string>& files,
+	                                               const std::vector<std::string>& patterns)
+	{
+		std::vector<std::string> matches;
+		for (const auto& file : files)
+		{
+			bool isMatch = std::any_of(patterns.begin(), patterns.end(), [&file](const std::string& pattern)
+			{
+				return MatchesGlob(pattern, file);
+			});
+
+			if (isMatch)
+				matches.push_back(file);
+		}
+
+		return matches;
+	}
+
+	void SourceScanner::ScanDirectory(const std::filesystem::path& root, const std::string& directory,
+	                                  const DirectoryIndex& previous, int64_t previousScanTime,
+	                                  const std::vector<std::string>& extensions, DirectoryIndex& index)
+	{
+		std::filesystem::path path = directory.empty() ? root : root / directory;
+
+		DirectoryEntry entry;
+		entry.modificationTime = GetModificationTime(path);
+
+		auto it = previous.find(directory);
+		bool isUnchanged = it != previous.end() && it->second.modificationTime == entry.modificationTime &&
+		                   entry.modificationTime < previousScanTime;
+
+		if (isUnchanged)
+		{
+			entry.files = it->second.files;
+			entry.subdirectories = it->second.subdirectories;
+		} else
+		{
+			std::error_code error;
+			for (const auto& child : std::filesystem::directory_iterator(path, error))
+			{
+				std::string name = child.path().filename().string();
+
+				if (child.is_directory(error) && !child.is_symlink(error))
+				{
+					entry.subdirectories.push_back(name);
+					continue;
+				}
+
+				std::string extension = child.path().extension().string();
+				if (std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+					entry.files.push_back(name);
+			}
+		}
+
+		// Only the root is scanned without recursion, since its children are distributed to workers.
+		std::vector<std::string> subdirectories = entry.subdirectories;
+		index[directory] = std::move(entry);
+
+		if (directory.empty())
+			return;
+
+		for (const auto& subdirectory : subdirectories)
+			ScanDirectory(root, Join(directory, subdirectory), previous, previousScanTime, extensions, index);
+	}
+
+	SourceScanner::DirectoryIndex SourceScanner::ReadIndex(const std::filesystem::path& indexPath,
+	                                                       const std::string& extensions, int64_t& scanTime)
+	{
+		std::ifstream file(indexPath);
+		if (!file)
+			return {};
+
+		std::string version;
+		std::string storedExtensions;
+		std::string storedScanTime;
+		if (!std::getline(file, version) || version != s_IndexVersion || !std::getline(file, storedExtensions) ||
+		    storedExtensions != extensions || !std::getline(file, storedScanTime) ||
+		    !ParseTime(storedScanTime, scanTime))
+			return {};
+
+		// Each directory starts with "D <mtime> <path>", followed by "F <name>" and "S <name>" lines.
+		// A corrupt index is discarded, which scans everything again.
+		DirectoryIndex index;
+		DirectoryEntry* current = nullptr;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.size() < 2)
+				continue;
+
+			std::string value = line.substr(2);
+			switch (line[0])
+			{
+				case 'D':
+				{
+					int64_t modificationTime = 0;
+					size_t separator = value.find('\t');
+					if (separator == std::string::npos ||
+					    !ParseTime(std::string_view(value).substr(0, separator), modificationTime))
+						return {};
+
+					current = &index[value.substr(separator + 1)];
+					current->modificationTime = modificationTime;
+					break;
+				}
+				case 'F':
+					if (current)
+						current->files.push_back(value);
+					break;
+				case 'S':
+					if (current)
+						current->subdirectories.push_back(value);
+					break;
+				default:
+					return {};
+			}
+		}
+
+		return index;
+	}
+
+	void SourceScanner::WriteIndex(const std::filesystem::path& indexPath, const std::string& extensions,
+	                               int64_t scanTime, const DirectoryIndex& index)
+	{
+		std::ofstream file(indexPath);
+		file << s_IndexVersion << "\n" << extensions << "\n" << scanTime << "\n";
+
+		for (const auto& [directory, entry] : index)
+		{
+			file << "D\t" << entry.modificationTime << "\t" << directory << "\n";
+
+			for (const auto& name : entry.files)
+				file << "F\t" << name << "\n";
+
+			for (const auto& name : entry.subdirectories)
+				file << "S\t" << name << "\n";
+		}
+	}
+
+	std::vector<std::string> SourceScanner::CollectFiles(const DirectoryIndex& index)
+	{
+		std::vector<std::string> files;
+		for (const auto& [directory, entry] : index)
+		{
+			for (const auto& name : entry.files)
+				files.push_back(Join(directory, name));
+		}
+
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	std::string SourceScanner::Join(const std::string& directory, const std::string& name)
+	{
+		if (directory.empty())
+			return name;
+
+		return directory + "/" + name;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+namespace MG
+{
+	// The outcome of scanning a folder for source files.
+	struct SourceScanResult
+	{
+		// Paths relative to the scanned folder, sorted, with forward slashes.
+		std::vector<std::string> files;
+
+		// Whether the set of files differs from the previous scan.
+		bool hasChanged = true;
+
+		// Files that weren't there in the previous scan, and files that are gone since. Both are sorted, like files.
+		std::vector<std::string> addedFiles;
+		std::vector<std::string> removedFiles;
+	};
+
+	// Finds source files in a folder tree while keeping a persistent index of every directory's
+	// modification time and listing. A directory's modification time only changes when entries are added,
+	// removed or renamed in it, so unchanged directories can reuse their listing from the index and
+	// only need a single stat call.
+	class SourceScanner
+	{
+	public:
+		// Scans the root folder for files with one of the given extensions and updates the index.
+		// Subdirectories of the root are walked in parallel.
+		static SourceScanResult Scan(const std::filesystem::path& root, const std::filesystem::path& indexPath,
+		                             const std::vector<std::string>& extensions);
+
+		// Returns whether a relative path matches the glob pattern. `*` and `?` match within a folder,
+		// `**` matches across folders, so "net/**" matches everything inside of net.
+		[[nodiscard]] static bool MatchesGlob(std::string_view pattern, std::string_view path);
+
+		// Returns the files matching at least one of the given glob patterns.
+		[[nodiscard]] static std::vector<std::string> Filter(const std::vector<std::string>& files,
+		                                                     const std::vector<std::string>& patterns);
+
+	private:
+		struct DirectoryEntry
+		{
+			int64_t modificationTime = 0;
+			std::vector<std::string> files;
+			std::vector<std::string> subdirectories;
+		};
+
+		using DirectoryIndex = std::unordered_map<std::string, DirectoryEntry>;
+
+		// Lists the given directory, or reuses its entry from the previous index if it's unchanged,
+		// then recurses into its subdirectories.
+		static void ScanDirectory(const std::filesystem::path& root, const std::string& directory,
+		                          const DirectoryIndex& previous, int64_t previousScanTime,
+		                          const std::vector<std::string>& extensions, DirectoryIndex& index);
+
+		// Returns an empty index if the file is missing or was written for different extensions.
+		static DirectoryIndex ReadIndex(const std::filesystem::path& indexPath, const std::string& extensions,
+		                                int64_t& scanTime);
+
+		static void WriteIndex(const std::filesystem::path& indexPath, const std::string& extensions,
+		                       int64_t scanTime, const DirectoryIndex& index);
+
+		// Returns all files of the index as sorted relative paths.
+		static std::vector<std::string> CollectFiles(const DirectoryIndex& index);
+
+		// Joins a relative directory and an entry name.
+		static std::string Join(const std::string& directory, const std::string& name);
+	};
+}
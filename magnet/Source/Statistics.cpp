@@ -0,0 +1,158 @@
+#include "Statistics.h"
+
+namespace MG
+{
+	double Statistics::Mean(const std::vector<double>& samples)
+	{
+		if (samples.empty())
+			return 0.0;
+
+		return std::accumulate(samples.begin(), samples.end(), 0.0) / (double) samples.size();
+	}
+
+	double Statistics::StandardDeviation(const std::vector<double>& samples)
+	{
+		if (samples.size() < 2)
+			return 0.0;
+
+		double mean = Mean(samples);
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += (sample - mean) * (sample - mean);
+
+		return std::sqrt(sum / (double) (samples.size() - 1));
+	}
+
+	double Statistics::Percentile(std::vector<double> samples, double percentile)
+	{
+		if (samples.empty())
+			return 0.0;
+
+		std::sort(samples.begin(), samples.end());
+
+		double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * (double) (samples.size() - 1);
+		auto lower = (size_t) std::floor(rank);
+		auto upper = (size_t) std::ceil(rank);
+
+		return samples[lower] + (samples[upper] - samples[lower]) * (rank - (double) lower);
+	}
+
+	double Statistics::Median(const std::vector<double>& samples)
+	{
+		return Percentile(samples, 50.0);
+	}
+
+	double Statistics::MannWhitneyU(const std::vector<double>& a, const std::vector<double>& b)
+	{
+		if (a.empty() || b.empty())
+			return 1.0;
+
+		size_t m = a.size();
+		size_t n = b.size();
+
+		// Rank both sets together, giving tied values the average of their ranks.
+		std::vector<std::pair<double, bool>> values;
+		for (double sample : a)
+			values.emplace_back(sample, true);
+		for (double sample : b)
+			values.emplace_back(sample, false);
+
+		std::sort(values.begin(), values.end());
+
+		double rankSumA = 0.0;
+		double tieCorrection = 0.0;
+		for (size_t i = 0; i < values.size();)
+		{
+			size_t j = i;
+			while (j < values.size() && values[j].first == values[i].first)
+				j++;
+
+			double rank = (double) (i + j + 1) / 2.0;
+			for (size_t k = i; k < j; k++)
+			{
+				if (values[k].second)
+					rankSumA += rank;
+			}
+
+			auto ties = (double) (j - i);
+			tieCorrection += ties * ties * ties - ties;
+			i = j;
+		}
+
+		double u = rankSumA - (double) (m * (m + 1)) / 2.0;
+
+		// Exact distribution: counts[i][j][k] is the number of orderings of i values from a and j values from b
+		// in which k pairs have the value from a above the one from b.
+		constexpr size_t exactLimit = 20;
+		if (tieCorrection == 0.0 && m <= exactLimit && n <= exactLimit)
+		{
+			size_t maxU = m * n;
+			std::vector<std::vector<std::vector<double>>> counts(
+					m + 1, std::vector<std::vector<double>>(n + 1, std::vector<double>(maxU + 1, 0.0)));
+
+			for (size_t i = 0; i <= m; i++)
+			{
+				for (size_t j = 0; j <= n; j++)
+				{
+					if (i == 0 || j == 0)
+					{
+						counts[i][j][0] = 1.0;
+						continue;
+					}
+
+					// The largest value is either from a, placing it above all j values of b, or from b.
+					for (size_t k = 0; k <= i * j; k++)
+						counts[i][j][k] = (k >= j ? counts[i - 1][j][k - j] : 0.0) + counts[i][j - 1][k];
+				}
+			}
+
+			const auto& distribution = counts[m][n];
+			double total = std::accumulate(distribution.begin(), distribution.end(), 0.0);
+
+			auto observed = (size_t) std::llround(u);
+			double lower = std::accumulate(distribution.begin(), distribution.begin() + (long) observed + 1, 0.0);
+			double upper = std::accumulate(distribution.begin() + (long) observed, distribution.end(), 0.0);
+
+			return std::min(1.0, 2.0 * std::min(lower, upper) / total);
+		}
+
+		// Normal approximation with tie and continuity correction.
+		auto total = (double) (m + n);
+		double mean = (double) (m * n) / 2.0;
+		double variance = (double) (m * n) / 12.0 * ((total + 1.0) - tieCorrection / (total * (total - 1.0)));
+		if (variance <= 0.0)
+			return 1.0;
+
+		double z = std::max(0.0, std::abs(u - mean) - 0.5) / std::sqrt(variance);
+		return std::min(1.0, std::erfc(z / std::sqrt(2.0)));
+	}
+
+	ShiftEstimate Statistics::HodgesLehmann(const std::vector<double>& a, const std::vector<double>& b)
+	{
+		if (a.empty() || b.empty())
+			return {};
+
+		std::vector<double> differences;
+		differences.reserve(a.size() * b.size());
+		for (double x : a)
+		{
+			for (double y : b)
+				differences.push_back(y - x);
+		}
+
+		std::sort(differences.begin(), differences.end());
+
+		// The interval bounds are the k-th smallest and largest differences, where k follows from the critical
+		// value of U. The normal approximation is close enough to the exact value even for small samples.
+		auto m = (double) a.size();
+		auto n = (double) b.size();
+		double k = std::floor(m * n / 2.0 - 1.959964 * std::sqrt(m * n * (m + n + 1.0) / 12.0));
+		auto index = (size_t) std::max(0.0, k - 1.0);
+
+		ShiftEstimate shift;
+		shift.estimate = Median(differences);
+		shift.lower = differences[index];
+		shift.upper = differences[differences.size() - 1 - index];
+		return shift;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace MG
+{
+	// An estimated difference between two sets of samples, with the bounds of its 95% confidence interval.
+	struct ShiftEstimate
+	{
+		double estimate = 0.0;
+		double lower = 0.0;
+		double upper = 0.0;
+	};
+
+	// Descriptive statistics over a set of samples.
+	class Statistics
+	{
+	public:
+		[[nodiscard]] static double Mean(const std::vector<double>& samples);
+
+		// Returns the sample standard deviation, or 0 if there are fewer than two samples.
+		[[nodiscard]] static double StandardDeviation(const std::vector<double>& samples);
+
+		// Returns the given percentile (0 - 100) using linear interpolation between the closest ranks.
+		[[nodiscard]] static double Percentile(std::vector<double> samples, double percentile);
+
+		[[nodiscard]] static double Median(const std::vector<double>& samples);
+
+		// Returns the two-sided p-value of the Mann-Whitney U test, i.e. how likely samples at least this
+		// different are if both sets come from the same distribution. Makes no assumption about the shape of the
+		// distribution, which suits timings. Small samples without ties use the exact distribution of U.
+		[[nodiscard]] static double MannWhitneyU(const std::vector<double>& a, const std::vector<double>& b);
+
+		// Returns the Hodges-Lehmann estimate of how much larger b is than a, i.e. the median of all pairwise
+		// differences, together with the 95% confidence interval that matches the Mann-Whitney U test.
+		[[nodiscard]] static ShiftEstimate HodgesLehmann(const std::vector<double>& a, const std::vector<double>& b);
+	};
+}
@@ -0,0 +1,184 @@
+#include "TestHistory.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace MG
+{
+	TestHistory TestHistory::Load()
+	{
+		TestHistory history;
+		if (!std::filesystem::exists(s_HistoryPath))
+			return history;
+
+		YAML::Node node = YAML::LoadFile(s_HistoryPath);
+
+		for (const auto& test : node["tests"])
+		{
+			auto name = test.first.as<std::string>();
+			history.m_Durations[name] = test.second["duration"].as<double>(0.0);
+			history.m_Runs[name] = test.second["runs"].as<uint32_t>(0);
+		}
+
+		if (node["failed"])
+			history.m_FailedTests = node["failed"].as<std::vector<std::string>>();
+
+		return history;
+	}
+
+	void TestHistory::Save() const
+	{
+		YAML::Emitter out;
+
+		out << YAML::BeginMap;
+		out << YAML::Key << "tests";
+		out << YAML::Value << YAML::BeginMap;
+
+		for (const auto& [name, duration] : m_Durations)
+		{
+			out << YAML::Key << name;
+			out << YAML::Value << YAML::Flow << YAML::BeginMap;
+			out << YAML::Key << "duration" << YAML::Value << duration;
+			out << YAML::Key << "runs" << YAML::Value << m_Runs.at(name);
+			out << YAML::EndMap;
+		}
+
+		out << YAML::EndMap;
+		out << YAML::Key << "failed";
+		out << YAML::Value << m_FailedTests;
+		out << YAML::EndMap;
+
+		std::ofstream file(s_HistoryPath);
+		file << out.c_str();
+	}
+
+	void TestHistory::ReadCostData(const std::filesystem::path& buildPath)
+	{
+		std::ifstream file(GetCostDataPath(buildPath));
+		if (!file)
+			return;
+
+		// Each line holds "<name> <runs> <average seconds>", followed by "---" and the failed tests.
+		std::vector<std::string> failedTests;
+		bool isReadingFailures = false;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line == "---")
+			{
+				isReadingFailures = true;
+				continue;
+			}
+
+			if (isReadingFailures)
+			{
+				if (!line.empty())
+					failedTests.push_back(line);
+
+				continue;
+			}
+
+			std::istringstream stream(line);
+			std::string name;
+			uint32_t runs = 0;
+			double duration = 0.0;
+			if (stream >> name >> runs >> duration)
+			{
+				m_Durations[name] = duration;
+				m_Runs[name] = runs;
+			}
+		}
+
+		m_FailedTests = failedTests;
+	}
+
+	void TestHistory::WriteCostData(const std::filesystem::path& buildPath) const
+	{
+		if (m_Durations.empty() && m_FailedTests.empty())
+			return;
+
+		std::filesystem::path path = GetCostDataPath(buildPath);
+		std::filesystem::create_directories(path.parent_path());
+
+		std::ofstream file(path);
+		for (const auto& [name, duration] : m_Durations)
+			file << name << " " << m_Runs.at(name) << " " << duration << "\n";
+
+		file << "---\n";
+
+		for (const auto& name : m_FailedTests)
+			file << name << "\n";
+	}
+
+	std::vector<std::string> TestHistory::GetShard(std::vector<std::string> tests, uint32_t index,
+	                                               uint32_t count) const
+	{
+		if (count <= 1)
+			return tests;
+
+		// Tests without history are assumed to take as long as an average test.
+		double fallbackDuration = 1.0;
+		if (!m_Durations.empty())
+		{
+			fallbackDuration = std::accumulate(m_Durations.begin(), m_Durations.end(), 0.0,
+			                                   [](double sum, const auto& entry)
+			                                   {
+				                                   return sum + entry.second;
+			                                   }) / (double) m_Durations.size();
+		}
+
+		auto getDuration = [&](const std::string& name)
+		{
+			auto it = m_Durations.find(name);
+			return it != m_Durations.end() ? it->second : fallbackDuration;
+		};
+
+		// Longest processing time first: hand every test, longest first, to the currently shortest shard.
+		// Ties are broken by name, so the result doesn't depend on the input order.
+		std::sort(tests.begin(), tests.end(), [&](const std::string& a, const std::string& b)
+		{
+			double durationA = getDuration(a);
+			double durationB = getDuration(b);
+			return durationA != durationB ? durationA > durationB : a < b;
+		});
+
+		std::vector<double> shardDurations(count, 0.0);
+		std::vector<std::string> shard;
+
+		for (const auto& test : tests)
+		{
+			auto shortest = (uint32_t) (std::min_element(shardDurations.begin(), shardDurations.end()) -
+			                            shardDurations.begin());
+			shardDurations[shortest] += getDuration(test);
+
+			if (shortest == index)
+				shard.push_back(test);
+		}
+
+		return shard;
+	}
+
+	std::vector<std::pair<std::string, double>> TestHistory::GetSlowestTests(size_t count) const
+	{
+		std::vector<std::pair<std::string, double>> tests(m_Durations.begin(), m_Durations.end());
+		std::sort(tests.begin(), tests.end(), [](const auto& a, const auto& b)
+		{
+			return a.second > b.second;
+		});
+
+		if (tests.size() > count)
+			tests.resize(count);
+
+		return tests;
+	}
+
+	const std::vector<std::string>& TestHistory::GetFailedTests() const
+	{
+		return m_FailedTests;
+	}
+
+	std::filesystem::path TestHistory::GetCostDataPath(const std::filesystem::path& buildPath)
+	{
+		return buildPath / "Testing" / "Temporary" / "CTestCostData.txt";
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace MG
+{
+	// Durations and failures of previous test runs, kept in .magnet/testHistory.yaml so they survive
+	// cleaning the build folder and can be shared between machines.
+	class TestHistory
+	{
+	public:
+		static TestHistory Load();
+		void Save() const;
+
+		// Reads the results of the last run from the cost data CTest keeps in the build folder.
+		void ReadCostData(const std::filesystem::path& buildPath);
+
+		// Writes the history in CTest's cost data format, which makes CTest run previously failed tests first,
+		// followed by the longest ones.
+		void WriteCostData(const std::filesystem::path& buildPath) const;
+
+		// Splits the tests into the given number of shards with roughly equal total duration and returns the
+		// shard at the given 0-based index. Every machine computes the same split from the same history.
+		[[nodiscard]] std::vector<std::string> GetShard(std::vector<std::string> tests, uint32_t index,
+		                                                uint32_t count) const;
+
+		// Returns up to count tests with the longest average duration in seconds.
+		[[nodiscard]] std::vector<std::pair<std::string, double>> GetSlowestTests(size_t count) const;
+
+		[[nodiscard]] const std::vector<std::string>& GetFailedTests() const;
+
+	private:
+		static std::filesystem::path GetCostDataPath(const std::filesystem::path& buildPath);
+
+		std::map<std::string, double> m_Durations;
+		std::map<std::string, uint32_t> m_Runs;
+		std::vector<std::string> m_FailedTests;
+
+		static inline constexpr const char* s_HistoryPath = ".magnet/testHistory.yaml";
+	};
+}
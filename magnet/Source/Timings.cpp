@@ -0,0 +1,285 @@
+#include "Timings.h"
+
+#include "Core.h"
+#include "Event.h"
+#include "JsonWriter.h"
+
+namespace MG
+{
+	static bool s_IsEnabled = false;
+	static const auto s_StartTime = std::chrono::steady_clock::now();
+
+	static std::mutex s_EventsMutex;
+	static std::vector<TimingEvent> s_Events;
+
+	static std::string FormatMilliseconds(double microseconds)
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(microseconds < 10000.0 ? 2 : 0) << microseconds / 1000.0 << " ms";
+		return stream.str();
+	}
+
+	Timings::Scope::Scope(std::string name, std::string category, std::string detail)
+	{
+		if (!s_IsEnabled)
+			return;
+
+		m_Event.name = std::move(name);
+		m_Event.category = std::move(category);
+		m_Event.detail = std::move(detail);
+		m_Event.start = GetTime();
+		m_IsRunning = true;
+	}
+
+	Timings::Scope::~Scope()
+	{
+		Stop();
+	}
+
+	void Timings::Scope::Stop()
+	{
+		if (!m_IsRunning)
+			return;
+
+		m_IsRunning = false;
+		m_Event.duration = GetTime() - m_Event.start;
+		Add(m_Event);
+	}
+
+	void Timings::Enable()
+	{
+		s_IsEnabled = true;
+	}
+
+	bool Timings::IsEnabled()
+	{
+		return s_IsEnabled;
+	}
+
+	double Timings::GetTime()
+	{
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_StartTime).count();
+	}
+
+	void Timings::Record(const std::string& name, const std::string& category, const std::string& detail,
+	                     double start)
+	{
+		if (!s_IsEnabled)
+			return;
+
+		TimingEvent event;
+		event.name = name;
+		event.category = category;
+		event.detail = detail;
+		event.start = start;
+		event.duration = GetTime() - start;
+		Add(event);
+	}
+
+	void Timings::AddNinjaLog(const std::filesystem::path& path, uint64_t offset, double buildStart)
+	{
+		if (!s_IsEnabled)
+			return;
+
+		std::ifstream log(path);
+		if (!log)
+			return;
+
+		// Since ninja only appends to its log, the edges of this build follow the old end of the file.
+		// A rebuilt log starts over, with the header on its first line.
+		log.seekg(0, std::ios::end);
+		if ((uint64_t) log.tellg() < offset)
+			offset = 0;
+
+		log.seekg((std::streamoff) offset);
+
+		// Every line of format v5 and later is: start in ms, end in ms, mtime, output, command hash.
+		struct Edge
+		{
+			uint64_t start;
+			uint64_t end;
+			std::string output;
+		};
+
+		std::vector<Edge> edges;
+		std::string line;
+		while (std::getline(log, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream stream(line);
+			Edge edge {};
+			std::string mtime;
+			if (!(stream >> edge.start) || stream.get() != '\t' || !(stream >> edge.end) || stream.get() != '\t' ||
+			    !std::getline(stream, mtime, '\t') || !std::getline(stream, edge.output, '\t'))
+				continue;
+
+			edges.push_back(edge);
+		}
+
+		std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b)
+		{
+			return a.start < b.start;
+		});
+
+		// Every edge takes the first row that is free by its start, like the jobs that ran it.
+		std::vector<uint64_t> rowEnds;
+		for (const auto& edge : edges)
+		{
+			auto row = std::find_if(rowEnds.begin(), rowEnds.end(), [&edge](uint64_t end)
+			{
+				return end <= edge.start;
+			});
+
+			if (row == rowEnds.end())
+				row = rowEnds.insert(rowEnds.end(), 0);
+
+			*row = edge.end;
+
+			TimingEvent event;
+			event.name = std::filesystem::path(edge.output).filename().string();
+			event.category = "ninja";
+			event.detail = edge.output;
+			event.start = buildStart + (double) edge.start * 1000.0;
+			event.duration = (double) (edge.end - edge.start) * 1000.0;
+			event.row = 1 + (uint32_t) (row - rowEnds.begin());
+			Add(event);
+		}
+	}
+
+	void Timings::PrintSummary()
+	{
+		if (!s_IsEnabled)
+			return;
+
+		struct Total
+		{
+			std::string name;
+			uint32_t count = 0;
+			double duration = 0.0;
+		};
+
+		// Build edges are only summed up, since there are usually too many to list.
+		std::vector<Total> totals;
+		Total edges {"Build edges (sum)"};
+
+		{
+			std::lock_guard<std::mutex> lock(s_EventsMutex);
+			for (const auto& event : s_Events)
+			{
+				if (event.category == "ninja")
+				{
+					edges.count++;
+					edges.duration += event.duration;
+					continue;
+				}
+
+				auto total = std::find_if(totals.begin(), totals.end(), [&event](const Total& total)
+				{
+					return total.name == event.name;
+				});
+
+				if (total == totals.end())
+					total = totals.insert(totals.end(), {event.name});
+
+				total->count++;
+				total->duration += event.duration;
+			}
+		}
+
+		if (edges.count > 0)
+			totals.push_back(edges);
+
+		std::stable_sort(totals.begin(), totals.end(), [](const Total& a, const Total& b)
+		{
+			return a.duration > b.duration;
+		});
+
+		// Phases are nested, so their times include those of the phases within them.
+		MG_LOG("Timings of " + FormatMilliseconds(GetTime()) + " in total:");
+
+		std::ostringstream table;
+		table << std::left << std::setw(40) << "Phase" << std::right << std::setw(8) << "Count" << std::setw(14)
+		      << "Time";
+		MG_LOGNH(table.str());
+
+		for (const auto& total : totals)
+		{
+			std::ostringstream row;
+			row << std::left << std::setw(40) << total.name.substr(0, 39) << std::right << std::setw(8)
+			    << total.count << std::setw(14) << FormatMilliseconds(total.duration);
+			MG_LOGNH(row.str());
+		}
+	}
+
+	bool Timings::WriteChromeTrace(const std::filesystem::path& path)
+	{
+		std::vector<TimingEvent> events;
+		{
+			std::lock_guard<std::mutex> lock(s_EventsMutex);
+			events = s_Events;
+		}
+
+		uint32_t rowCount = 1;
+		for (const auto& event : events)
+			rowCount = std::max(rowCount, event.row + 1);
+
+		JsonWriter out;
+		out.BeginObject();
+		out.Key("traceEvents").BeginArray();
+
+		for (uint32_t row = 0; row < rowCount; row++)
+		{
+			out.BeginObject();
+			out.Key("name").String("thread_name");
+			out.Key("ph").String("M");
+			out.Key("pid").Number(1);
+			out.Key("tid").Number(row + 1);
+			out.Key("args").BeginObject();
+			out.Key("name").String(row == 0 ? "Magnet" : "Build " + std::to_string(row));
+			out.EndObject();
+			out.EndObject();
+		}
+
+		for (const auto& event : events)
+		{
+			out.BeginObject();
+			out.Key("name").String(event.name);
+			out.Key("cat").String(event.category);
+			out.Key("ph").String("X");
+			out.Key("ts").Number(event.start);
+			out.Key("dur").Number(event.duration);
+			out.Key("pid").Number(1);
+			out.Key("tid").Number(event.row + 1);
+
+			if (!event.detail.empty())
+			{
+				out.Key("args").BeginObject();
+				out.Key("detail").String(event.detail);
+				out.EndObject();
+			}
+
+			out.EndObject();
+		}
+
+		out.EndArray();
+		out.EndObject();
+
+		std::ofstream file(path);
+		file << out.GetString() << "\n";
+		return (bool) file;
+	}
+
+	void Timings::Add(const TimingEvent& event)
+	{
+		Event("phase").AddString("name", event.name)
+		              .AddString("category", event.category)
+		              .AddString("detail", event.detail)
+		              .AddNumber("start_ms", event.start / 1000.0)
+		              .AddNumber("duration_ms", event.duration / 1000.0).Emit();
+
+		std::lock_guard<std::mutex> lock(s_EventsMutex);
+		s_Events.push_back(event);
+	}
+}
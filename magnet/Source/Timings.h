@@ -0,0 +1,71 @@
+#pragma once
+
+namespace MG
+{
+	// A phase of Magnet itself, such as scanning the sources or running git.
+	struct TimingEvent
+	{
+		std::string name;
+
+		// What kind of phase it is: "phase", "file", "process" or "ninja".
+		std::string category;
+
+		// Shown in the trace only, e.g. the path of a file or a full command line.
+		std::string detail;
+
+		// In microseconds since Magnet started.
+		double start = 0.0;
+		double duration = 0.0;
+
+		// The row in the trace. Magnet's own phases are on row 0, nested by time. Build edges are spread over
+		// the rows after it, so that parallel edges don't overlap.
+		uint32_t row = 0;
+	};
+
+	// Records how long Magnet spends in every phase of a command, when `--timings` is passed.
+	// Everything is a no-op until Enable is called.
+	class Timings
+	{
+	public:
+		// Measures the time from its construction until Stop is called or it goes out of scope.
+		class Scope
+		{
+		public:
+			Scope(std::string name, std::string category = "phase", std::string detail = "");
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			void Stop();
+
+		private:
+			TimingEvent m_Event;
+			bool m_IsRunning = false;
+		};
+
+		static void Enable();
+		[[nodiscard]] static bool IsEnabled();
+
+		// Returns the current time in microseconds since Magnet started.
+		static double GetTime();
+
+		// Adds a phase that started at the given time and ends now.
+		static void Record(const std::string& name, const std::string& category, const std::string& detail,
+		                   double start);
+
+		// Adds the build edges ninja appended to its log after it had the given size in bytes, offset by the given
+		// start time of the build. Ninja logs its times relative to its own start, which is close enough.
+		static void AddNinjaLog(const std::filesystem::path& path, uint64_t offset, double buildStart);
+
+		// Prints the total time and count of every phase, longest first.
+		static void PrintSummary();
+
+		// Writes all phases and build edges as a Chrome trace, which Perfetto and chrome://tracing open.
+		// Returns whether the file could be written.
+		static bool WriteChromeTrace(const std::filesystem::path& path);
+
+	private:
+		static void Add(const TimingEvent& event);
+	};
+}
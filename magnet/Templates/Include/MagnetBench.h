@@ -0,0 +1,284 @@
+#pragma once
+
+// A minimal benchmark harness for the Benchmarks folder, for projects that don't use Google Benchmark.
+// Reports are written in Google Benchmark's JSON format, so `magnet bench` reads both the same way.
+//
+//     #include <MagnetBench.h>
+//
+//     MG_BENCHMARK(VectorPushBack)
+//     {
+//         while (state.KeepRunning())
+//         {
+//             std::vector<int> values;
+//             values.push_back(42);
+//             MagnetBench::DoNotOptimize(values.data());
+//         }
+//     }
+//
+//     MG_BENCHMARK_MAIN();
+//
+// Supported flags: --benchmark_filter=<regex>, --benchmark_min_time=<seconds>, --benchmark_out=<file>
+// and --benchmark_format=json. Other --benchmark_ flags are ignored.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MagnetBench
+{
+	// Keeps the compiler from optimizing away a value or the computation that produced it.
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static const void* volatile s_Sink;
+		s_Sink = &value;
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	// Measures a fixed number of iterations of a single benchmark.
+	class State
+	{
+	public:
+		explicit State(uint64_t iterations)
+				: m_Iterations(iterations), m_Remaining(iterations)
+		{
+		}
+
+		// Returns whether another iteration should run. The timer starts with the first call.
+		bool KeepRunning()
+		{
+			if (!m_IsRunning)
+			{
+				m_IsRunning = true;
+				m_CpuStart = std::clock();
+				m_Start = std::chrono::steady_clock::now();
+			}
+
+			if (m_Remaining > 0)
+			{
+				m_Remaining--;
+				return true;
+			}
+
+			auto end = std::chrono::steady_clock::now();
+			m_RealTime = std::chrono::duration<double, std::nano>(end - m_Start).count();
+			m_CpuTime = (double) (std::clock() - m_CpuStart) * 1e9 / CLOCKS_PER_SEC;
+			return false;
+		}
+
+		uint64_t GetIterations() const
+		{
+			return m_Iterations;
+		}
+
+		// Returns the total wall time of all iterations in nanoseconds.
+		double GetRealTime() const
+		{
+			return m_RealTime;
+		}
+
+		// Returns the total CPU time of all iterations in nanoseconds.
+		double GetCpuTime() const
+		{
+			return m_CpuTime;
+		}
+
+	private:
+		uint64_t m_Iterations;
+		uint64_t m_Remaining;
+		bool m_IsRunning = false;
+
+		std::chrono::steady_clock::time_point m_Start;
+		std::clock_t m_CpuStart = 0;
+		double m_RealTime = 0.0;
+		double m_CpuTime = 0.0;
+	};
+
+	using Function = void (*)(State&);
+
+	struct Benchmark
+	{
+		const char* name;
+		Function function;
+	};
+
+	inline std::vector<Benchmark>& GetBenchmarks()
+	{
+		static std::vector<Benchmark> s_Benchmarks;
+		return s_Benchmarks;
+	}
+
+	struct Registrar
+	{
+		Registrar(const char* name, Function function)
+		{
+			GetBenchmarks().push_back({name, function});
+		}
+	};
+
+	struct Result
+	{
+		std::string name;
+		uint64_t iterations;
+		double realTime;
+		double cpuTime;
+	};
+
+	// Runs the benchmark with more and more iterations until a run takes at least minTime seconds.
+	inline Result Measure(const Benchmark& benchmark, double minTime)
+	{
+		uint64_t iterations = 1;
+		while (true)
+		{
+			State state(iterations);
+			benchmark.function(state);
+
+			double seconds = state.GetRealTime() / 1e9;
+			if (seconds >= minTime || iterations >= 1000000000)
+			{
+				return {benchmark.name, iterations, state.GetRealTime() / (double) iterations,
+				        state.GetCpuTime() / (double) iterations};
+			}
+
+			// Aim slightly above the minimum, but grow at most tenfold since short runs are imprecise.
+			double factor = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+			factor = factor < 10.0 ? factor : 10.0;
+			auto next = (uint64_t) ((double) iterations * factor);
+			iterations = next > iterations ? next : iterations + 1;
+		}
+	}
+
+	inline std::string ToJson(const std::vector<Result>& results)
+	{
+		auto escape = [](const std::string& string)
+		{
+			std::string escaped;
+			for (char c : string)
+			{
+				if (c == '"' || c == '\\')
+					escaped += '\\';
+				escaped += c;
+			}
+			return escaped;
+		};
+
+		std::ostringstream json;
+		json.precision(17);
+
+		json << "{\n  \"context\": {\n";
+		json << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+		json << "    \"library_build_type\": \"release\"\n";
+#else
+		json << "    \"library_build_type\": \"debug\"\n";
+#endif
+		json << "  },\n  \"benchmarks\": [";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			json << (i == 0 ? "\n" : ",\n");
+			json << "    {\"name\": \"" << escape(result.name) << "\", \"run_type\": \"iteration\", "
+			     << "\"iterations\": " << result.iterations << ", \"real_time\": " << result.realTime
+			     << ", \"cpu_time\": " << result.cpuTime << ", \"time_unit\": \"ns\"}";
+		}
+
+		json << "\n  ]\n}\n";
+		return json.str();
+	}
+
+	inline int Run(int argc, char** argv)
+	{
+		std::string filter = ".";
+		std::string outPath;
+		std::string format = "console";
+		double minTime = 0.5;
+
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			auto getValue = [&argument](const std::string& flag, std::string& value)
+			{
+				if (argument.rfind(flag + "=", 0) != 0)
+					return false;
+
+				value = argument.substr(flag.size() + 1);
+				return true;
+			};
+
+			std::string value;
+			if (getValue("--benchmark_filter", value))
+				filter = value;
+			else if (getValue("--benchmark_out", value))
+				outPath = value;
+			else if (getValue("--benchmark_format", value))
+				format = value;
+			else if (getValue("--benchmark_min_time", value))
+				minTime = std::stod(value);
+		}
+
+		std::regex pattern(filter);
+		std::vector<Result> results;
+
+		if (format != "json")
+			std::printf("%-40s %15s %15s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+
+		for (const auto& benchmark : GetBenchmarks())
+		{
+			if (!std::regex_search(benchmark.name, pattern))
+				continue;
+
+			Result result = Measure(benchmark, minTime);
+			results.push_back(result);
+
+			if (format != "json")
+			{
+				std::printf("%-40s %15.2f %15.2f %12llu\n", result.name.c_str(), result.realTime, result.cpuTime,
+				            (unsigned long long) result.iterations);
+				std::fflush(stdout);
+			}
+		}
+
+		std::string json = ToJson(results);
+		if (format == "json")
+			std::cout << json;
+
+		if (!outPath.empty())
+		{
+			std::ofstream file(outPath);
+			file << json;
+			if (!file)
+			{
+				std::fprintf(stderr, "Failed to write %s\n", outPath.c_str());
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+}
+
+// Defines a benchmark. The body receives a MagnetBench::State named `state`.
+#define MG_BENCHMARK(name) \
+	static void name(::MagnetBench::State& state); \
+	static ::MagnetBench::Registrar s_MagnetBenchRegistrar_##name(#name, name); \
+	static void name(::MagnetBench::State& state)
+
+// Defines main(), which runs all benchmarks. Use it in exactly one file per benchmark executable.
+#define MG_BENCHMARK_MAIN() \
+	int main(int argc, char** argv) \
+	{ \
+		return ::MagnetBench::Run(argc, argv); \
+	} \
+	static_assert(true, "")
@@ -0,0 +1,288 @@
+#pragma once
+
+// A minimal tracing API for hot paths, which `magnet new` copies into the Source folder of new projects.
+// Zones, counters and frame marks are written to a ring buffer per thread without any locks. When the program
+// exits, all buffers are written as a Chrome trace to the file named by the MAGNET_TRACE environment variable,
+// which `magnet go --trace` sets. Perfetto (https://ui.perfetto.dev) and chrome://tracing open it.
+//
+//     void Update()
+//     {
+//         MG_TRACE_FUNCTION();
+//
+//         {
+//             MG_TRACE_SCOPE("Physics");
+//             StepPhysics();
+//         }
+//
+//         MG_TRACE_COUNTER("Entities", entities.size());
+//         MG_TRACE_FRAME();
+//     }
+//
+// Everything compiles to nothing unless MG_TRACING is defined as 1, which Magnet does in the configurations listed
+// under `tracing` in config.yaml. Names must be string literals, since only pointers to them are kept.
+
+#if defined(MG_TRACING) && MG_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace MagnetTrace
+{
+	enum class EventType : uint8_t
+	{
+		Zone,
+		Counter,
+		Frame
+	};
+
+	struct Event
+	{
+		const char* name;
+
+		// In nanoseconds of the steady clock.
+		uint64_t timestamp;
+
+		union
+		{
+			uint64_t duration;
+			double value;
+		};
+
+		EventType type;
+	};
+
+	// Events per thread. Once a buffer is full, the oldest events are overwritten.
+	static const uint64_t s_BufferSize = 1 << 15;
+
+	// Only its own thread writes to a buffer. Buffers are never freed, so that those of finished threads can still
+	// be written at exit.
+	struct Buffer
+	{
+		Event events[s_BufferSize];
+
+		// Number of events written so far, including overwritten ones.
+		std::atomic<uint64_t> count{0};
+
+		uint32_t threadId = 0;
+		Buffer* next = nullptr;
+	};
+
+	inline uint64_t Now()
+	{
+		return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Returns the most recently created buffer, which links to all others.
+	inline std::atomic<Buffer*>& GetBuffers()
+	{
+		static std::atomic<Buffer*> s_Buffers{nullptr};
+		return s_Buffers;
+	}
+
+	inline void WriteString(std::FILE* file, const char* string)
+	{
+		std::fputc('"', file);
+		for (const char* c = string; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				std::fputc('\\', file);
+
+			if ((unsigned char) *c >= 0x20)
+				std::fputc(*c, file);
+		}
+
+		std::fputc('"', file);
+	}
+
+	// Writes the events of all threads as a Chrome trace. Returns whether the file could be written.
+	inline bool WriteChromeTrace(const char* path)
+	{
+		std::FILE* file = std::fopen(path, "w");
+		if (!file)
+			return false;
+
+		// Times start at the earliest event, since zones that began before the first buffer was created, such as
+		// one around main, are only written when they end.
+		uint64_t startTime = UINT64_MAX;
+		for (Buffer* buffer = GetBuffers().load(std::memory_order_acquire); buffer; buffer = buffer->next)
+		{
+			uint64_t count = buffer->count.load(std::memory_order_acquire);
+			for (uint64_t i = count > s_BufferSize ? count - s_BufferSize : 0; i < count; i++)
+			{
+				if (buffer->events[i % s_BufferSize].timestamp < startTime)
+					startTime = buffer->events[i % s_BufferSize].timestamp;
+			}
+		}
+
+		std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+
+		bool isFirst = true;
+		uint64_t overwritten = 0;
+		for (Buffer* buffer = GetBuffers().load(std::memory_order_acquire); buffer; buffer = buffer->next)
+		{
+			uint64_t count = buffer->count.load(std::memory_order_acquire);
+			uint64_t first = count > s_BufferSize ? count - s_BufferSize : 0;
+			overwritten += first;
+
+			for (uint64_t i = first; i < count; i++)
+			{
+				const Event& event = buffer->events[i % s_BufferSize];
+				double timestamp = (double) (event.timestamp - startTime) / 1000.0;
+
+				std::fputs(isFirst ? "{\"name\":" : ",\n{\"name\":", file);
+				WriteString(file, event.name);
+				isFirst = false;
+
+				switch (event.type)
+				{
+					case EventType::Zone:
+						std::fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", timestamp,
+						             (double) event.duration / 1000.0);
+						break;
+					case EventType::Counter:
+						std::fprintf(file, ",\"ph\":\"C\",\"ts\":%.3f,\"args\":{\"value\":%.17g}", timestamp,
+						             event.value);
+						break;
+					case EventType::Frame:
+						std::fprintf(file, ",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f", timestamp);
+						break;
+				}
+
+				std::fprintf(file, ",\"pid\":1,\"tid\":%u}", buffer->threadId);
+			}
+		}
+
+		std::fputs("\n]}\n", file);
+		bool isWritten = std::fclose(file) == 0;
+
+		if (overwritten > 0)
+			std::fprintf(stderr, "MagnetTrace: %llu of the oldest events were overwritten.\n",
+			             (unsigned long long) overwritten);
+
+		return isWritten;
+	}
+
+	// Writes the trace when the program exits, if MAGNET_TRACE is set.
+	struct Session
+	{
+		~Session()
+		{
+			const char* path = std::getenv("MAGNET_TRACE");
+			if (path && *path && !WriteChromeTrace(path))
+				std::fprintf(stderr, "MagnetTrace: Failed to write %s.\n", path);
+		}
+	};
+
+	inline Session& GetSession()
+	{
+		static Session s_Session;
+		return s_Session;
+	}
+
+	inline Buffer* CreateBuffer()
+	{
+		static std::atomic<uint32_t> s_NextThreadId{1};
+
+		// Makes sure the session outlives the buffer, so that its events are written at exit.
+		GetSession();
+
+		Buffer* buffer = new Buffer();
+		buffer->threadId = s_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+		std::atomic<Buffer*>& buffers = GetBuffers();
+		buffer->next = buffers.load(std::memory_order_relaxed);
+		while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+		                                      std::memory_order_relaxed))
+		{
+		}
+
+		return buffer;
+	}
+
+	inline void Write(const Event& event)
+	{
+		static thread_local Buffer* t_Buffer = nullptr;
+		if (!t_Buffer)
+			t_Buffer = CreateBuffer();
+
+		// Release, so that the event is complete before it's counted.
+		uint64_t count = t_Buffer->count.load(std::memory_order_relaxed);
+		t_Buffer->events[count % s_BufferSize] = event;
+		t_Buffer->count.store(count + 1, std::memory_order_release);
+	}
+
+	// Measures the time until it goes out of scope.
+	class Zone
+	{
+	public:
+		explicit Zone(const char* name)
+				: m_Name(name), m_Start(Now())
+		{
+		}
+
+		~Zone()
+		{
+			Event event;
+			event.name = m_Name;
+			event.timestamp = m_Start;
+			event.duration = Now() - m_Start;
+			event.type = EventType::Zone;
+			Write(event);
+		}
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+	inline void WriteCounter(const char* name, double value)
+	{
+		Event event;
+		event.name = name;
+		event.timestamp = Now();
+		event.value = value;
+		event.type = EventType::Counter;
+		Write(event);
+	}
+
+	inline void WriteFrame()
+	{
+		Event event;
+		event.name = "Frame";
+		event.timestamp = Now();
+		event.duration = 0;
+		event.type = EventType::Frame;
+		Write(event);
+	}
+}
+
+#define MG_TRACE_CONCAT_INNER(a, b) a##b
+#define MG_TRACE_CONCAT(a, b) MG_TRACE_CONCAT_INNER(a, b)
+
+// Measures the enclosing scope.
+#define MG_TRACE_SCOPE(name) ::MagnetTrace::Zone MG_TRACE_CONCAT(s_MagnetTraceZone, __LINE__)(name)
+
+// Measures the enclosing function, named after it.
+#define MG_TRACE_FUNCTION() MG_TRACE_SCOPE(__func__)
+
+// Records the value of a counter, which is shown as a graph over time.
+#define MG_TRACE_COUNTER(name, value) ::MagnetTrace::WriteCounter(name, (double) (value))
+
+// Marks the end of a frame, e.g. of a game loop.
+#define MG_TRACE_FRAME() ::MagnetTrace::WriteFrame()
+
+#else
+
+#define MG_TRACE_SCOPE(name) static_cast<void>(0)
+#define MG_TRACE_FUNCTION() static_cast<void>(0)
+#define MG_TRACE_COUNTER(name, value) static_cast<void>(0)
+#define MG_TRACE_FRAME() static_cast<void>(0)
+
+#endif